@@ -0,0 +1,108 @@
+#include "order_generator.h"
+#include "../includes/columnar_archive.h"
+#include "../includes/database.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Compares ten years of generated history in SQLite and in a columnar archive.
+//
+//   columnar_archive_bench [SEED_DB] [ORDER_COUNT]
+//
+// Prints both file sizes, the time to write the archive, and the time of revenue and
+// flower usage queries over a month and over the whole history from each.
+
+using Clock = std::chrono::steady_clock;
+
+static const char* BENCH_DB_PATH = "columnar_archive_bench.db";
+static const char* BENCH_ARCHIVE_PATH = "columnar_archive_bench.col";
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static size_t fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<size_t>(file.tellg()) : 0;
+}
+
+int main(int argc, char** argv) {
+    std::string seedPath = argc > 1 ? argv[1] : "flower.db";
+    GeneratorConfig config;
+    config.orderCount = argc > 2 ? std::stoi(argv[2]) : 2000000;
+    config.dayCount = 10 * 365;
+
+    std::remove(BENCH_DB_PATH);
+    if (!generateShopDatabase(seedPath, BENCH_DB_PATH, config)) {
+        return 1;
+    }
+    int firstDay = config.firstDay;
+    int lastDay = config.firstDay + config.dayCount - 1;
+
+    std::cout << std::fixed << std::setprecision(1);
+    auto start = Clock::now();
+    if (!ColumnarArchive::write(BENCH_DB_PATH, firstDay, lastDay, BENCH_ARCHIVE_PATH)) {
+        return 1;
+    }
+    std::cout << "write " << config.orderCount << " orders: " << millisecondsSince(start) << " ms\n";
+
+    Database db(BENCH_DB_PATH);
+    ColumnarArchive archive;
+    if (!db.connect() || !archive.open(BENCH_ARCHIVE_PATH)) {
+        return 1;
+    }
+    db.setReportCacheBudget(0);
+    size_t sqliteSize = fileSize(BENCH_DB_PATH);
+    std::cout << "sqlite: " << sqliteSize / 1e6 << " MB, columnar: " << archive.getFileSize() / 1e6 << " MB ("
+              << archive.getBlockCount() << " blocks, " << std::setprecision(2)
+              << static_cast<double>(archive.getFileSize()) / archive.getOrderCount() << " bytes/order, "
+              << static_cast<double>(sqliteSize) / archive.getFileSize() << "x smaller)\n"
+              << std::setprecision(1);
+
+    auto recipes = db.getRecipeLines();
+    auto flowers = db.getAllFlowers();
+    struct Range {
+        const char* name;
+        int start;
+        int end;
+    };
+    for (const Range& range : {Range{"month", firstDay + 1000, firstDay + 1030}, Range{"all", firstDay, lastDay}}) {
+        start = Clock::now();
+        double revenue = db.getTotalRevenue(range.start, range.end);
+        double sqliteRevenueMs = millisecondsSince(start);
+        start = Clock::now();
+        double archiveRevenue = archive.getTotalRevenue(range.start, range.end);
+        double archiveRevenueMs = millisecondsSince(start);
+
+        start = Clock::now();
+        auto usage = db.getFlowerUsageByPeriod(range.start, range.end);
+        double sqliteUsageMs = millisecondsSince(start);
+        start = Clock::now();
+        auto archiveUsage = archive.getFlowerUsageByPeriod(range.start, range.end, recipes, flowers);
+        double archiveUsageMs = millisecondsSince(start);
+
+        std::cout << range.name << " revenue: sqlite " << sqliteRevenueMs << " ms, columnar " << archiveRevenueMs
+                  << " ms (" << (std::abs(revenue - archiveRevenue) < 1e-3 * revenue + 1e-6 ? "same" : "DIFFERENT")
+                  << ")\n"
+                  << range.name << " flower usage: sqlite " << sqliteUsageMs << " ms, columnar " << archiveUsageMs
+                  << " ms (" << (usage == archiveUsage ? "same" : "DIFFERENT") << ")\n";
+    }
+
+    // Decoding every column of every block, the cost of a query that cannot use the index
+    start = Clock::now();
+    double total = 0.0;
+    archive.forEachOrder(firstDay, lastDay, [&](const Database::Order&, double price) { total += price; });
+    double scanMs = millisecondsSince(start);
+    std::cout << "full decode: " << scanMs << " ms (" << archive.getOrderCount() / scanMs / 1000.0
+              << " M orders/s, " << archive.getFileSize() / scanMs / 1000.0 << " MB/s of file)\n";
+
+    db.disconnect();
+    archive.close();
+    std::remove(BENCH_DB_PATH);
+    std::remove(BENCH_ARCHIVE_PATH);
+    return 0;
+}
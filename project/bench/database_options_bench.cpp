@@ -0,0 +1,135 @@
+#include "order_generator.h"
+#include "../includes/database.h"
+#include "../includes/database_options.h"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Measures how each DatabaseOptions setting affects order entry and the report queries.
+//
+//   database_options_bench [SEED_DB] [ORDER_COUNT]
+//
+// Every variant runs on a fresh copy of the same generated database with the report
+// cache disabled, so the numbers reflect SQLite work only.
+
+using Clock = std::chrono::steady_clock;
+
+struct Variant {
+    std::string name;
+    DatabaseOptions options;
+};
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double timeIt(int repetitions, const std::function<void(int)>& body) {
+    auto start = Clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        body(i);
+    }
+    return millisecondsSince(start) / repetitions;
+}
+
+static void removeDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+    std::remove((path + "-journal").c_str());
+}
+
+int main(int argc, char** argv) {
+    std::string seedPath = argc > 1 ? argv[1] : "flower.db";
+    GeneratorConfig config;
+    config.orderCount = argc > 2 ? std::stoi(argv[2]) : 200000;
+    const int insertCount = 1000;
+
+    std::vector<Variant> variants;
+    auto add = [&](const std::string& name, const std::function<void(DatabaseOptions&)>& change) {
+        Variant variant{name, DatabaseOptions()};
+        change(variant.options);
+        variants.push_back(variant);
+    };
+    add("default", [](DatabaseOptions&) {});
+    add("page_size=8192", [](DatabaseOptions& o) { o.pageSize = 8192; });
+    add("page_size=16384", [](DatabaseOptions& o) { o.pageSize = 16384; });
+    add("cache_size=64MiB", [](DatabaseOptions& o) { o.cacheSizeKiB = 64 * 1024; });
+    add("mmap_size=256MiB", [](DatabaseOptions& o) { o.mmapSize = 256LL * 1024 * 1024; });
+    add("synchronous=OFF", [](DatabaseOptions& o) { o.synchronous = "OFF"; });
+    add("synchronous=NORMAL", [](DatabaseOptions& o) { o.synchronous = "NORMAL"; });
+    add("temp_store=MEMORY", [](DatabaseOptions& o) { o.tempStore = "MEMORY"; });
+    add("journal_mode=WAL", [](DatabaseOptions& o) { o.journalMode = "WAL"; });
+    add("WAL+synchronous=NORMAL", [](DatabaseOptions& o) { o.journalMode = "WAL"; o.synchronous = "NORMAL"; });
+    variants.push_back({"preset counter_terminal", DatabaseOptions::counterTerminal()});
+    variants.push_back({"preset reporting_server", DatabaseOptions::reportingServer()});
+
+    // One generated database per page size; the other variants start from copies
+    std::map<int, std::string> generated;
+    for (const auto& variant : variants) {
+        int pageSize = variant.options.pageSize;
+        if (generated.count(pageSize)) {
+            continue;
+        }
+        std::string path = "bench_base_" + std::to_string(pageSize) + ".db";
+        config.pageSize = pageSize;
+        std::cout << "Generating " << config.orderCount << " orders (page_size "
+                  << (pageSize ? std::to_string(pageSize) : "default") << ")..." << std::endl;
+        if (!generateShopDatabase(seedPath, path, config)) {
+            return 1;
+        }
+        generated[pageSize] = path;
+    }
+
+    const int lastDay = config.firstDay + config.dayCount - 1;
+    std::cout << "\n" << std::left << std::setw(26) << "variant" << std::right
+              << std::setw(14) << "orders/s" << std::setw(14) << "range ms"
+              << std::setw(14) << "revenue ms" << std::setw(14) << "usage ms" << "\n"
+              << std::string(82, '-') << std::endl;
+
+    for (const auto& variant : variants) {
+        const std::string path = "bench_work.db";
+        removeDatabase(path);
+        copyFile(generated[variant.options.pageSize], path);
+
+        Database db(path, variant.options);
+        if (!db.connect()) {
+            return 1;
+        }
+        db.setReportCacheBudget(0);
+
+        double insertMs = timeIt(insertCount, [&](int i) {
+            int orderDate = lastDay + 1 + i % 30;
+            db.createOrder(1 + i % 10, 1 + i % 5, orderDate, orderDate + 3, 1);
+        });
+        double rangeMs = timeIt(50, [&](int i) {
+            int start = config.firstDay + (i * 97) % (config.dayCount - 30);
+            db.getOrdersByDateRange(start, start + 30);
+        });
+        double revenueMs = timeIt(10, [&](int i) {
+            int start = config.firstDay + (i * 131) % (config.dayCount - 365);
+            db.getTotalRevenue(start, start + 365);
+        });
+        double usageMs = timeIt(10, [&](int i) {
+            int start = config.firstDay + (i * 61) % (config.dayCount - 90);
+            db.getFlowerUsageByPeriod(start, start + 90);
+        });
+
+        std::cout << std::left << std::setw(26) << variant.name << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(14) << 1000.0 / insertMs
+                  << std::setprecision(3) << std::setw(14) << rangeMs << std::setw(14) << revenueMs
+                  << std::setw(14) << usageMs << std::endl;
+
+        db.disconnect();
+        removeDatabase(path);
+    }
+
+    for (const auto& entry : generated) {
+        removeDatabase(entry.second);
+    }
+    return 0;
+}
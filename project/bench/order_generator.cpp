@@ -0,0 +1,132 @@
+#include "order_generator.h"
+#include "../includes/database.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sqlite3.h>
+#include <vector>
+
+bool copyFile(const std::string& from, const std::string& to) {
+    std::ifstream src(from, std::ios::binary);
+    std::ofstream dst(to, std::ios::binary | std::ios::trunc);
+    if (!src || !dst) {
+        return false;
+    }
+    dst << src.rdbuf();
+    return static_cast<bool>(dst);
+}
+
+static bool exec(sqlite3* db, const std::string& sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Generator SQL error: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+static std::vector<int> loadIds(sqlite3* db, const char* sql) {
+    std::vector<int> ids;
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ids.push_back(sqlite3_column_int(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return ids;
+}
+
+bool generateShopDatabase(const std::string& seedPath, const std::string& outputPath,
+                          const GeneratorConfig& config) {
+    std::remove(outputPath.c_str());
+    if (!copyFile(seedPath, outputPath)) {
+        std::cerr << "Can't copy " << seedPath << " to " << outputPath << std::endl;
+        return false;
+    }
+
+    sqlite3* db = nullptr;
+    if (config.pageSize > 0) {
+        if (sqlite3_open(outputPath.c_str(), &db) != SQLITE_OK ||
+            !exec(db, "PRAGMA page_size = " + std::to_string(config.pageSize) + "; VACUUM;")) {
+            sqlite3_close(db);
+            return false;
+        }
+        sqlite3_close(db);
+    }
+
+    // Let Database bring the schema up to date before bulk loading
+    {
+        Database migrated(outputPath);
+        if (!migrated.connect()) {
+            return false;
+        }
+    }
+
+    if (sqlite3_open(outputPath.c_str(), &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+    if (!exec(db, "PRAGMA synchronous = OFF; BEGIN;")) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    std::mt19937 random(config.seed);
+    bool ok = true;
+
+    sqlite3_stmt* insertCustomer = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO Customers (CustomerName, PhoneNumber, Email) VALUES (?, ?, ?)",
+                       -1, &insertCustomer, nullptr);
+    for (int i = 0; ok && i < config.customerCount; i++) {
+        std::string name = "Customer " + std::to_string(i);
+        std::string phone = "+7(900)" + std::to_string(1000000 + random() % 9000000);
+        std::string email = "customer" + std::to_string(i) + "@example.com";
+        sqlite3_bind_text(insertCustomer, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insertCustomer, 2, phone.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insertCustomer, 3, email.c_str(), -1, SQLITE_TRANSIENT);
+        ok = sqlite3_step(insertCustomer) == SQLITE_DONE;
+        sqlite3_reset(insertCustomer);
+    }
+    sqlite3_finalize(insertCustomer);
+
+    std::vector<int> customers = loadIds(db, "SELECT CustomerID FROM Customers");
+    std::vector<int> compositions = loadIds(db, "SELECT CompositionID FROM CompositionUnitCost");
+    if (customers.empty() || compositions.empty()) {
+        std::cerr << "Seed database has no customers or priced compositions" << std::endl;
+        ok = false;
+    }
+
+    sqlite3_stmt* insertOrder = nullptr;
+    sqlite3_prepare_v2(db,
+                       "INSERT INTO Orders (CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate) "
+                       "VALUES (?, ?, ?, ?, ?, ?)",
+                       -1, &insertOrder, nullptr);
+    for (int i = 0; ok && i < config.orderCount; i++) {
+        int orderDate = config.firstDay + static_cast<int>(static_cast<long long>(i) * config.dayCount / config.orderCount);
+        int fulfillmentDate = orderDate + static_cast<int>(random() % 7);
+        sqlite3_bind_int(insertOrder, 1, customers[random() % customers.size()]);
+        sqlite3_bind_int(insertOrder, 2, compositions[random() % compositions.size()]);
+        sqlite3_bind_int(insertOrder, 3, orderDate);
+        sqlite3_bind_int(insertOrder, 4, fulfillmentDate);
+        sqlite3_bind_int(insertOrder, 5, 1 + static_cast<int>(random() % 5));
+        sqlite3_bind_double(insertOrder, 6, Database::urgencyRateFor(orderDate, fulfillmentDate));
+        ok = sqlite3_step(insertOrder) == SQLITE_DONE;
+        sqlite3_reset(insertOrder);
+    }
+    sqlite3_finalize(insertOrder);
+
+    ok = ok && exec(db, "COMMIT;");
+    if (!ok) {
+        std::cerr << "Generating " << outputPath << " failed: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_close(db);
+
+    // Fold the bulk-loaded orders into the composition sales aggregate
+    if (ok) {
+        Database loaded(outputPath);
+        ok = loaded.connect() && loaded.refreshCompositionSales();
+    }
+    return ok;
+}
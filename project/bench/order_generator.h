@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// Builds synthetic shop databases for benchmarks and performance tests: the catalog
+// (flowers, compositions, recipes) of a seed database plus generated customers and
+// orders. Orders are inserted in date order through the regular triggers, so
+// OrderSummary is priced exactly as createOrder would price it.
+struct GeneratorConfig {
+    int orderCount = 100000;
+    int customerCount = 1000;
+    int firstDay = 18628;    // 2021-01-01
+    int dayCount = 4 * 365;  // orders are spread evenly over this many days
+    int pageSize = 0;        // rebuild the copy with this page size first; 0 keeps the seed's
+    unsigned seed = 42;
+};
+
+bool generateShopDatabase(const std::string& seedPath, const std::string& outputPath,
+                          const GeneratorConfig& config);
+
+bool copyFile(const std::string& from, const std::string& to);
@@ -0,0 +1,88 @@
+#include "../includes/authentication.h"
+#include "../includes/password_hash.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures password hashing cost and login latency when many terminals log in at once.
+//
+//   password_hash_bench [TARGET_MS] [TERMINALS]
+//
+// Prints the time of one evaluation per cost level, the cost that calibrate() picks for
+// TARGET_MS, and login latency percentiles for TERMINALS simultaneous logins under
+// several concurrency limits.
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double percentile(std::vector<double> values, double fraction) {
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    return values[index];
+}
+
+int main(int argc, char** argv) {
+    double targetMs = argc > 1 ? std::stod(argv[1]) : 50.0;
+    int terminals = argc > 2 ? std::stoi(argv[2]) : 32;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "logN  memory(MiB)  ms/hash\n";
+    for (int logN = 10; logN <= 16; logN++) {
+        PasswordHashParams params;
+        params.logN = logN;
+        std::vector<double> samples;
+        std::vector<uint8_t> key;
+        for (int i = 0; i < 5; i++) {
+            auto start = Clock::now();
+            PasswordHasher::scrypt("password", "salt", params, 32, key);
+            samples.push_back(millisecondsSince(start));
+        }
+        std::cout << std::setw(4) << logN << std::setw(13) << params.memoryBytes() / 1048576.0
+                  << std::setw(9) << percentile(samples, 0.5) << "\n";
+    }
+
+    auto start = Clock::now();
+    PasswordHashParams calibrated = PasswordHasher::calibrate(targetMs);
+    std::cout << "\ncalibrate(" << targetMs << " ms) -> ln=" << calibrated.logN << ",r=" << calibrated.r
+              << ",p=" << calibrated.p << " in " << millisecondsSince(start) << " ms\n";
+
+    // Shift change: every terminal logs in at the same moment
+    size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\n" << terminals << " simultaneous logins\n"
+              << "limit  p50(ms)  p95(ms)  max(ms)  wall(ms)  peak memory(MiB)\n";
+    for (size_t limit : {size_t(1), hardwareThreads, static_cast<size_t>(terminals)}) {
+        Authentication auth(calibrated, limit);
+        for (int i = 0; i < terminals; i++) {
+            auth.registerUser("clerk" + std::to_string(i), "pass" + std::to_string(i), "user");
+        }
+
+        std::vector<double> latencies(terminals);
+        std::vector<std::thread> threads;
+        auto wallStart = Clock::now();
+        for (int i = 0; i < terminals; i++) {
+            threads.emplace_back([&, i] {
+                std::string role;
+                auto loginStart = Clock::now();
+                auth.verifyCredentials("clerk" + std::to_string(i), "pass" + std::to_string(i), role);
+                latencies[i] = millisecondsSince(loginStart);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double wallMs = millisecondsSince(wallStart);
+
+        std::cout << std::setw(5) << limit << std::setw(9) << percentile(latencies, 0.5) << std::setw(9)
+                  << percentile(latencies, 0.95) << std::setw(9) << percentile(latencies, 1.0) << std::setw(10)
+                  << wallMs << std::setw(18) << std::min(limit, size_t(terminals)) * calibrated.memoryBytes() / 1048576.0 << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "order_generator.h"
+#include "../includes/database.h"
+#include "../includes/repricing_simulator.h"
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures what-if repricing over a year of generated orders.
+//
+//   repricing_bench [SEED_DB] [ORDER_COUNT] [SCENARIOS]
+//
+// Prints the time to load the period, the rate of scenario evaluation per worker count,
+// and for comparison one scenario priced order by order through the recipes.
+
+using Clock = std::chrono::steady_clock;
+
+static const char* BENCH_DB_PATH = "repricing_bench.db";
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    std::string seedPath = argc > 1 ? argv[1] : "flower.db";
+    GeneratorConfig config;
+    config.orderCount = argc > 2 ? std::stoi(argv[2]) : 200000;
+    size_t scenarioCount = argc > 3 ? std::stoul(argv[3]) : 10000;
+
+    std::remove(BENCH_DB_PATH);
+    if (!generateShopDatabase(seedPath, BENCH_DB_PATH, config)) {
+        return 1;
+    }
+    Database db(BENCH_DB_PATH);
+    if (!db.connect()) {
+        return 1;
+    }
+    int startDate = config.firstDay;
+    int endDate = config.firstDay + 364;
+
+    std::cout << std::fixed << std::setprecision(1);
+    auto start = Clock::now();
+    RepricingSimulator simulator(db);
+    simulator.load(startDate, endDate);
+    std::cout << "load one year of " << config.orderCount << " orders: " << millisecondsSince(start) << " ms\n";
+
+    // Every flower moves independently by up to 15% either way
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> change(0.85, 1.15);
+    std::vector<std::vector<double>> scenarios(scenarioCount, simulator.currentPrices());
+    for (auto& prices : scenarios) {
+        for (double& price : prices) {
+            price *= change(random);
+        }
+    }
+
+    std::vector<RepricingSimulator::Outcome> outcomes;
+    for (size_t workers : {1, 2, 4, 8}) {
+        RepricingSimulator parallel(db, workers);
+        parallel.load(startDate, endDate);
+        start = Clock::now();
+        parallel.evaluate(scenarios, outcomes);
+        double elapsed = millisecondsSince(start);
+        std::cout << workers << " workers: " << scenarioCount << " scenarios in " << elapsed << " ms ("
+                  << scenarioCount * 1000.0 / elapsed << " scenarios/s)\n";
+    }
+
+    // The same first scenario, pricing every order through its recipe
+    start = Clock::now();
+    std::map<int, double> price;
+    for (size_t i = 0; i < simulator.flowerIds().size(); i++) {
+        price[simulator.flowerIds()[i]] = scenarios[0][i];
+    }
+    std::map<int, double> unitCost;
+    for (const auto& line : db.getRecipeLines()) {
+        unitCost[line.compositionId] += line.quantity * price[line.flowerId];
+    }
+    double total = 0.0;
+    for (const auto& order : db.getOrdersByDateRange(startDate, endDate)) {
+        total += unitCost[order.compositionId] * order.quantity * (1.0 + order.urgencyRate);
+    }
+    std::cout << "order by order, one scenario: " << millisecondsSince(start) << " ms (total " << total
+              << " vs " << outcomes[0].totalRevenue << ")\n";
+
+    db.disconnect();
+    std::remove(BENCH_DB_PATH);
+    return 0;
+}
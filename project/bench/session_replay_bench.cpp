@@ -0,0 +1,68 @@
+#include "../includes/database.h"
+#include "../includes/session_replay.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Replays recorded clerk sessions concurrently against a copy of a database.
+//
+//   session_replay_bench SEED_DB SCRIPT... [--sessions N] [--concurrency N]
+//
+// Scripts are recorded with flower_shop --record FILE (bench/scripts has an example).
+// Orders entered by the scripts go into the copy, never into SEED_DB.
+
+static const char* REPLAY_DB_PATH = "session_replay_bench.db";
+
+static void removeDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+    std::remove((path + "-journal").c_str());
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: session_replay_bench SEED_DB SCRIPT... [--sessions N] [--concurrency N]\n";
+        return 1;
+    }
+
+    SessionReplay::Options options;
+    std::vector<ReplayScript> scripts;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--sessions" && i + 1 < argc) {
+            options.sessions = std::stoul(argv[++i]);
+        } else if (arg == "--concurrency" && i + 1 < argc) {
+            options.concurrency = std::stoul(argv[++i]);
+        } else {
+            ReplayScript script;
+            if (!loadReplayScript(arg, script)) {
+                return 1;
+            }
+            scripts.push_back(script);
+        }
+    }
+
+    removeDatabase(REPLAY_DB_PATH);
+    {
+        std::ifstream src(argv[1], std::ios::binary);
+        std::ofstream dst(REPLAY_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+    }
+
+    // Sessions share one connection, as the counter terminals of one shop process do
+    DatabaseOptions databaseOptions = DatabaseOptions::counterTerminal();
+    Database db(REPLAY_DB_PATH, databaseOptions);
+    if (!db.connect()) {
+        return 1;
+    }
+
+    SessionReplay replay(db, scripts, options);
+    SessionReplay::printReport(replay.run(), std::cout);
+
+    db.disconnect();
+    removeDatabase(REPLAY_DB_PATH);
+    return 0;
+}
@@ -1,15 +1,29 @@
 #pragma once
 
+#include "password_hash.h"
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
 
+// Passwords are kept as salted scrypt hashes (see password_hash.h). A login whose stored hash
+// was made at another cost re-hashes the password with the current parameters.
+//
+// The user table has its own lock and hashing runs outside it, so concurrent logins from
+// several threads only queue on the hasher's concurrency limit. The built-in admin and user
+// accounts are hashed on first use rather than on construction.
 class Authentication {
 public:
     Authentication();
+    // maxConcurrentHashes of 0 allows one evaluation per hardware thread
+    explicit Authentication(const PasswordHashParams& params, size_t maxConcurrentHashes = 0);
     ~Authentication();
 
     bool registerUser(const std::string& username, const std::string& password, const std::string& role);
+    // Adds a user whose password hash was made elsewhere, e.g. by an earlier run
+    bool loadUser(const std::string& username, const std::string& passwordHash, const std::string& role);
+    // Stored hash of a user, empty if there is no such user
+    std::string getPasswordHash(const std::string& username);
     bool login(const std::string& username, const std::string& password);
     bool isLoggedIn() const;
     std::string getCurrentUser() const;
@@ -18,13 +32,21 @@ public:
 
     bool hasAccess(const std::string& operation) const;
 
+    // Stateless checks for callers that keep their own sessions (e.g. the socket server)
+    bool verifyCredentials(const std::string& username, const std::string& password, std::string& role);
+    bool roleHasAccess(const std::string& role, const std::string& operation) const;
+
 private:
+    // Hash and role of a user, hashing a built-in user's password on first use; an empty
+    // hash if there is no such user
+    std::string storedHash(const std::string& username, std::string& role);
+
     bool loggedIn_;
     std::string currentUser_;
     std::string currentRole_;
-    std::map<std::string, std::pair<std::string, std::string>> users_; // username -> (password, role)
-    std::map<std::string, std::vector<std::string>> permissions_; // role -> operations
+    std::map<std::string, std::pair<std::string, std::string>> users_; // username -> (password hash, role)
+    mutable std::mutex usersMutex_;
+    std::map<std::string, std::vector<std::string>> permissions_; // role -> operations, fixed after construction
     
-    // Password hashing
-    std::string hashPassword(const std::string& password);
+    PasswordHasher hasher_;
 };
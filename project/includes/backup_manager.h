@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct sqlite3;
+
+// Pacing of a BackupManager. Zero pauses and limits turn the corresponding brake off.
+struct BackupOptions {
+    int pagesPerStep = 64;               // pages copied per sqlite3_backup_step, i.e. per lock
+    int stepPauseMs = 2;                 // rest after every step, leaving the disk to order entry
+    int maxPagesPerSecond = 0;           // overall copy rate limit
+    int busyRetryMs = 20;                // rest after a step that found a writer holding the lock
+    int maxRestarts = 3;                 // see BackupManager; only without WAL
+    bool verify = true;                  // integrity_check the copy before it replaces the old backup
+    int checkpointIntervalSeconds = 60;  // passive WAL checkpoints from the background thread
+};
+
+// Online backups of a shop database while the shop keeps trading, and the WAL checkpoints
+// that order entry should not have to run itself.
+//
+// A background thread copies the database with sqlite3_backup_step, a few pages at a time
+// and with a rest after each step, over connections of its own, so it never waits for a
+// Database's mutex and writers never wait long for it. In WAL mode the copy holds one read
+// transaction from start to finish: writers carry on through the WAL and the backup is a
+// consistent snapshot of the moment it started. Without WAL every step takes a shared lock
+// of its own, and a commit between two steps makes SQLite start the copy over; after
+// maxRestarts of those the backup gives up rather than lock the writers out.
+//
+// The copy goes to DESTINATION.partial and is renamed over the destination once complete
+// and, with verify on, once PRAGMA integrity_check has passed on it, so a failed or cancelled
+// backup never replaces a good one.
+//
+// The same thread runs a PASSIVE checkpoint every checkpointIntervalSeconds and after each
+// backup. Paired with DatabaseOptions::autoCheckpoint = false on the shop's connections,
+// this takes checkpoint work out of order commits.
+class BackupManager {
+public:
+    enum class State { Idle, Running, Succeeded, Failed, Cancelled };
+
+    struct Status {
+        State state;
+        std::string destination;
+        int pageCount;    // pages of the database being copied
+        int pagesCopied;
+        int restarts;     // times SQLite restarted the copy after a write
+        bool verified;
+        std::string error;
+        double elapsedMs;
+        // Outcome of the latest checkpoint: frames in the WAL and frames written back to the
+        // database file (-1 when the database is not in WAL mode)
+        int walFrames;
+        int checkpointedFrames;
+    };
+
+    explicit BackupManager(const std::string& databasePath, const BackupOptions& options = BackupOptions());
+    ~BackupManager();
+
+    BackupManager(const BackupManager&) = delete;
+    BackupManager& operator=(const BackupManager&) = delete;
+
+    // Checks that the database can be opened and starts the background thread
+    bool start();
+    // Cancels a running backup and stops the background thread
+    void stop();
+
+    // Starts a backup to destinationPath on the background thread. Fails if the manager is
+    // not started or a backup is already running.
+    bool startBackup(const std::string& destinationPath);
+    void cancelBackup();
+    // Waits for the running backup, if any, and tells whether the latest one succeeded
+    bool waitForBackup();
+    Status getStatus() const;
+
+    // Checkpoints now, from the calling thread. PASSIVE copies back what it can without
+    // waiting for anyone; truncate waits for readers and writers and then empties the WAL
+    // file, which suits closing time.
+    bool checkpoint(bool truncate = false);
+
+    // Runs PRAGMA integrity_check on a database file; error holds the first problem found
+    static bool verify(const std::string& path, std::string& error);
+
+private:
+    void run();
+    void runBackup(const std::string& destinationPath);
+    // Copies the database into target; false with error set on failure or cancellation
+    bool copy(sqlite3* source, sqlite3* target, std::string& error);
+    bool runCheckpoint(sqlite3* handle, bool truncate);
+    bool openDatabase(sqlite3*& handle, std::string& error) const;
+    // Sleeps unless a cancel or stop comes first; false if one did
+    bool rest(std::chrono::milliseconds duration);
+
+    std::string databasePath_;
+    BackupOptions options_;
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    bool started_;
+    bool stopping_;
+    std::string pendingDestination_;
+    std::atomic<bool> cancelled_;
+    Status status_;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "protocol.h"
+#include <string>
+#include <vector>
+
+// Blocking client for the local-socket server (see protocol.h)
+class Client {
+public:
+    explicit Client(const std::string& socketPath);
+    ~Client();
+
+    bool connect();
+    void disconnect();
+    bool isConnected() const;
+
+    // Sends one request and waits for the response. Returns false on transport errors;
+    // a server-side error is reported as a response whose status row is "ERR".
+    bool call(const std::vector<std::string>& request, Message& response);
+
+private:
+    bool sendAll(const std::string& data);
+    bool receiveFrame(std::string& payload);
+
+    std::string socketPath_;
+    int fd_;
+    std::string input_;
+};
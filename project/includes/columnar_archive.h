@@ -0,0 +1,84 @@
+#pragma once
+
+#include "database.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Read-only columnar file of orders for cold history, several times smaller than the same
+// orders in SQLite. Orders are sorted by date and cut into blocks of BLOCK_ROWS; within a
+// block every column is bit-packed at the width its value range needs, after dates and
+// ids are turned into deltas from the previous row, urgency rates into indexes into a
+// dictionary and prices into 1/10000 units. The block index keeps each block's first and
+// last date and its exact revenue, so a range query skips the blocks outside the range,
+// takes whole blocks inside it from the index and decodes only the blocks at its edges.
+//
+// The file is memory-mapped by open() and decoded in place; it uses the byte order of the
+// machine that wrote it.
+class ColumnarArchive {
+public:
+    static const uint32_t BLOCK_ROWS = 4096;
+
+    // Writes the orders placed between the two dates in an SQLite shop database or order
+    // archive (anything with Orders and OrderSummary) to a columnar file
+    static bool write(const std::string& sqlitePath, int startDate, int endDate, const std::string& outputPath);
+
+    ColumnarArchive();
+    ~ColumnarArchive();
+
+    ColumnarArchive(const ColumnarArchive&) = delete;
+    ColumnarArchive& operator=(const ColumnarArchive&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    uint64_t getOrderCount() const;
+    size_t getBlockCount() const;
+    size_t getFileSize() const;
+    // Date range of the stored orders
+    int getFirstDate() const;
+    int getLastDate() const;
+
+    // Same results as the Database methods of the same names over the stored orders. Flower
+    // usage is worked out from the recipes and flowers passed in, as the database does from
+    // its current ones.
+    double getTotalRevenue(int startDate, int endDate) const;
+    std::map<std::string, std::map<std::string, int>> getFlowerUsageByPeriod(
+        int startDate, int endDate, const std::vector<Database::RecipeLine>& recipes,
+        const std::vector<Database::Flower>& flowers) const;
+    // Units ordered per composition id
+    std::map<int, long long> getCompositionQuantities(int startDate, int endDate) const;
+
+    // Decodes every order placed between the two dates, in date order, with its total price
+    void forEachOrder(int startDate, int endDate,
+                      const std::function<void(const Database::Order&, double totalPrice)>& onOrder) const;
+
+    // Blocks a query over the range has to look at
+    size_t countBlocks(int startDate, int endDate) const;
+
+private:
+    struct FileHeader;
+    struct BlockInfo;
+    struct ColumnHeader;
+
+    const BlockInfo& block(size_t index) const;
+    // Header of one column of a block; the column's packed words follow it
+    const ColumnHeader* column(const BlockInfo& info, size_t index) const;
+    // Checks that the header, the block index and every column lie within the file
+    bool validate() const;
+    // Calls onBlock for every block overlapping the range, saying whether the block lies
+    // wholly inside it
+    void forEachBlock(int startDate, int endDate,
+                      const std::function<void(const BlockInfo&, bool inside)>& onBlock) const;
+    // Decodes a column of a block into values
+    void decode(const BlockInfo& info, size_t index, int64_t* values) const;
+
+    const unsigned char* data_;
+    size_t size_;
+    const FileHeader* header_;
+    const double* urgencyRates_;
+};
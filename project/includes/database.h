@@ -1,20 +1,37 @@
 #pragma once
 
+#include "database_options.h"
+#include "lru_cache.h"
+#include "string_arena.h"
 #include <sqlite3.h>
+#include <any>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <memory>
+#include <mutex>
 
+// Thread safety: every member function may be called from any thread. Calls on one
+// Database object are serialized by an internal lock and share its connection, so
+// concurrent callers wait for each other rather than race; use one Database per thread
+// (each with its own connection) where reads should run in parallel. Results are
+// independent copies; ResultSet rows stay valid after later calls. Order listeners run
+// while the lock is held.
 class Database {
 public:
-    Database(const std::string& dbPath);
+    Database(const std::string& dbPath, const DatabaseOptions& options = DatabaseOptions());
     ~Database();
 
     // Connection management
     bool connect();
     void disconnect();
     bool isConnected() const;
+    const DatabaseOptions& getOptions() const;
 
     // User authentication
     bool authenticateUser(const std::string& username, const std::string& password);
@@ -28,7 +45,9 @@ public:
     };
 
     std::vector<Flower> getAllFlowers();
+    // Rejects a price above MAX_PRICE_INCREASE times the current one
     bool updateFlowerPrice(int flowerId, double newPrice);
+    static constexpr double MAX_PRICE_INCREASE = 1.1;
     
     // Composition operations
     struct Composition {
@@ -39,7 +58,19 @@ public:
 
     std::vector<Composition> getAllCompositions();
     std::map<int, int> getCompositionFlowers(int compositionId);
+
+    // One CompositionFlowers row: stems of a flower in one unit of a composition
+    struct RecipeLine {
+        int compositionId;
+        int flowerId;
+        int quantity;
+    };
+
+    // All recipes, ordered by composition and flower
+    std::vector<RecipeLine> getRecipeLines();
     Composition getMostPopularComposition();
+    // Full-text prefix search over name and description, best matches first
+    std::vector<Composition> searchCompositions(const std::string& query, int limit = 20);
     
     // Customer operations
     struct Customer {
@@ -50,15 +81,30 @@ public:
     };
 
     std::vector<Customer> getAllCustomers();
+    // Returns a customer with id 0 if there is no such customer
     Customer getCustomerById(int customerId);
+    // Looks up several customers at once; ids that are not cached are fetched with a single
+    // query. Unknown ids are missing from the result.
+    std::map<int, Customer> getCustomersByIds(const std::vector<int>& customerIds);
+    // Full-text prefix search over name, phone (with or without punctuation) and email;
+    // every word of the query must match. Best matches first.
+    std::vector<Customer> searchCustomers(const std::string& query, int limit = 20);
+
+    // LRU cache behind getCustomerById and getCustomersByIds, bounded by entry count.
+    // Customers are never modified through this class; the cache is emptied whenever
+    // another connection has committed to the database (PRAGMA data_version), and on
+    // resize and disconnect. 0 disables caching.
+    static const size_t DEFAULT_CUSTOMER_CACHE_SIZE = 1024;
+    void setCustomerCacheSize(size_t entries);
+    LruCacheStats getCustomerCacheStats() const;
     
-    // Order operations
+    // Order operations. Dates are day numbers (see date_utils.h).
     struct Order {
         int id;
         int customerId;
         int compositionId;
-        std::string orderDate;
-        std::string fulfillmentDate;
+        int orderDate;
+        int fulfillmentDate;
         int quantity;
         double urgencyRate;
     };
@@ -70,23 +116,258 @@ public:
         double totalPrice;
     };
 
-    bool createOrder(int customerId, int compositionId, const std::string& orderDate, 
-                    const std::string& fulfillmentDate, int quantity);
-    std::vector<Order> getOrdersByDate(const std::string& date);
-    std::vector<Order> getOrdersByDateRange(const std::string& startDate, const std::string& endDate);
+    // Surcharge for short lead times: 25% within a day, 15% within two days
+    static double urgencyRateFor(int orderDate, int fulfillmentDate);
+
+    bool createOrder(int customerId, int compositionId, int orderDate, int fulfillmentDate, int quantity);
+    std::vector<Order> getOrdersByDate(int date);
+    std::vector<Order> getOrdersByDateRange(int startDate, int endDate);
+    // Orders still to be fulfilled on or after the given day
+    std::vector<Order> getPendingOrders(int fromDate);
     OrderSummary getOrderSummary(int orderId);
-    double getTotalRevenue(const std::string& startDate, const std::string& endDate);
+    double getTotalRevenue(int startDate, int endDate);
     std::vector<std::pair<int, int>> getOrdersByUrgency();
-    std::map<std::string, std::map<std::string, int>> getFlowerUsageByPeriod(
-        const std::string& startDate, const std::string& endDate);
+    std::map<std::string, std::map<std::string, int>> getFlowerUsageByPeriod(int startDate, int endDate);
+    // Orders and revenue per composition name over all history: the CompositionSales aggregate
+    // plus the orders past its watermark. Only reads, so it never waits for the write lock.
     std::map<std::string, std::pair<int, double>> getCompositionSalesSummary();
+    // Adds the orders placed since the last refresh to the CompositionSales aggregate and
+    // moves its OrderID watermark; the cost depends on the number of new orders only
+    bool refreshCompositionSales();
+    // createOrder and applyJournaledOrders refresh the aggregate once this many orders have
+    // gone through the connection since the last refresh; connect and the summary itself
+    // refresh it once this many orders from anywhere are past the watermark. Both keep the
+    // part a summary has to add up from Orders small.
+    static const int COMPOSITION_SALES_FOLD_ORDERS = 500;
+    // Highest OrderID already counted in CompositionSales
+    int getCompositionSalesWatermark();
+
+    // Revenue over consecutive calendar buckets. Weeks start on Monday; the first and last
+    // buckets only count orders inside the requested range, and empty buckets are included.
+    enum class Granularity { Day, Week, Month, Year };
+
+    struct RevenueBucket {
+        int startDate;           // first day of the calendar bucket
+        double revenue;
+        int orderCount;
+        double urgencyFeeShare;  // fraction of the revenue that is urgency surcharge
+    };
+
+    static bool parseGranularity(const std::string& text, Granularity& granularity);
+    std::vector<RevenueBucket> getRevenueSeries(int startDate, int endDate, Granularity granularity);
+
+    // Closed years can be moved out of Orders and OrderSummary into a database file per year
+    // next to this one (flower.db -> flower.orders-2024.db), listed in OrderArchives. Order
+    // lookups and range reports then read this file plus only the archives whose order dates
+    // overlap the range; all-time reports read every archive. Archives are never written
+    // again once listed. Queries on an archive join it to the catalog tables of this file,
+    // also while reports are served from the snapshot.
+    struct OrderArchive {
+        int year;
+        std::string fileName;  // in the directory of this database
+        int firstOrderDate;
+        int lastOrderDate;
+        int lastFulfillmentDate;
+        int firstOrderId;
+        int lastOrderId;
+        int orderCount;
+    };
+
+    // Moves the orders placed in a year to its archive. The year must be over, all of its
+    // orders fulfilled and the year not archived yet; orders entered for it afterwards stay
+    // in this file. Freed pages are reused by new orders (VACUUM returns them to the disk).
+    bool archiveYear(int year);
+    // Oldest first
+    std::vector<OrderArchive> getOrderArchives();
+
+    // Order fields as submitted, before an id is assigned
+    struct NewOrder {
+        int customerId;
+        int compositionId;
+        int orderDate;
+        int fulfillmentDate;
+        int quantity;
+    };
+
+    // Inserts a batch of journaled orders (see order_journal.h) in one transaction together
+    // with the journal sequence number of the last one, so that a replay skips them. Orders
+    // that violate a constraint are reported and skipped; any other failure rolls the whole
+    // batch back and leaves the sequence where it was. Returns false if nothing was committed.
+    bool applyJournaledOrders(const std::vector<NewOrder>& orders, uint64_t lastSequence);
+    uint64_t getAppliedJournalSequence();
+    // Whether the customer and the composition an order refers to exist
+    bool orderReferencesExist(int customerId, int compositionId);
+
+    // Called after createOrder has committed an order, with its new id filled in. Listeners
+    // run on the thread that created the order, under the database lock, and must not call
+    // back into this object.
+    using OrderListener = std::function<void(const Order&)>;
+    int addOrderListener(OrderListener listener);
+    void removeOrderListener(int listenerId);
+
+    // Keyset pagination. A cursor marks the last row of the previous page, so each page is
+    // an index seek regardless of how deep the caller has paged. Customers and compositions
+    // are ordered by id, orders by (orderDate, id). A default cursor starts at the beginning;
+    // pageSize must be positive.
+    struct PageCursor {
+        int date = std::numeric_limits<int>::min();
+        int id = 0;
+    };
+
+    template <typename Row>
+    struct Page {
+        std::vector<Row> rows;
+        bool hasMore = false;
+        PageCursor next;  // pass back to fetch the following page
+    };
+
+    Page<Customer> getCustomersPage(const PageCursor& after, int pageSize);
+    Page<Composition> getCompositionsPage(const PageCursor& after, int pageSize);
+    Page<Order> getOrdersPage(const PageCursor& after, int pageSize);
+
+    // Arena-backed result sets for large listings: text columns are string_views into the
+    // set's own arena (shared between copies) and repeated catalog strings are interned,
+    // so a result costs a few block allocations instead of one per string.
+    template <typename Row>
+    struct ResultSet {
+        std::shared_ptr<StringArena> arena;
+        std::vector<Row> rows;
+    };
+
+    struct FlowerView {
+        int id;
+        std::string_view name;
+        std::string_view variety;
+        double price;
+    };
+
+    struct CustomerView {
+        int id;
+        std::string_view name;
+        std::string_view phone;
+        std::string_view email;
+    };
+
+    struct FlowerUsageView {
+        std::string_view flowerName;
+        std::string_view variety;
+        int quantity;
+    };
+
+    ResultSet<FlowerView> getFlowerTable();
+    ResultSet<CustomerView> getCustomerTable();
+    // Rows ordered by flower name and variety, like getFlowerUsageByPeriod
+    ResultSet<FlowerUsageView> getFlowerUsageTable(int startDate, int endDate);
+
+    // Result cache for getTotalRevenue, getRevenueSeries, getOrdersByUrgency, getFlowerUsageByPeriod,
+    // getFlowerUsageTable and getCompositionSalesSummary. The budget is in approximate bytes; 0 disables caching.
+    static const size_t DEFAULT_REPORT_CACHE_BUDGET = 4 * 1024 * 1024;
+    void setReportCacheBudget(size_t bytes);
+    LruCacheStats getReportCacheStats() const;
+
+    // Optional in-memory snapshot of the database that the report methods
+    // (getMostPopularComposition, getTotalRevenue, getRevenueSeries, getOrdersByUrgency,
+    // getFlowerUsageByPeriod, getCompositionSalesSummary) read from, so they never touch the file or block writers.
+    // The snapshot is recopied with incremental sqlite3_backup steps before a report once it
+    // is older than maxAgeSeconds, or once writesBeforeRefresh writes went through this
+    // object (0 disables the write trigger). Writes by other processes only become visible
+    // through the age limit.
+    bool enableReportSnapshot(int maxAgeSeconds, int writesBeforeRefresh);
+    void disableReportSnapshot();
+    bool refreshReportSnapshot();
+    bool hasReportSnapshot() const;
+
+    // Diagnostics for the performance tests. While tracing is on, the SQL text of every
+    // statement run on the main connection is recorded (statements inside triggers and on
+    // the report snapshot are not). explainQueryPlan returns the EXPLAIN QUERY PLAN detail
+    // lines of a statement.
+    void setStatementTracing(bool enabled);
+    std::vector<std::string> takeTracedStatements();
+    std::vector<std::string> explainQueryPlan(const std::string& sql);
 
 private:
+    // Recursive because public methods call each other (getCustomerById, report helpers)
+    mutable std::recursive_mutex mutex_;
+
     std::string dbPath_;
+    DatabaseOptions options_;
     sqlite3* db_;
     bool connected_;
 
+    sqlite3* snapshot_;
+    bool snapshotEnabled_;
+    std::chrono::seconds snapshotMaxAge_;
+    int snapshotWriteLimit_;
+    int writesSinceSnapshot_;
+    uint64_t snapshotGeneration_;
+    std::chrono::steady_clock::time_point snapshotTakenAt_;
+
+    void closeSnapshot();
+    sqlite3* reportHandle();
+
+    // Cached reports are keyed by reportVersion(), so a bump makes every older entry
+    // unreachable; those entries then age out through LRU eviction.
+    LruCache<std::string, std::any> reportCache_;
+    uint64_t writeGeneration_;
+    long long dataVersion_;
+    // Bumps writeGeneration_ and empties the customer cache after commits by other connections
+    void checkExternalWrites();
+
+    LruCache<int, Customer> customerCache_;
+
+    std::map<int, OrderListener> orderListeners_;
+    int nextListenerId_;
+
+    int ordersSinceSalesFold_;
+    void foldCompositionSalesIfDue(int newOrders);
+    // Refreshes the aggregate when COMPOSITION_SALES_FOLD_ORDERS or more orders are past its
+    // watermark; writable connections only
+    void foldCompositionSalesIfBehind();
+
+    bool tracing_;
+    std::vector<std::string> tracedStatements_;
+    static int traceCallback(unsigned type, void* context, void* statement, void* sql);
+
+    // Version of the data the next report reads: the snapshot refresh count or the write
+    // generation, tagged with which of the two it is
+    std::string reportVersion();
+    template <typename T, typename Compute>
+    T cachedReport(const std::string& key, Compute compute);
+
+    // Brings the schema up to date; tracked through PRAGMA user_version. Read-only
+    // connections only check that the schema is current.
+    bool migrate();
+
     // Helper methods for executing SQL
     bool executeSQL(const std::string& sql);
     bool executeSQLWithCallback(const std::string& sql, sqlite3_callback callback, void* data);
+    bool executeReportQuery(const std::string& sql, sqlite3_callback callback, void* data);
+    bool executeQuery(sqlite3* handle, const std::string& sql, sqlite3_callback callback, void* data);
+
+    // Prepared statements for hot lookups by connection, prepared on first use and kept until
+    // the connection is closed
+    std::map<std::pair<sqlite3*, std::string>, sqlite3_stmt*> statements_;
+    // Runs a cached statement with integer parameters bound in order
+    bool forEachCachedRow(sqlite3* handle, const std::string& sql, const std::vector<long long>& params,
+                          const std::function<void(sqlite3_stmt*)>& onRow);
+    // Finalizes the cached statements of one connection, or of all of them for nullptr
+    void finalizeStatements(sqlite3* handle);
+
+    // Read-only connections to the archives by year, opened on first use. Each has this
+    // database attached, so queries joining orders to the catalog run unchanged on them.
+    std::map<int, sqlite3*> archiveHandles_;
+    sqlite3* archiveHandle(const OrderArchive& archive);
+    std::string archivePath(const std::string& fileName) const;
+    // Archives listed on a connection (the main one or the report snapshot), oldest first
+    std::vector<OrderArchive> listArchives(sqlite3* handle);
+    // Connections to read for orders: the archives listed on handle that match, oldest
+    // first, then handle itself for the orders still in its Orders table
+    std::vector<sqlite3*> orderPartitions(sqlite3* handle, const std::function<bool(const OrderArchive&)>& matches);
+    // Same, for orders placed between the two dates
+    std::vector<sqlite3*> orderPartitionsForDates(sqlite3* handle, int startDate, int endDate);
+    // Copies the orders placed between the two dates into a new archive file
+    bool writeArchive(const std::string& path, int firstDate, int lastDate);
+
+    // Steps through a query, handing each row to onRow while it is current
+    bool forEachRow(sqlite3* handle, const std::string& sql, const std::function<void(sqlite3_stmt*)>& onRow);
 };
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// SQLite tuning applied by Database::connect(). Zero or empty fields keep SQLite's default.
+struct DatabaseOptions {
+    int pageSize = 0;            // bytes; only affects newly created files (or after VACUUM)
+    long long cacheSizeKiB = 0;  // page cache size; SQLite defaults to 2000 KiB
+    long long mmapSize = 0;      // bytes of the file to memory-map
+    std::string synchronous;     // OFF, NORMAL, FULL or EXTRA
+    std::string tempStore;       // DEFAULT, FILE or MEMORY
+    std::string journalMode;     // DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+    int busyTimeoutMs = 0;       // how long to wait for another connection's lock; 0 fails at once
+    bool autoCheckpoint = true;  // false leaves WAL checkpoints to a BackupManager instead of commits
+    bool readOnly = false;       // open without write access and skip schema migrations
+    bool immutable = false;      // implies readOnly, for frozen copies that nothing changes: no locking
+
+    // Order entry at a shop counter: small footprint, every order durable on commit
+    static DatabaseOptions counterTerminal();
+
+    // Long report scans on a machine with plenty of RAM
+    static DatabaseOptions reportingServer();
+
+    // Looks up a preset by name: "default", "counter_terminal" or "reporting_server"
+    static bool preset(const std::string& name, DatabaseOptions& options);
+
+    // Reads "key = value" lines ('#' starts a comment). Keys are page_size, cache_size_kib,
+    // mmap_size, synchronous, temp_store, journal_mode, busy_timeout_ms, auto_checkpoint, read_only,
+    // immutable (true/false), and preset, which loads a preset that the following lines override.
+    static bool loadFromFile(const std::string& path, DatabaseOptions& options);
+
+    // PRAGMA statements that apply these options, in the order they must run. Settings that
+    // write to the file (page_size, journal_mode) are left out for read-only connections.
+    std::vector<std::string> pragmas() const;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+// Order dates are stored as day numbers: days since 1970-01-01.
+// Conversion to and from the "YYYY-MM-DD" text form happens only at the UI edge.
+
+int daysFromCivil(int year, int month, int day);
+void civilFromDays(int days, int& year, int& month, int& day);
+
+// Parses "YYYY-MM-DD" into a day number. Returns false on malformed or impossible dates.
+bool parseDate(const std::string& text, int& days);
+std::string formatDate(int days);
+
+// Today's day number in local time
+int currentDay();
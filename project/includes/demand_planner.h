@@ -0,0 +1,67 @@
+#pragma once
+
+#include "database.h"
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Projects how many stems of each flower are needed per fulfillment day by expanding
+// pending orders through their composition recipes. Recipes are held as a sparse
+// composition x flower matrix in compressed-row form, so expanding an order touches only
+// the flowers it actually uses. After rebuild() the planner follows new orders through
+// Database::addOrderListener; recipe changes need another rebuild().
+class DemandPlanner {
+public:
+    DemandPlanner(Database& db, size_t workerCount = 4);
+    ~DemandPlanner();
+
+    DemandPlanner(const DemandPlanner&) = delete;
+    DemandPlanner& operator=(const DemandPlanner&) = delete;
+
+    // Reloads recipes and recomputes demand for orders fulfilled on or after fromDate,
+    // splitting the orders across the worker threads
+    bool rebuild(int fromDate);
+
+    // Adds the stems of one order; orders fulfilled before the planned range are ignored
+    void addOrder(const Database::Order& order);
+
+    // Stems per FlowerID needed on one day, or summed over a range of days
+    std::map<int, long long> getDemand(int date) const;
+    std::map<int, long long> getDemand(int startDate, int endDate) const;
+
+    int getFromDate() const;
+
+private:
+    // Dense stem counts per day, indexed by flower column
+    using DayDemand = std::vector<long long>;
+
+    // Recipe matrix: the entries of composition row r are columns/stems[rowStart[r] .. rowStart[r + 1])
+    struct RecipeMatrix {
+        std::unordered_map<int, size_t> compositionRow;
+        std::vector<size_t> rowStart;
+        std::vector<size_t> columns;
+        std::vector<int> stems;
+        std::vector<int> flowerIds;  // FlowerID of each column
+    };
+
+    static void accumulate(const Database::Order& order, const RecipeMatrix& matrix, int fromDate,
+                           std::map<int, DayDemand>& demand);
+    std::map<int, long long> toFlowerMap(const DayDemand& totals) const;
+
+    Database& db_;
+    size_t workerCount_;
+    int listenerId_;
+    int fromDate_;
+    RecipeMatrix matrix_;
+    std::map<int, DayDemand> demand_;
+    mutable std::mutex mutex_;
+
+    // A rebuild works on its own copies and swaps them in at the end. Orders the listener
+    // sees meanwhile are kept and replayed onto the new totals, unless the load already
+    // contained them.
+    bool rebuilding_;
+    std::vector<Database::Order> ordersDuringRebuild_;
+    std::mutex rebuildMutex_;  // one rebuild at a time
+};
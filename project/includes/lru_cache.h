@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+struct LruCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t cost = 0;      // sum of the costs of cached entries
+    size_t capacity = 0;  // cost budget
+};
+
+// Least-recently-used cache bounded by a total cost budget. The cost of an entry is
+// supplied by the caller: 1 for count-bounded caches, an approximate byte size for
+// memory-bounded ones. A capacity of 0 disables caching.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) {
+        stats_.capacity = capacity;
+    }
+
+    bool get(const Key& key, Value& value) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            stats_.misses++;
+            return false;
+        }
+
+        entries_.splice(entries_.begin(), entries_, it->second);
+        value = it->second->value;
+        stats_.hits++;
+        return true;
+    }
+
+    void put(const Key& key, Value value, size_t cost = 1) {
+        erase(key);
+        if (cost > stats_.capacity) {
+            return;
+        }
+
+        entries_.push_front({key, std::move(value), cost});
+        index_[key] = entries_.begin();
+        stats_.cost += cost;
+        stats_.entries++;
+        evictToCapacity();
+    }
+
+    void erase(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return;
+        }
+
+        stats_.cost -= it->second->cost;
+        stats_.entries--;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    void clear() {
+        entries_.clear();
+        index_.clear();
+        stats_.cost = 0;
+        stats_.entries = 0;
+    }
+
+    void setCapacity(size_t capacity) {
+        stats_.capacity = capacity;
+        evictToCapacity();
+    }
+
+    LruCacheStats stats() const {
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t cost;
+    };
+
+    void evictToCapacity() {
+        while (stats_.cost > stats_.capacity && !entries_.empty()) {
+            const Entry& victim = entries_.back();
+            stats_.cost -= victim.cost;
+            stats_.entries--;
+            stats_.evictions++;
+            index_.erase(victim.key);
+            entries_.pop_back();
+        }
+    }
+
+    std::list<Entry> entries_;
+    std::unordered_map<Key, typename std::list<Entry>::iterator> index_;
+    LruCacheStats stats_;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "database.h"
+#include "thread_pool.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Runs the Database report methods on the databases of several branches at once and
+// merges their results into chain-wide figures. Every shop has its own connection and a
+// worker thread of its own that is the only one to use it, so a report takes as long as
+// the slowest shop rather than the sum of them.
+class MultiShopDatabase {
+public:
+    struct Shop {
+        std::string name;
+        std::string path;
+    };
+
+    // A merged result together with each shop's own, by shop name
+    template <typename T>
+    struct ChainReport {
+        T total;
+        std::map<std::string, T> byShop;
+    };
+
+    explicit MultiShopDatabase(const std::vector<Shop>& shops, const DatabaseOptions& options = DatabaseOptions());
+    ~MultiShopDatabase();
+
+    MultiShopDatabase(const MultiShopDatabase&) = delete;
+    MultiShopDatabase& operator=(const MultiShopDatabase&) = delete;
+
+    // Connects to every shop; false if any of them fails. Reports are keyed by shop name,
+    // so shops sharing a name are refused here as well.
+    bool connect();
+    void disconnect();
+    size_t getShopCount() const;
+
+    ChainReport<double> getTotalRevenue(int startDate, int endDate);
+    ChainReport<std::vector<std::pair<int, int>>> getOrdersByUrgency();
+    ChainReport<std::map<std::string, std::map<std::string, int>>> getFlowerUsageByPeriod(int startDate, int endDate);
+    ChainReport<std::map<std::string, std::pair<int, double>>> getCompositionSalesSummary();
+    ChainReport<std::vector<Database::RevenueBucket>> getRevenueSeries(int startDate, int endDate,
+                                                                      Database::Granularity granularity);
+
+private:
+    struct Shard {
+        std::string name;
+        std::unique_ptr<Database> db;
+        std::unique_ptr<ThreadPool> worker;
+    };
+
+    // Runs query on every shop on its worker and returns the results in shop order
+    template <typename T>
+    std::vector<T> runOnAll(const std::function<T(Database&)>& query);
+
+    // Runs query everywhere and folds the shops' results into the total with merge
+    template <typename T>
+    ChainReport<T> collect(const std::function<T(Database&)>& query, const std::function<void(T&, const T&)>& merge);
+
+    std::vector<Shard> shards_;
+    std::string duplicateName_;  // first name given to two shops, if any
+};
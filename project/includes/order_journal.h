@@ -0,0 +1,86 @@
+#pragma once
+
+#include "database.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Write path for bursts of order entry that does not wait for one SQLite commit per order.
+// submit() appends the order to an append-only journal file and returns once it is on
+// disk; orders that arrive while the previous write is being synced go out together in
+// the next write, so one fsync covers many orders. A background thread then inserts
+// journaled orders into SQLite in large transactions through its own connection. The
+// database remembers the last applied sequence number, and open() replays whatever a
+// crash left unapplied.
+//
+// Orders submitted here reach other connections (and their report caches) only after the
+// applier has committed them; waitUntilApplied() waits for that.
+class OrderJournal {
+public:
+    OrderJournal(const std::string& journalPath, const std::string& dbPath,
+                 const DatabaseOptions& options = DatabaseOptions());
+    ~OrderJournal();
+
+    OrderJournal(const OrderJournal&) = delete;
+    OrderJournal& operator=(const OrderJournal&) = delete;
+
+    // Opens the database and the journal, applies entries a previous run left behind and
+    // starts the writer and applier threads
+    bool open();
+
+    // Applies everything already acknowledged, then stops the threads
+    void close();
+
+    // Blocks until the order is durable in the journal. Returns false for orders that can
+    // never be inserted and when the journal is closed or failed to write.
+    bool submit(const Database::NewOrder& order);
+
+    // Blocks until every acknowledged order is in the database
+    void waitUntilApplied();
+
+    uint64_t getDurableSequence() const;
+    uint64_t getAppliedSequence() const;
+
+    // Orders per applier transaction
+    static constexpr size_t MAX_APPLY_BATCH = 1000;
+    // The journal is emptied once it is fully applied and has grown past this size
+    static constexpr long long TRUNCATE_THRESHOLD = 1024 * 1024;
+
+private:
+    struct Entry {
+        uint64_t sequence;
+        Database::NewOrder order;
+    };
+
+    bool replay();
+    void writerLoop();
+    void applierLoop();
+
+    std::string journalPath_;
+    Database db_;
+    int fd_;
+    long long fileSize_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable writerWake_;
+    std::condition_variable applierWake_;
+    std::condition_variable durableChanged_;
+    std::condition_variable appliedChanged_;
+
+    std::vector<Entry> pending_;     // submitted, not yet written
+    std::deque<Entry> applyQueue_;   // durable, not yet applied
+    uint64_t nextSequence_;
+    uint64_t durableSequence_;
+    uint64_t appliedSequence_;
+    bool running_;
+    bool stopping_;
+    bool writerDone_;
+    bool failed_;
+
+    std::thread writer_;
+    std::thread applier_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// scrypt cost: N = 2^logN blocks of 128 * r bytes each, p independent lanes.
+// Memory per evaluation is 128 * r * N bytes (16 MiB for the defaults).
+struct PasswordHashParams {
+    int logN = 14;
+    int r = 8;
+    int p = 1;
+
+    size_t memoryBytes() const;
+    bool operator==(const PasswordHashParams& other) const;
+};
+
+// Salted scrypt (RFC 7914) password hashes, computed by OpenSSL, in a self-describing format:
+//
+//   $scrypt$v=1$ln=14,r=8,p=1$<salt>$<key>      (salt and key in unpadded base64)
+//
+// A stored hash carries its own parameters, so hashes made at an older cost still
+// verify; needsRehash() tells the caller when to replace one after a successful login.
+//
+// At most maxConcurrent evaluations run at a time and the rest wait in line. This keeps
+// memory at maxConcurrent * memoryBytes() and each login's latency within a known multiple
+// of one evaluation when many terminals log in together.
+class PasswordHasher {
+public:
+    explicit PasswordHasher(const PasswordHashParams& params = PasswordHashParams(), size_t maxConcurrent = 0);
+
+    PasswordHasher(const PasswordHasher&) = delete;
+    PasswordHasher& operator=(const PasswordHasher&) = delete;
+
+    std::string hash(const std::string& password);
+    // False for a wrong password and for malformed hashes
+    bool verify(const std::string& password, const std::string& stored);
+    // True when stored was made with other parameters than the current ones or cannot be parsed
+    bool needsRehash(const std::string& stored) const;
+
+    const PasswordHashParams& params() const;
+    size_t maxConcurrent() const;
+    // Highest number of evaluations seen running at once
+    size_t peakConcurrent() const;
+
+    // Smallest cost whose evaluation takes at least targetMs on this machine, or the one
+    // below it when that is closer. logN stays within [10, maxLogN].
+    static PasswordHashParams calibrate(double targetMs, int r = 8, int maxLogN = 18);
+
+    // Raw scrypt (EVP_PBE_scrypt); false when the parameters are out of range
+    static bool scrypt(const std::string& password, const std::string& salt, const PasswordHashParams& params,
+                       size_t keyLength, std::vector<uint8_t>& key);
+
+private:
+    bool derive(const std::string& password, const std::string& salt, const PasswordHashParams& params,
+                size_t keyLength, std::vector<uint8_t>& key);
+
+    PasswordHashParams params_;
+    size_t maxConcurrent_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable slotFree_;
+    size_t active_;
+    size_t peak_;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Wire protocol of the local-socket server (flower_shop --serve).
+//
+// Every message travels as a frame: a 4-byte big-endian payload length followed by
+// the payload. A payload is a list of rows, each row a list of byte strings, encoded
+// with varint counts and lengths.
+//
+// A request is a single row: the command name followed by its arguments, e.g.
+// {"REVENUE", "20179", "20208"}. Dates are day numbers (see date_utils.h).
+// The first row of a response is the status, {"OK"} or {"ERR", message}; any
+// further rows carry the result.
+using Message = std::vector<std::vector<std::string>>;
+
+const size_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+
+std::string encodeMessage(const Message& message);
+bool decodeMessage(const std::string& payload, Message& message);
+
+// Wraps a payload into a frame
+std::string encodeFrame(const std::string& payload);
+
+// Removes one complete frame from the front of buffer. Returns false when the buffer
+// does not hold a full frame yet; sets error when the declared length is too large.
+bool extractFrame(std::string& buffer, std::string& payload, bool& error);
+
+Message okResponse();
+Message errorResponse(const std::string& error);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "database.h"
+#include <vector>
+
+// Estimates what the orders of a past period would have brought at candidate flower
+// prices, without a database copy or the pricing triggers. An order pays
+// Quantity * (1 + UrgencyRate) * sum(stems * price) (see the CalculateOrderPrice trigger) and
+// its urgency rate depends only on its dates, so revenue is linear in the prices. load()
+// folds every order of the period through the recipe matrix into two weights per flower,
+// after which a scenario costs two dot products over the flowers however many orders
+// there are.
+class RepricingSimulator {
+public:
+    struct Outcome {
+        double baseRevenue;
+        double urgencyFees;
+        double totalRevenue;
+        bool withinPriceRule;  // no price rises more than updateFlowerPrice allows
+    };
+
+    explicit RepricingSimulator(Database& db, size_t workerCount = 4);
+
+    // Reads current prices, recipes and the orders placed between the two dates (inclusive)
+    bool load(int startDate, int endDate);
+
+    // Price vectors are indexed like flowerIds(), which lists every flower
+    const std::vector<int>& flowerIds() const;
+    const std::vector<double>& currentPrices() const;
+
+    // Revenue of the period at current prices
+    Outcome baseline() const;
+
+    // Evaluates each price vector, spreading the scenarios across the worker threads.
+    // Returns false if a vector's length differs from flowerIds().
+    bool evaluate(const std::vector<std::vector<double>>& scenarios, std::vector<Outcome>& outcomes) const;
+
+private:
+    Outcome evaluateOne(const double* prices) const;
+
+    Database& db_;
+    size_t workerCount_;
+
+    std::vector<int> flowerIds_;
+    std::vector<double> currentPrices_;
+    // Stems sold per flower over the period, plain and weighted by (1 + urgency rate)
+    std::vector<double> stems_;
+    std::vector<double> weightedStems_;
+};
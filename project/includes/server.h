@@ -0,0 +1,92 @@
+#pragma once
+
+#include "database.h"
+#include "authentication.h"
+#include "order_journal.h"
+#include "protocol.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Serves Database and Authentication operations to local clients over a Unix domain
+// socket (see protocol.h for the wire format). One epoll event loop owns all sockets
+// and hands complete requests to a pool of worker threads; requests from the same
+// client are answered in order, one at a time.
+class Server {
+public:
+    Server(Database& db, Authentication& auth, const std::string& socketPath, size_t workerCount = 4);
+    ~Server();
+
+    // Creates and binds the listening socket
+    bool listen();
+
+    // Runs the event loop until stop() is called
+    void run();
+
+    // Safe to call from any thread and from signal handlers
+    void stop();
+
+    // Sends CREATE_ORDER through the journal instead of a direct insert; call before run().
+    // The journal must outlive the server.
+    void setOrderJournal(OrderJournal* journal);
+
+    // Per-connection login state
+    struct Session {
+        bool loggedIn = false;
+        std::string username;
+        std::string role;
+    };
+
+    // Executes one request against the database; used by the workers
+    Message handleRequest(Session& session, const std::vector<std::string>& request);
+
+private:
+    struct Connection {
+        uint64_t id;
+        int fd;
+        std::string input;
+        std::string output;
+        std::deque<std::string> pending;  // complete request payloads not yet dispatched
+        bool busy = false;                // a request of this connection is in a worker
+        bool closing = false;             // peer closed; drop once the worker is done
+        Session session;                  // touched by workers only
+    };
+
+    struct Completion {
+        uint64_t connectionId;
+        std::string frame;
+    };
+
+    void acceptConnections();
+    void readConnection(const std::shared_ptr<Connection>& connection);
+    void dispatchNext(const std::shared_ptr<Connection>& connection);
+    void flushConnection(const std::shared_ptr<Connection>& connection);
+    void drainCompletions();
+    void closeConnection(const std::shared_ptr<Connection>& connection);
+    void updateInterest(const std::shared_ptr<Connection>& connection);
+
+    Database& db_;
+    Authentication& auth_;
+    OrderJournal* journal_;
+    std::string socketPath_;
+    size_t workerCount_;
+
+    int listenFd_;
+    int epollFd_;
+    int wakeFd_;
+    std::atomic<bool> running_;
+
+    uint64_t nextConnectionId_;
+    std::map<uint64_t, std::shared_ptr<Connection>> connections_;
+
+    std::mutex completionsMutex_;
+    std::vector<Completion> completions_;
+
+    std::unique_ptr<ThreadPool> pool_;
+};
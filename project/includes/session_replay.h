@@ -0,0 +1,67 @@
+#pragma once
+
+#include "database.h"
+#include "password_hash.h"
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Input lines of one recorded clerk session (flower_shop --record FILE), replayed verbatim.
+// Password entries are recorded as UI::SECRET_LINE; the line before one is the username.
+struct ReplayScript {
+    std::string name;
+    std::deque<std::string> lines;
+};
+
+bool loadReplayScript(const std::string& path, ReplayScript& script);
+
+// Runs many scripted UI sessions concurrently against one Database with their output
+// discarded, and reports throughput and response time per screen. A response is the time
+// from an input line being handed to the UI until the UI asks for the next one, credited to
+// the screen that took the input.
+class SessionReplay {
+public:
+    struct Options {
+        size_t sessions = 100;   // total sessions, taking the scripts in turn
+        size_t concurrency = 8;  // sessions running at once
+        // Passwords of the built-in accounts; any other username logging in within a script
+        // gets a "user" account with defaultPassword
+        std::map<std::string, std::string> passwords = {{"admin", "admin123"}, {"user", "user123"}};
+        std::string defaultPassword = "replay";
+        // Low cost so that logins do not dominate; use the production cost to include them
+        PasswordHashParams hashParams = {10, 8, 1};
+    };
+
+    struct ScreenStats {
+        std::string screen;
+        size_t count;
+        double totalMs;
+        double p50Ms;
+        double p95Ms;
+        double maxMs;
+    };
+
+    struct Report {
+        size_t sessions = 0;
+        size_t inputs = 0;
+        double wallMs = 0.0;
+        std::vector<ScreenStats> screens;  // busiest first by total time
+
+        double sessionsPerSecond() const;
+        double inputsPerSecond() const;
+    };
+
+    SessionReplay(Database& db, std::vector<ReplayScript> scripts, const Options& options);
+
+    Report run();
+
+    static void printReport(const Report& report, std::ostream& out);
+
+private:
+    Database& db_;
+    std::vector<ReplayScript> scripts_;
+    Options options_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Bump allocator for the text of one result set. Stored strings stay valid and at the
+// same address for the lifetime of the arena, so rows can hold std::string_views into it.
+// intern() additionally returns the same view for equal strings, which keeps repeated
+// catalog values (flower names, varieties) to a single copy.
+class StringArena {
+public:
+    explicit StringArena(size_t blockSize = 64 * 1024);
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    std::string_view store(std::string_view text);
+    std::string_view intern(std::string_view text);
+
+    size_t blockCount() const;
+    size_t bytesUsed() const;
+
+private:
+    char* allocate(size_t size);
+
+    size_t blockSize_;
+    size_t blockOffset_;
+    size_t bytesUsed_;
+    char* currentBlock_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::unordered_set<std::string_view> interned_;
+};
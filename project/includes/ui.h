@@ -2,17 +2,31 @@
 
 #include "database.h"
 #include "authentication.h"
+#include "demand_planner.h"
 #include <string>
 #include <deque>
+#include <iostream>
+#include <memory>
 
 class UI {
-private:
+protected:
+    // Input lines consumed before the input stream; scripted sessions queue their whole script here
     std::deque<std::string> mockInputs;
 
 public:
     UI(Database& db, Authentication& auth);
+    // Reads input from in and writes screens to out (e.g. scripted sessions with output discarded)
+    UI(Database& db, Authentication& auth, std::istream& in, std::ostream& out);
+    virtual ~UI() = default;
     
+    // Runs a session until the user exits or input runs out
     virtual void start();
+    
+    // Copies every input line to script so the session can be replayed (see session_replay.h).
+    // Password entries are written as SECRET_LINE.
+    void recordTo(std::ostream* script);
+    static const char* const SECRET_LINE;
+    
     virtual void showMainMenu();
     virtual void showAdminMenu();
     virtual void showUserMenu();
@@ -25,6 +39,7 @@ public:
     virtual void showFlowerManagement();
     virtual void displayAllFlowers();
     virtual void updateFlowerPrice();
+    virtual void simulatePriceChange();
     
     // Composition management
     virtual void showCompositionManagement();
@@ -40,15 +55,32 @@ public:
     virtual void displayOrderStatistics();
     virtual void displayFlowerUsageReport();
     virtual void displayCompositionSalesReport();
+    virtual void displayFlowerDemand();
     
     // Helper methods
     virtual std::string getInput(const std::string& prompt);
+    virtual std::string getSecretInput(const std::string& prompt);
     virtual int getIntInput(const std::string& prompt);
     virtual double getDoubleInput(const std::string& prompt);
     virtual void clearScreen();
     virtual void waitForKey();
 
+protected:
+    // Thrown by readLine() and the Exit menu entry; unwinds the nested menus back to start()
+    struct SessionEnded {};
+    
+    // Next input line, from mockInputs first, then the input stream
+    virtual std::string readLine(bool secret = false);
+
 private:
+    // Login followed by the menu for the user's role; a logout starts over
+    void runSession();
+    
+    std::istream& in_;
+    std::ostream& out_;
+    std::ostream* recorder_;
     Database& db_;
     Authentication& auth_;
+    // Built on first use and kept current by new orders afterwards
+    std::unique_ptr<DemandPlanner> planner_;
 };
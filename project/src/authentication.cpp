@@ -1,11 +1,21 @@
 #include "../includes/authentication.h"
 #include <iostream>
-#include <functional>
+#include <algorithm>
 
-Authentication::Authentication() : loggedIn_(false), currentUser_(""), currentRole_("") {
-    // Add default users for testing - store HASHED passwords
-    users_["admin"] = {hashPassword("admin123"), "admin"};
-    users_["user"] = {hashPassword("user123"), "user"};
+// Default users for testing: username -> (password, role). Their hashes are made on first
+// use, so that constructing an Authentication does no hashing at all.
+static const std::map<std::string, std::pair<std::string, std::string>> BUILT_IN_USERS = {
+    {"admin", {"admin123", "admin"}},
+    {"user", {"user123", "user"}},
+};
+
+Authentication::Authentication() : Authentication(PasswordHashParams()) {}
+
+Authentication::Authentication(const PasswordHashParams& params, size_t maxConcurrentHashes)
+    : loggedIn_(false), currentUser_(""), currentRole_(""), hasher_(params, maxConcurrentHashes) {
+    for (const auto& entry : BUILT_IN_USERS) {
+        users_[entry.first] = {"", entry.second.second};
+    }
     
     // Set up permissions
     permissions_["admin"] = {"view_flowers", "update_flower_price", "view_compositions", 
@@ -16,32 +26,97 @@ Authentication::Authentication() : loggedIn_(false), currentUser_(""), currentRo
 Authentication::~Authentication() {}
 
 bool Authentication::registerUser(const std::string& username, const std::string& password, const std::string& role) {
+    {
+        std::lock_guard<std::mutex> lock(usersMutex_);
+        if (users_.find(username) != users_.end()) {
+            std::cout << "User already exists" << std::endl;
+            return false;
+        }
+    }
+    
+    // Store hashed password; hashing is slow on purpose, so it runs outside the lock
+    std::string hash = hasher_.hash(password);
+    return loadUser(username, hash, role);
+}
+
+bool Authentication::loadUser(const std::string& username, const std::string& passwordHash, const std::string& role) {
+    std::lock_guard<std::mutex> lock(usersMutex_);
     if (users_.find(username) != users_.end()) {
         std::cout << "User already exists" << std::endl;
         return false;
     }
     
-    // Store hashed password
-    users_[username] = {hashPassword(password), role};
+    users_[username] = {passwordHash, role};
     return true;
 }
 
-bool Authentication::login(const std::string& username, const std::string& password) {
+std::string Authentication::getPasswordHash(const std::string& username) {
+    std::string role;
+    return storedHash(username, role);
+}
+
+std::string Authentication::storedHash(const std::string& username, std::string& role) {
+    {
+        std::lock_guard<std::mutex> lock(usersMutex_);
+        auto it = users_.find(username);
+        if (it == users_.end()) {
+            return "";
+        }
+        role = it->second.second;
+        if (!it->second.first.empty()) {
+            return it->second.first;
+        }
+    }
+
+    // A built-in user not hashed yet. Hashing runs outside the lock; when two threads race
+    // here, the first hash stored wins.
+    std::string hash = hasher_.hash(BUILT_IN_USERS.at(username).first);
+    std::lock_guard<std::mutex> lock(usersMutex_);
     auto it = users_.find(username);
-    if (it == users_.end()) {
-        return false;
+    if (it->second.first.empty()) {
+        it->second.first = hash;
     }
-    
-    if (it->second.first == hashPassword(password)) {
+    return it->second.first;
+}
+
+bool Authentication::login(const std::string& username, const std::string& password) {
+    std::string role;
+    if (verifyCredentials(username, password, role)) {
         loggedIn_ = true;
         currentUser_ = username;
-        currentRole_ = it->second.second;
+        currentRole_ = role;
         return true;
     }
     
     return false;
 }
 
+bool Authentication::verifyCredentials(const std::string& username, const std::string& password,
+                                       std::string& role) {
+    std::string stored = storedHash(username, role);
+    if (stored.empty()) {
+        role.clear();
+        return false;
+    }
+    
+    if (!hasher_.verify(password, stored)) {
+        role.clear();
+        return false;
+    }
+    
+    // Upgrade hashes made at an older cost while the plain password is at hand
+    if (hasher_.needsRehash(stored)) {
+        std::string upgraded = hasher_.hash(password);
+        std::lock_guard<std::mutex> lock(usersMutex_);
+        auto it = users_.find(username);
+        if (it != users_.end() && it->second.first == stored) {
+            it->second.first = upgraded;
+        }
+    }
+    
+    return true;
+}
+
 bool Authentication::isLoggedIn() const {
     return loggedIn_;
 }
@@ -65,7 +140,11 @@ bool Authentication::hasAccess(const std::string& operation) const {
         return false;
     }
     
-    auto it = permissions_.find(currentRole_);
+    return roleHasAccess(currentRole_, operation);
+}
+
+bool Authentication::roleHasAccess(const std::string& role, const std::string& operation) const {
+    auto it = permissions_.find(role);
     if (it == permissions_.end()) {
         return false;
     }
@@ -73,8 +152,3 @@ bool Authentication::hasAccess(const std::string& operation) const {
     const auto& rolePerm = it->second;
     return std::find(rolePerm.begin(), rolePerm.end(), operation) != rolePerm.end();
 }
-
-std::string Authentication::hashPassword(const std::string& password) {
-    std::hash<std::string> hasher;
-    return std::to_string(hasher(password));
-}
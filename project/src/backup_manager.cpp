@@ -0,0 +1,328 @@
+#include "../includes/backup_manager.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sqlite3.h>
+
+BackupManager::BackupManager(const std::string& databasePath, const BackupOptions& options)
+    : databasePath_(databasePath), options_(options), started_(false), stopping_(false), cancelled_(false),
+      status_{State::Idle, "", 0, 0, 0, false, "", 0.0, -1, -1} {}
+
+BackupManager::~BackupManager() {
+    stop();
+}
+
+bool BackupManager::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_) {
+        return true;
+    }
+
+    sqlite3* handle = nullptr;
+    std::string error;
+    bool opened = openDatabase(handle, error);
+    sqlite3_close(handle);
+    if (!opened) {
+        std::cerr << "Can't open database for backups: " << error << std::endl;
+        return false;
+    }
+
+    started_ = true;
+    stopping_ = false;
+    worker_ = std::thread(&BackupManager::run, this);
+    return true;
+}
+
+void BackupManager::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) {
+            return;
+        }
+        stopping_ = true;
+        cancelled_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    started_ = false;
+    stopping_ = false;
+    // A backup that was requested but never began
+    if (status_.state == State::Running) {
+        status_.state = State::Cancelled;
+        status_.error = "backup manager stopped";
+        pendingDestination_.clear();
+    }
+    finished_.notify_all();
+}
+
+bool BackupManager::startBackup(const std::string& destinationPath) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_ || stopping_ || status_.state == State::Running) {
+            return false;
+        }
+        pendingDestination_ = destinationPath;
+        cancelled_ = false;
+        int walFrames = status_.walFrames;
+        int checkpointedFrames = status_.checkpointedFrames;
+        status_ = Status{State::Running, destinationPath, 0, 0, 0, false, "", 0.0, walFrames, checkpointedFrames};
+    }
+    wake_.notify_all();
+    return true;
+}
+
+void BackupManager::cancelBackup() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    wake_.notify_all();
+}
+
+bool BackupManager::waitForBackup() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this] { return status_.state != State::Running; });
+    return status_.state == State::Succeeded;
+}
+
+BackupManager::Status BackupManager::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+bool BackupManager::checkpoint(bool truncate) {
+    sqlite3* handle = nullptr;
+    std::string error;
+    if (!openDatabase(handle, error)) {
+        std::cerr << "Can't open database for checkpoint: " << error << std::endl;
+        sqlite3_close(handle);
+        return false;
+    }
+    bool done = runCheckpoint(handle, truncate);
+    sqlite3_close(handle);
+    return done;
+}
+
+bool BackupManager::verify(const std::string& path, std::string& error) {
+    error.clear();
+    sqlite3* handle = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &handle, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(handle, "PRAGMA integrity_check", -1, &stmt, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(handle);
+    } else {
+        // A sound database gives the single row "ok"; otherwise one row per problem
+        int rc = sqlite3_step(stmt);
+        if (rc != SQLITE_ROW) {
+            error = sqlite3_errmsg(handle);
+        } else if (std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))) != "ok") {
+            error = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(handle);
+    return error.empty();
+}
+
+void BackupManager::run() {
+    auto interval = std::chrono::seconds(options_.checkpointIntervalSeconds);
+    auto nextCheckpoint = std::chrono::steady_clock::now() + interval;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (!pendingDestination_.empty()) {
+            std::string destination;
+            destination.swap(pendingDestination_);
+            lock.unlock();
+            runBackup(destination);
+            lock.lock();
+            continue;
+        }
+
+        auto woken = [this] { return stopping_ || !pendingDestination_.empty(); };
+        if (options_.checkpointIntervalSeconds <= 0) {
+            wake_.wait(lock, woken);
+        } else if (!wake_.wait_until(lock, nextCheckpoint, woken)) {
+            lock.unlock();
+            checkpoint(false);
+            lock.lock();
+            nextCheckpoint = std::chrono::steady_clock::now() + interval;
+        }
+    }
+}
+
+void BackupManager::runBackup(const std::string& destinationPath) {
+    auto started = std::chrono::steady_clock::now();
+    std::string partialPath = destinationPath + ".partial";
+    std::remove(partialPath.c_str());
+
+    std::string error;
+    sqlite3* source = nullptr;
+    sqlite3* target = nullptr;
+    bool opened = openDatabase(source, error);
+    bool succeeded = opened;
+    if (succeeded && sqlite3_open_v2(partialPath.c_str(), &target, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                                     nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(target);
+        succeeded = false;
+    }
+    if (succeeded) {
+        succeeded = copy(source, target, error);
+    }
+    sqlite3_close(target);
+
+    bool verified = false;
+    if (succeeded && options_.verify) {
+        succeeded = verified = verify(partialPath, error);
+    }
+    if (succeeded && std::rename(partialPath.c_str(), destinationPath.c_str()) != 0) {
+        error = "can't replace " + destinationPath;
+        succeeded = false;
+    }
+    if (!succeeded) {
+        std::remove(partialPath.c_str());
+    }
+
+    // The WAL could not be checkpointed past the backup's read transaction, so it may
+    // have grown meanwhile
+    if (opened) {
+        runCheckpoint(source, false);
+    }
+    sqlite3_close(source);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_.state = succeeded ? State::Succeeded : cancelled_ ? State::Cancelled : State::Failed;
+    status_.verified = verified;
+    status_.error = error;
+    status_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    if (status_.state == State::Failed) {
+        std::cerr << "Backup to " << destinationPath << " failed: " << error << std::endl;
+    }
+    finished_.notify_all();
+}
+
+bool BackupManager::copy(sqlite3* source, sqlite3* target, std::string& error) {
+    bool wal = false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(source, "PRAGMA journal_mode", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        wal = std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))) == "wal";
+    }
+    sqlite3_finalize(stmt);
+
+    // Reading the schema opens the read transaction that every step then shares
+    if (wal && sqlite3_exec(source, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(source);
+        return false;
+    }
+
+    sqlite3_backup* backup = sqlite3_backup_init(target, "main", source, "main");
+    if (!backup) {
+        error = sqlite3_errmsg(target);
+        if (wal) {
+            sqlite3_exec(source, "COMMIT", nullptr, nullptr, nullptr);
+        }
+        return false;
+    }
+
+    int pagesPerStep = options_.pagesPerStep > 0 ? options_.pagesPerStep : -1;
+    auto started = std::chrono::steady_clock::now();
+    long long pagesStepped = 0;
+    int lastCopied = 0;
+    int lastRemaining = -1;
+    int restarts = 0;
+    bool copied = true;
+    for (;;) {
+        int rc = sqlite3_backup_step(backup, pagesPerStep);
+        int remaining = sqlite3_backup_remaining(backup);
+        int pageCount = sqlite3_backup_pagecount(backup);
+        if (lastRemaining >= 0 && remaining > lastRemaining) {
+            restarts++;
+        }
+        lastRemaining = remaining;
+        // Pages this step actually copied; none after a restart, which starts the count over
+        int stepped = std::max(0, pageCount - remaining - lastCopied);
+        lastCopied = pageCount - remaining;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            status_.pageCount = pageCount;
+            status_.pagesCopied = pageCount - remaining;
+            status_.restarts = restarts;
+        }
+
+        if (rc == SQLITE_DONE) {
+            break;
+        }
+        auto pause = std::chrono::milliseconds(options_.stepPauseMs);
+        if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+            pause = std::chrono::milliseconds(options_.busyRetryMs);
+        } else if (rc != SQLITE_OK) {
+            error = sqlite3_errstr(rc);
+            copied = false;
+            break;
+        } else if (!wal && restarts > options_.maxRestarts) {
+            error = "the database kept changing during the copy; WAL mode avoids this";
+            copied = false;
+            break;
+        } else if (options_.maxPagesPerSecond > 0) {
+            pagesStepped += stepped;
+            auto due = started + std::chrono::milliseconds(pagesStepped * 1000 / options_.maxPagesPerSecond);
+            pause = std::max(pause, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        due - std::chrono::steady_clock::now()));
+        }
+        if (!rest(pause)) {
+            error = "cancelled";
+            copied = false;
+            break;
+        }
+    }
+
+    int rc = sqlite3_backup_finish(backup);
+    if (copied && rc != SQLITE_OK) {
+        error = sqlite3_errstr(rc);
+        copied = false;
+    }
+    if (wal) {
+        sqlite3_exec(source, "COMMIT", nullptr, nullptr, nullptr);
+    }
+    return copied;
+}
+
+bool BackupManager::runCheckpoint(sqlite3* handle, bool truncate) {
+    if (truncate) {
+        sqlite3_busy_timeout(handle, 5000);
+    }
+    // A connection only opens the WAL once it has read from the database
+    sqlite3_exec(handle, "SELECT COUNT(*) FROM sqlite_master", nullptr, nullptr, nullptr);
+    int walFrames = -1;
+    int checkpointedFrames = -1;
+    int rc = sqlite3_wal_checkpoint_v2(handle, nullptr, truncate ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE,
+                                       &walFrames, &checkpointedFrames);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Checkpoint failed: " << sqlite3_errmsg(handle) << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_.walFrames = walFrames;
+    status_.checkpointedFrames = checkpointedFrames;
+    return true;
+}
+
+bool BackupManager::openDatabase(sqlite3*& handle, std::string& error) const {
+    // Read-write, as checkpoints write to the database file, but never creating one
+    if (sqlite3_open_v2(databasePath_.c_str(), &handle, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        error = sqlite3_errmsg(handle);
+        return false;
+    }
+    return true;
+}
+
+bool BackupManager::rest(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (duration.count() > 0) {
+        wake_.wait_for(lock, duration, [this] { return cancelled_ || stopping_; });
+    }
+    return !cancelled_ && !stopping_;
+}
@@ -0,0 +1,100 @@
+#include "../includes/client.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Client::Client(const std::string& socketPath) : socketPath_(socketPath), fd_(-1) {}
+
+Client::~Client() {
+    disconnect();
+}
+
+bool Client::connect() {
+    if (fd_ >= 0) {
+        return true;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath_.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath_ << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath_.c_str(), sizeof(address.sun_path) - 1);
+
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return false;
+    }
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    return true;
+}
+
+void Client::disconnect() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+        input_.clear();
+    }
+}
+
+bool Client::isConnected() const {
+    return fd_ >= 0;
+}
+
+bool Client::call(const std::vector<std::string>& request, Message& response) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    std::string payload;
+    if (!sendAll(encodeFrame(encodeMessage({request}))) || !receiveFrame(payload) ||
+        !decodeMessage(payload, response) || response.empty() || response[0].empty()) {
+        disconnect();
+        return false;
+    }
+
+    return true;
+}
+
+bool Client::sendAll(const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = send(fd_, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool Client::receiveFrame(std::string& payload) {
+    char buffer[16384];
+    bool error = false;
+    while (!extractFrame(input_, payload, error)) {
+        if (error) {
+            return false;
+        }
+        ssize_t received = recv(fd_, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        input_.append(buffer, static_cast<size_t>(received));
+    }
+    return true;
+}
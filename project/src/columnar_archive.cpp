@@ -0,0 +1,556 @@
+#include "../includes/columnar_archive.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sqlite3.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout: FileHeader, the blocks, the urgency rate dictionary, then the block index.
+// Every part starts at a multiple of 8 bytes, so the mapped words can be read in place.
+struct ColumnarArchive::FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;  // BYTE_ORDER_MARK as written by the producing machine
+    uint32_t blockRows;
+    uint32_t blockCount;
+    uint64_t orderCount;
+    uint64_t urgencyOffset;
+    uint64_t blockIndexOffset;
+    uint32_t urgencyCount;
+    uint32_t columnCount;
+    int32_t firstDate;
+    int32_t lastDate;
+};
+
+struct ColumnarArchive::BlockInfo {
+    int32_t firstDate;
+    int32_t lastDate;
+    uint32_t rows;
+    uint32_t reserved;
+    uint64_t offset;
+    int64_t revenue;  // sum of the block's prices in PRICE_UNITS
+};
+
+// A column stores each value v as v - reference in width bits. Delta columns store the
+// difference to the previous row instead, the first one relative to base.
+struct ColumnarArchive::ColumnHeader {
+    int64_t base;
+    int64_t reference;
+    uint32_t width;
+    uint32_t wordCount;
+};
+
+static const char MAGIC[8] = {'F', 'L', 'W', 'C', 'O', 'L', '0', '1'};
+static const uint32_t FORMAT_VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+// Prices are kept exactly to 1/10000: a two-decimal price times an urgency factor of
+// 1.15 or 1.25 has at most four decimals
+static const double PRICE_UNITS = 10000.0;
+// Composition ids below this are counted in a vector while scanning, any others in a map,
+// so that one stray large id cannot make the vector huge
+static const int64_t DENSE_COMPOSITION_IDS = 1 << 16;
+
+// Columns in file order
+enum ColumnIndex {
+    ORDER_DATE,      // delta from the previous row; rows are sorted by date
+    ORDER_ID,        // zigzag-coded delta from the previous row
+    CUSTOMER_ID,
+    COMPOSITION_ID,
+    LEAD_DAYS,       // fulfillment date - order date
+    QUANTITY,
+    URGENCY,         // index into the urgency rate dictionary
+    PRICE,           // total price in PRICE_UNITS
+    COLUMN_COUNT
+};
+
+static uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+static uint32_t bitWidth(uint64_t value) {
+    uint32_t width = 0;
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+// Packs each value v as v - reference in width bits, low bits first
+static std::vector<uint64_t> pack(const std::vector<int64_t>& values, int64_t reference, uint32_t width) {
+    std::vector<uint64_t> words((values.size() * width + 63) / 64, 0);
+    // A constant column takes no words at all; unpack restores it from the reference
+    if (width == 0) {
+        return words;
+    }
+    uint64_t bit = 0;
+    for (int64_t value : values) {
+        uint64_t packed = static_cast<uint64_t>(value) - static_cast<uint64_t>(reference);
+        size_t word = bit >> 6;
+        unsigned shift = bit & 63;
+        words[word] |= packed << shift;
+        if (shift + width > 64) {
+            words[word + 1] |= packed >> (64 - shift);
+        }
+        bit += width;
+    }
+    return words;
+}
+
+static void unpack(const uint64_t* words, uint32_t width, int64_t reference, size_t count, int64_t* values) {
+    if (width == 0) {
+        std::fill(values, values + count, reference);
+        return;
+    }
+    uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    uint64_t bit = 0;
+    for (size_t i = 0; i < count; i++, bit += width) {
+        size_t word = bit >> 6;
+        unsigned shift = bit & 63;
+        uint64_t packed = words[word] >> shift;
+        if (shift + width > 64) {
+            packed |= words[word + 1] << (64 - shift);
+        }
+        values[i] = static_cast<int64_t>(static_cast<uint64_t>(reference) + (packed & mask));
+    }
+}
+
+bool ColumnarArchive::write(const std::string& sqlitePath, int startDate, int endDate, const std::string& outputPath) {
+    sqlite3* handle = nullptr;
+    if (sqlite3_open_v2(sqlitePath.c_str(), &handle, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Cannot open database: " << sqlite3_errmsg(handle) << std::endl;
+        sqlite3_close(handle);
+        return false;
+    }
+
+    // Orders without a summary have no price; like the revenue report, they add nothing
+    const char* ORDERS_SQL =
+        "SELECT o.OrderID, o.CustomerID, o.CompositionID, o.OrderDate, o.FulfillmentDate, o.Quantity, "
+        "o.UrgencyRate, COALESCE(os.TotalPrice, 0) "
+        "FROM Orders o LEFT JOIN OrderSummary os ON os.OrderID = o.OrderID "
+        "WHERE o.OrderDate BETWEEN ?1 AND ?2 "
+        "ORDER BY o.OrderDate, o.OrderID";
+    const char* URGENCY_SQL =
+        "SELECT DISTINCT UrgencyRate FROM Orders WHERE OrderDate BETWEEN ?1 AND ?2 ORDER BY UrgencyRate";
+    sqlite3_stmt* orders = nullptr;
+    sqlite3_stmt* urgency = nullptr;
+    if (sqlite3_prepare_v2(handle, ORDERS_SQL, -1, &orders, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(handle, URGENCY_SQL, -1, &urgency, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(handle) << std::endl;
+        sqlite3_finalize(orders);
+        sqlite3_finalize(urgency);
+        sqlite3_close(handle);
+        return false;
+    }
+
+    std::vector<double> urgencyRates;
+    sqlite3_bind_int(urgency, 1, startDate);
+    sqlite3_bind_int(urgency, 2, endDate);
+    while (sqlite3_step(urgency) == SQLITE_ROW) {
+        urgencyRates.push_back(sqlite3_column_double(urgency, 0));
+    }
+    sqlite3_finalize(urgency);
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Cannot create columnar archive: " << outputPath << std::endl;
+        sqlite3_finalize(orders);
+        sqlite3_close(handle);
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.blockRows = BLOCK_ROWS;
+    header.columnCount = COLUMN_COUNT;
+    header.urgencyCount = static_cast<uint32_t>(urgencyRates.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    std::vector<BlockInfo> index;
+    std::vector<int64_t> columns[COLUMN_COUNT];
+    int64_t revenue = 0;
+    auto flush = [&]() {
+        std::vector<int64_t>& dates = columns[ORDER_DATE];
+        std::vector<int64_t>& ids = columns[ORDER_ID];
+        BlockInfo info{static_cast<int32_t>(dates.front()), static_cast<int32_t>(dates.back()),
+                       static_cast<uint32_t>(dates.size()), 0, offset, revenue};
+        int64_t bases[COLUMN_COUNT] = {};
+        bases[ORDER_DATE] = dates.front();
+        bases[ORDER_ID] = ids.front();
+        for (size_t i = dates.size() - 1; i > 0; i--) {
+            dates[i] -= dates[i - 1];
+            ids[i] = static_cast<int64_t>(zigzag(ids[i] - ids[i - 1]));
+        }
+        dates[0] = 0;
+        ids[0] = 0;
+
+        for (size_t c = 0; c < COLUMN_COUNT; c++) {
+            int64_t reference = *std::min_element(columns[c].begin(), columns[c].end());
+            int64_t maximum = *std::max_element(columns[c].begin(), columns[c].end());
+            uint32_t width = bitWidth(static_cast<uint64_t>(maximum) - static_cast<uint64_t>(reference));
+            std::vector<uint64_t> words = pack(columns[c], reference, width);
+            ColumnHeader column{bases[c], reference, width, static_cast<uint32_t>(words.size())};
+            out.write(reinterpret_cast<const char*>(&column), sizeof(column));
+            out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+            offset += sizeof(column) + words.size() * sizeof(uint64_t);
+            columns[c].clear();
+        }
+        index.push_back(info);
+        revenue = 0;
+    };
+
+    bool valid = true;
+    int rc;
+    sqlite3_bind_int(orders, 1, startDate);
+    sqlite3_bind_int(orders, 2, endDate);
+    while ((rc = sqlite3_step(orders)) == SQLITE_ROW) {
+        double urgencyRate = sqlite3_column_double(orders, 6);
+        auto rate = std::lower_bound(urgencyRates.begin(), urgencyRates.end(), urgencyRate);
+        if (rate == urgencyRates.end() || *rate != urgencyRate) {
+            valid = false;
+            break;
+        }
+        int64_t price = std::llround(sqlite3_column_double(orders, 7) * PRICE_UNITS);
+        columns[ORDER_DATE].push_back(sqlite3_column_int(orders, 3));
+        columns[ORDER_ID].push_back(sqlite3_column_int(orders, 0));
+        columns[CUSTOMER_ID].push_back(sqlite3_column_int(orders, 1));
+        columns[COMPOSITION_ID].push_back(sqlite3_column_int(orders, 2));
+        columns[LEAD_DAYS].push_back(sqlite3_column_int(orders, 4) - sqlite3_column_int(orders, 3));
+        columns[QUANTITY].push_back(sqlite3_column_int(orders, 5));
+        columns[URGENCY].push_back(rate - urgencyRates.begin());
+        columns[PRICE].push_back(price);
+        revenue += price;
+        header.orderCount++;
+        if (columns[ORDER_DATE].size() == BLOCK_ROWS) {
+            flush();
+        }
+    }
+    if (rc != SQLITE_DONE || !valid) {
+        std::cerr << "Cannot read orders: " << sqlite3_errmsg(handle) << std::endl;
+        sqlite3_finalize(orders);
+        sqlite3_close(handle);
+        out.close();
+        std::remove(outputPath.c_str());
+        return false;
+    }
+    sqlite3_finalize(orders);
+    sqlite3_close(handle);
+    if (!columns[ORDER_DATE].empty()) {
+        flush();
+    }
+
+    header.urgencyOffset = offset;
+    out.write(reinterpret_cast<const char*>(urgencyRates.data()), urgencyRates.size() * sizeof(double));
+    offset += urgencyRates.size() * sizeof(double);
+    header.blockIndexOffset = offset;
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BlockInfo));
+    header.blockCount = static_cast<uint32_t>(index.size());
+    if (!index.empty()) {
+        header.firstDate = index.front().firstDate;
+        header.lastDate = index.back().lastDate;
+    }
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::cerr << "Cannot write columnar archive: " << outputPath << std::endl;
+        std::remove(outputPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+ColumnarArchive::ColumnarArchive() : data_(nullptr), size_(0), header_(nullptr), urgencyRates_(nullptr) {}
+
+ColumnarArchive::~ColumnarArchive() {
+    close();
+}
+
+bool ColumnarArchive::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open columnar archive: " << path << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(FileHeader)) {
+        std::cerr << "Not a columnar archive: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Cannot map columnar archive: " << path << std::endl;
+        return false;
+    }
+
+    data_ = static_cast<const unsigned char*>(mapped);
+    size_ = status.st_size;
+    header_ = reinterpret_cast<const FileHeader*>(data_);
+    if (!validate()) {
+        std::cerr << "Not a valid columnar archive: " << path << std::endl;
+        close();
+        return false;
+    }
+    urgencyRates_ = reinterpret_cast<const double*>(data_ + header_->urgencyOffset);
+    return true;
+}
+
+void ColumnarArchive::close() {
+    if (data_) {
+        munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    urgencyRates_ = nullptr;
+}
+
+bool ColumnarArchive::isOpen() const {
+    return data_ != nullptr;
+}
+
+uint64_t ColumnarArchive::getOrderCount() const {
+    return header_ ? header_->orderCount : 0;
+}
+
+size_t ColumnarArchive::getBlockCount() const {
+    return header_ ? header_->blockCount : 0;
+}
+
+size_t ColumnarArchive::getFileSize() const {
+    return size_;
+}
+
+int ColumnarArchive::getFirstDate() const {
+    return header_ ? header_->firstDate : 0;
+}
+
+int ColumnarArchive::getLastDate() const {
+    return header_ ? header_->lastDate : 0;
+}
+
+bool ColumnarArchive::validate() const {
+    const FileHeader& header = *header_;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK || header.blockRows != BLOCK_ROWS ||
+        header.columnCount != COLUMN_COUNT) {
+        return false;
+    }
+    if (header.urgencyOffset % 8 != 0 || header.urgencyOffset > size_ ||
+        header.urgencyCount > (size_ - header.urgencyOffset) / sizeof(double) ||
+        header.blockIndexOffset != header.urgencyOffset + header.urgencyCount * sizeof(double) ||
+        header.blockCount > (size_ - header.blockIndexOffset) / sizeof(BlockInfo)) {
+        return false;
+    }
+
+    uint64_t orders = 0;
+    uint64_t expectedOffset = sizeof(FileHeader);
+    for (size_t b = 0; b < header.blockCount; b++) {
+        const BlockInfo& info = block(b);
+        if (info.offset != expectedOffset || info.rows == 0 || info.rows > BLOCK_ROWS ||
+            info.firstDate > info.lastDate || (b > 0 && info.firstDate < block(b - 1).lastDate)) {
+            return false;
+        }
+        uint64_t position = info.offset;
+        for (size_t c = 0; c < COLUMN_COUNT; c++) {
+            if (header.urgencyOffset - position < sizeof(ColumnHeader)) {
+                return false;
+            }
+            const ColumnHeader* column = reinterpret_cast<const ColumnHeader*>(data_ + position);
+            position += sizeof(ColumnHeader);
+            if (column->width > 64 || column->wordCount != (uint64_t(info.rows) * column->width + 63) / 64 ||
+                column->wordCount > (header.urgencyOffset - position) / sizeof(uint64_t)) {
+                return false;
+            }
+            position += column->wordCount * sizeof(uint64_t);
+        }
+        expectedOffset = position;
+        orders += info.rows;
+    }
+    return expectedOffset == header.urgencyOffset && orders == header.orderCount;
+}
+
+const ColumnarArchive::BlockInfo& ColumnarArchive::block(size_t index) const {
+    return reinterpret_cast<const BlockInfo*>(data_ + header_->blockIndexOffset)[index];
+}
+
+const ColumnarArchive::ColumnHeader* ColumnarArchive::column(const BlockInfo& info, size_t index) const {
+    const unsigned char* position = data_ + info.offset;
+    for (size_t c = 0; c < index; c++) {
+        const ColumnHeader* header = reinterpret_cast<const ColumnHeader*>(position);
+        position += sizeof(ColumnHeader) + header->wordCount * sizeof(uint64_t);
+    }
+    return reinterpret_cast<const ColumnHeader*>(position);
+}
+
+void ColumnarArchive::decode(const BlockInfo& info, size_t index, int64_t* values) const {
+    const ColumnHeader* header = column(info, index);
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(header + 1);
+    unpack(words, header->width, header->reference, info.rows, values);
+
+    if (index == ORDER_DATE) {
+        int64_t value = header->base;
+        for (size_t i = 0; i < info.rows; i++) {
+            value += values[i];
+            values[i] = value;
+        }
+    } else if (index == ORDER_ID) {
+        int64_t value = header->base;
+        for (size_t i = 0; i < info.rows; i++) {
+            value += unzigzag(static_cast<uint64_t>(values[i]));
+            values[i] = value;
+        }
+    }
+}
+
+void ColumnarArchive::forEachBlock(int startDate, int endDate,
+                                   const std::function<void(const BlockInfo&, bool inside)>& onBlock) const {
+    if (!header_ || startDate > endDate) {
+        return;
+    }
+    // Blocks are in date order, so the first one ending on or after the start is found by bisection
+    size_t low = 0;
+    size_t high = header_->blockCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (block(middle).lastDate < startDate) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (size_t b = low; b < header_->blockCount && block(b).firstDate <= endDate; b++) {
+        const BlockInfo& info = block(b);
+        onBlock(info, info.firstDate >= startDate && info.lastDate <= endDate);
+    }
+}
+
+size_t ColumnarArchive::countBlocks(int startDate, int endDate) const {
+    size_t count = 0;
+    forEachBlock(startDate, endDate, [&](const BlockInfo&, bool) { count++; });
+    return count;
+}
+
+double ColumnarArchive::getTotalRevenue(int startDate, int endDate) const {
+    int64_t total = 0;
+    std::vector<int64_t> dates(BLOCK_ROWS);
+    std::vector<int64_t> prices(BLOCK_ROWS);
+    forEachBlock(startDate, endDate, [&](const BlockInfo& info, bool inside) {
+        if (inside) {
+            total += info.revenue;
+            return;
+        }
+        decode(info, ORDER_DATE, dates.data());
+        decode(info, PRICE, prices.data());
+        for (size_t i = 0; i < info.rows; i++) {
+            if (dates[i] >= startDate && dates[i] <= endDate) {
+                total += prices[i];
+            }
+        }
+    });
+    return total / PRICE_UNITS;
+}
+
+std::map<int, long long> ColumnarArchive::getCompositionQuantities(int startDate, int endDate) const {
+    // Composition ids are small and dense, so most counts are kept in a vector while scanning
+    std::vector<long long> counts;
+    std::vector<int64_t> dates(BLOCK_ROWS);
+    std::vector<int64_t> compositions(BLOCK_ROWS);
+    std::vector<int64_t> quantities(BLOCK_ROWS);
+    std::map<int, long long> quantitiesById;
+    forEachBlock(startDate, endDate, [&](const BlockInfo& info, bool inside) {
+        if (!inside) {
+            decode(info, ORDER_DATE, dates.data());
+        }
+        decode(info, COMPOSITION_ID, compositions.data());
+        decode(info, QUANTITY, quantities.data());
+        for (size_t i = 0; i < info.rows; i++) {
+            if (!inside && (dates[i] < startDate || dates[i] > endDate)) {
+                continue;
+            }
+            int64_t id = compositions[i];
+            if (id < 0 || id >= DENSE_COMPOSITION_IDS) {
+                quantitiesById[static_cast<int>(id)] += quantities[i];
+                continue;
+            }
+            if (static_cast<size_t>(id) >= counts.size()) {
+                counts.resize(id + 1, 0);
+            }
+            counts[id] += quantities[i];
+        }
+    });
+
+    for (size_t id = 0; id < counts.size(); id++) {
+        if (counts[id] != 0) {
+            quantitiesById[static_cast<int>(id)] += counts[id];
+        }
+    }
+    return quantitiesById;
+}
+
+std::map<std::string, std::map<std::string, int>> ColumnarArchive::getFlowerUsageByPeriod(
+    int startDate, int endDate, const std::vector<Database::RecipeLine>& recipes,
+    const std::vector<Database::Flower>& flowers) const {
+    std::map<int, const Database::Flower*> flowersById;
+    for (const auto& flower : flowers) {
+        flowersById[flower.id] = &flower;
+    }
+
+    std::map<std::string, std::map<std::string, int>> flowerUsage;
+    std::map<int, long long> quantities = getCompositionQuantities(startDate, endDate);
+    for (const auto& line : recipes) {
+        auto ordered = quantities.find(line.compositionId);
+        auto flower = flowersById.find(line.flowerId);
+        if (ordered == quantities.end() || flower == flowersById.end()) {
+            continue;
+        }
+        flowerUsage[flower->second->name][flower->second->variety] +=
+            static_cast<int>(ordered->second * line.quantity);
+    }
+    return flowerUsage;
+}
+
+void ColumnarArchive::forEachOrder(int startDate, int endDate,
+                                   const std::function<void(const Database::Order&, double totalPrice)>& onOrder) const {
+    std::vector<int64_t> columns[COLUMN_COUNT];
+    for (auto& values : columns) {
+        values.resize(BLOCK_ROWS);
+    }
+    forEachBlock(startDate, endDate, [&](const BlockInfo& info, bool) {
+        for (size_t c = 0; c < COLUMN_COUNT; c++) {
+            decode(info, c, columns[c].data());
+        }
+        for (size_t i = 0; i < info.rows; i++) {
+            int date = static_cast<int>(columns[ORDER_DATE][i]);
+            if (date < startDate || date > endDate) {
+                continue;
+            }
+            int64_t urgency = columns[URGENCY][i];
+            bool known = urgency >= 0 && urgency < static_cast<int64_t>(header_->urgencyCount);
+            Database::Order order{static_cast<int>(columns[ORDER_ID][i]),
+                                  static_cast<int>(columns[CUSTOMER_ID][i]),
+                                  static_cast<int>(columns[COMPOSITION_ID][i]),
+                                  date,
+                                  date + static_cast<int>(columns[LEAD_DAYS][i]),
+                                  static_cast<int>(columns[QUANTITY][i]),
+                                  known ? urgencyRates_[urgency] : 0.0};
+            onOrder(order, columns[PRICE][i] / PRICE_UNITS);
+        }
+    });
+}
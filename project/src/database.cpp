@@ -1,5 +1,9 @@
 #include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <set>
 #include <ctime>
 
 // Callback function for SQLite
@@ -15,40 +19,710 @@ static int callbackWrapper(void* data, int argc, char** argv, char** azColName)
     return 0;
 }
 
-Database::Database(const std::string& dbPath) : dbPath_(dbPath), db_(nullptr), connected_(false) {}
+// Schema migrations, applied in order by Database::migrate(). Each entry brings the
+// database to the given PRAGMA user_version and runs inside a single transaction.
+struct Migration {
+    int version;
+    const char* sql;
+};
+
+static const Migration MIGRATIONS[] = {
+    // 1: OrderDate/FulfillmentDate become INTEGER day numbers (days since 1970-01-01)
+    {1,
+     "CREATE TABLE Orders_new ("
+     "    OrderID INTEGER PRIMARY KEY AUTOINCREMENT,"
+     "    CustomerID INTEGER NOT NULL,"
+     "    CompositionID INTEGER NOT NULL,"
+     "    OrderDate INTEGER NOT NULL,"
+     "    FulfillmentDate INTEGER NOT NULL,"
+     "    Quantity INTEGER NOT NULL CHECK (Quantity > 0),"
+     "    UrgencyRate DECIMAL(4, 2) DEFAULT 0,"
+     "    FOREIGN KEY (CustomerID) REFERENCES Customers(CustomerID) ON DELETE RESTRICT,"
+     "    FOREIGN KEY (CompositionID) REFERENCES Compositions(CompositionID) ON DELETE RESTRICT,"
+     "    CHECK (FulfillmentDate >= OrderDate)"
+     ");"
+     "INSERT INTO Orders_new (OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate) "
+     "SELECT OrderID, CustomerID, CompositionID, "
+     "       CAST(julianday(OrderDate) - 2440587.5 AS INTEGER), "
+     "       CAST(julianday(FulfillmentDate) - 2440587.5 AS INTEGER), "
+     "       Quantity, UrgencyRate "
+     "FROM Orders;"
+     "DROP TABLE Orders;"
+     "ALTER TABLE Orders_new RENAME TO Orders;"
+     "CREATE INDEX idx_orders_orderdate ON Orders(OrderDate);"
+     "CREATE TRIGGER CalculateUrgencyRate "
+     "AFTER INSERT ON Orders "
+     "BEGIN "
+     "    UPDATE Orders "
+     "    SET UrgencyRate = CASE "
+     "        WHEN FulfillmentDate - OrderDate <= 1 THEN 0.25 "
+     "        WHEN FulfillmentDate - OrderDate <= 2 THEN 0.15 "
+     "        ELSE 0 "
+     "    END "
+     "    WHERE OrderID = NEW.OrderID; "
+     "END;"
+     "CREATE TRIGGER CalculateOrderPrice "
+     "AFTER INSERT ON Orders "
+     "BEGIN "
+     "    INSERT INTO OrderSummary (OrderID, BasePrice, UrgencyFee, TotalPrice) "
+     "    SELECT "
+     "        NEW.OrderID, "
+     "        COALESCE((SELECT SUM(f.Price * cf.Quantity * NEW.Quantity) "
+     "                  FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "                  WHERE cf.CompositionID = NEW.CompositionID), 0), "
+     "        COALESCE((SELECT SUM(f.Price * cf.Quantity * NEW.Quantity) * NEW.UrgencyRate "
+     "                  FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "                  WHERE cf.CompositionID = NEW.CompositionID), 0), "
+     "        COALESCE((SELECT SUM(f.Price * cf.Quantity * NEW.Quantity) * (1 + NEW.UrgencyRate) "
+     "                  FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "                  WHERE cf.CompositionID = NEW.CompositionID), 0); "
+     "END;"},
+
+    // 2: Per-composition unit cost maintained on price and recipe changes, so that
+    //    order pricing is a single primary key lookup instead of a recipe aggregate
+    {2,
+     "CREATE TABLE CompositionUnitCost ("
+     "    CompositionID INTEGER PRIMARY KEY,"
+     "    UnitCost DECIMAL(10, 2) NOT NULL,"
+     "    FOREIGN KEY (CompositionID) REFERENCES Compositions(CompositionID) ON DELETE CASCADE"
+     ");"
+     "INSERT INTO CompositionUnitCost (CompositionID, UnitCost) "
+     "SELECT cf.CompositionID, SUM(f.Price * cf.Quantity) "
+     "FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "GROUP BY cf.CompositionID;"
+     "CREATE INDEX idx_compositionflowers_flower ON CompositionFlowers(FlowerID);"
+     "CREATE TRIGGER RefreshUnitCostOnPriceChange "
+     "AFTER UPDATE OF Price ON Flowers "
+     "WHEN NEW.Price <> OLD.Price "
+     "BEGIN "
+     "    UPDATE CompositionUnitCost "
+     "    SET UnitCost = (SELECT SUM(f.Price * cf.Quantity) "
+     "                    FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "                    WHERE cf.CompositionID = CompositionUnitCost.CompositionID) "
+     "    WHERE CompositionID IN (SELECT CompositionID FROM CompositionFlowers WHERE FlowerID = NEW.FlowerID); "
+     "END;"
+     "CREATE TRIGGER RefreshUnitCostOnRecipeInsert "
+     "AFTER INSERT ON CompositionFlowers "
+     "BEGIN "
+     "    REPLACE INTO CompositionUnitCost (CompositionID, UnitCost) "
+     "    SELECT cf.CompositionID, SUM(f.Price * cf.Quantity) "
+     "    FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "    WHERE cf.CompositionID = NEW.CompositionID "
+     "    GROUP BY cf.CompositionID; "
+     "END;"
+     "CREATE TRIGGER RefreshUnitCostOnRecipeUpdate "
+     "AFTER UPDATE ON CompositionFlowers "
+     "BEGIN "
+     "    DELETE FROM CompositionUnitCost WHERE CompositionID IN (OLD.CompositionID, NEW.CompositionID); "
+     "    INSERT INTO CompositionUnitCost (CompositionID, UnitCost) "
+     "    SELECT cf.CompositionID, SUM(f.Price * cf.Quantity) "
+     "    FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "    WHERE cf.CompositionID IN (OLD.CompositionID, NEW.CompositionID) "
+     "    GROUP BY cf.CompositionID; "
+     "END;"
+     "CREATE TRIGGER RefreshUnitCostOnRecipeDelete "
+     "AFTER DELETE ON CompositionFlowers "
+     "BEGIN "
+     "    DELETE FROM CompositionUnitCost WHERE CompositionID = OLD.CompositionID; "
+     "    INSERT INTO CompositionUnitCost (CompositionID, UnitCost) "
+     "    SELECT cf.CompositionID, SUM(f.Price * cf.Quantity) "
+     "    FROM CompositionFlowers cf JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+     "    WHERE cf.CompositionID = OLD.CompositionID "
+     "    GROUP BY cf.CompositionID; "
+     "END;"
+     "DROP TRIGGER CalculateOrderPrice;"
+     "CREATE TRIGGER CalculateOrderPrice "
+     "AFTER INSERT ON Orders "
+     "BEGIN "
+     "    INSERT INTO OrderSummary (OrderID, BasePrice, UrgencyFee, TotalPrice) "
+     "    SELECT NEW.OrderID, "
+     "           c.UnitCost * NEW.Quantity, "
+     "           c.UnitCost * NEW.Quantity * NEW.UrgencyRate, "
+     "           c.UnitCost * NEW.Quantity * (1 + NEW.UrgencyRate) "
+     "    FROM (SELECT COALESCE((SELECT UnitCost FROM CompositionUnitCost "
+     "                           WHERE CompositionID = NEW.CompositionID), 0) AS UnitCost) c; "
+     "END;"},
+
+    // 3: UrgencyRate is computed by createOrder and written by the INSERT itself
+    {3,
+     "DROP TRIGGER CalculateUrgencyRate;"},
+
+    // 4: Full-text indexes for customer and composition lookup. PhoneDigits keeps the phone
+    //    number without punctuation so that "7900123" finds "+7(900)123-45-67".
+    {4,
+     "CREATE VIRTUAL TABLE CustomerSearch USING fts5(CustomerName, PhoneNumber, PhoneDigits, Email);"
+     "INSERT INTO CustomerSearch (rowid, CustomerName, PhoneNumber, PhoneDigits, Email) "
+     "SELECT CustomerID, CustomerName, PhoneNumber, replace(replace(replace(replace(replace(PhoneNumber, '+', ''), '(', ''), ')', ''), '-', ''), ' ', ''), Email FROM Customers;"
+     "CREATE TRIGGER IndexCustomerOnInsert "
+     "AFTER INSERT ON Customers "
+     "BEGIN "
+     "    INSERT INTO CustomerSearch (rowid, CustomerName, PhoneNumber, PhoneDigits, Email) "
+     "    VALUES (NEW.CustomerID, NEW.CustomerName, NEW.PhoneNumber, replace(replace(replace(replace(replace(NEW.PhoneNumber, '+', ''), '(', ''), ')', ''), '-', ''), ' ', ''), NEW.Email); "
+     "END;"
+     "CREATE TRIGGER IndexCustomerOnUpdate "
+     "AFTER UPDATE ON Customers "
+     "BEGIN "
+     "    DELETE FROM CustomerSearch WHERE rowid = OLD.CustomerID; "
+     "    INSERT INTO CustomerSearch (rowid, CustomerName, PhoneNumber, PhoneDigits, Email) "
+     "    VALUES (NEW.CustomerID, NEW.CustomerName, NEW.PhoneNumber, replace(replace(replace(replace(replace(NEW.PhoneNumber, '+', ''), '(', ''), ')', ''), '-', ''), ' ', ''), NEW.Email); "
+     "END;"
+     "CREATE TRIGGER IndexCustomerOnDelete "
+     "AFTER DELETE ON Customers "
+     "BEGIN "
+     "    DELETE FROM CustomerSearch WHERE rowid = OLD.CustomerID; "
+     "END;"
+     "CREATE VIRTUAL TABLE CompositionSearch USING fts5(CompositionName, Description);"
+     "INSERT INTO CompositionSearch (rowid, CompositionName, Description) "
+     "SELECT CompositionID, CompositionName, Description FROM Compositions;"
+     "CREATE TRIGGER IndexCompositionOnInsert "
+     "AFTER INSERT ON Compositions "
+     "BEGIN "
+     "    INSERT INTO CompositionSearch (rowid, CompositionName, Description) "
+     "    VALUES (NEW.CompositionID, NEW.CompositionName, NEW.Description); "
+     "END;"
+     "CREATE TRIGGER IndexCompositionOnUpdate "
+     "AFTER UPDATE ON Compositions "
+     "BEGIN "
+     "    DELETE FROM CompositionSearch WHERE rowid = OLD.CompositionID; "
+     "    INSERT INTO CompositionSearch (rowid, CompositionName, Description) "
+     "    VALUES (NEW.CompositionID, NEW.CompositionName, NEW.Description); "
+     "END;"
+     "CREATE TRIGGER IndexCompositionOnDelete "
+     "AFTER DELETE ON Compositions "
+     "BEGIN "
+     "    DELETE FROM CompositionSearch WHERE rowid = OLD.CompositionID; "
+     "END;"},
+
+    // 5: Sequence number of the last order journal entry applied to this database
+    {5,
+     "CREATE TABLE OrderJournalState ("
+     "    JournalID INTEGER PRIMARY KEY CHECK (JournalID = 1),"
+     "    AppliedSequence INTEGER NOT NULL"
+     ");"
+     "INSERT INTO OrderJournalState (JournalID, AppliedSequence) VALUES (1, 0);"},
+    // 6: Per-composition sales kept up to date incrementally. Orders up to LastOrderID are
+    // folded in; OrderIDs are AUTOINCREMENT, so anything newer has a higher ID.
+    {6,
+     "CREATE TABLE CompositionSales ("
+     "    CompositionID INTEGER PRIMARY KEY,"
+     "    OrderCount INTEGER NOT NULL,"
+     "    TotalRevenue REAL NOT NULL"
+     ");"
+     "CREATE TABLE CompositionSalesWatermark ("
+     "    WatermarkID INTEGER PRIMARY KEY CHECK (WatermarkID = 1),"
+     "    LastOrderID INTEGER NOT NULL"
+     ");"
+     "INSERT INTO CompositionSales (CompositionID, OrderCount, TotalRevenue) "
+     "SELECT o.CompositionID, COUNT(*), SUM(os.TotalPrice) "
+     "FROM Orders o JOIN OrderSummary os ON os.OrderID = o.OrderID "
+     "GROUP BY o.CompositionID;"
+     "INSERT INTO CompositionSalesWatermark (WatermarkID, LastOrderID) "
+     "SELECT 1, COALESCE(MAX(OrderID), 0) FROM Orders;"},
+    // 7: Catalog of the per-year order archives (see Database::archiveYear)
+    {7,
+     "CREATE TABLE OrderArchives ("
+     "    Year INTEGER PRIMARY KEY,"
+     "    FileName TEXT NOT NULL,"
+     "    FirstOrderDate INTEGER NOT NULL,"
+     "    LastOrderDate INTEGER NOT NULL,"
+     "    LastFulfillmentDate INTEGER NOT NULL,"
+     "    FirstOrderID INTEGER NOT NULL,"
+     "    LastOrderID INTEGER NOT NULL,"
+     "    OrderCount INTEGER NOT NULL"
+     ");"},
+};
+
+// Sales per composition of the orders not yet folded into CompositionSales. The WHERE
+// clause also keeps the SELECT unambiguous in front of an upsert's ON CONFLICT.
+static const char* NEW_COMPOSITION_SALES_SQL =
+    "SELECT o.CompositionID, COUNT(*), SUM(os.TotalPrice) "
+    "FROM Orders o JOIN OrderSummary os ON os.OrderID = o.OrderID "
+    "WHERE o.OrderID > (SELECT LastOrderID FROM CompositionSalesWatermark) "
+    "GROUP BY o.CompositionID";
+
+// Folds the new orders into CompositionSales and moves the watermark past them; runs
+// inside the caller's transaction
+static const std::string FOLD_COMPOSITION_SALES_SQL =
+    "INSERT INTO CompositionSales (CompositionID, OrderCount, TotalRevenue) " +
+    std::string(NEW_COMPOSITION_SALES_SQL) + " "
+    "ON CONFLICT (CompositionID) DO UPDATE SET "
+    "    OrderCount = OrderCount + excluded.OrderCount, "
+    "    TotalRevenue = TotalRevenue + excluded.TotalRevenue;"
+    "UPDATE CompositionSalesWatermark "
+    "SET LastOrderID = (SELECT MAX(OrderID) FROM Orders) "
+    "WHERE (SELECT MAX(OrderID) FROM Orders) > LastOrderID;";
+
+// Schema of an archive file: the order tables with their date index, without the
+// triggers and foreign keys, as nothing is ever inserted into an archive once written
+static const char* ARCHIVE_SCHEMA_SQL =
+    "CREATE TABLE Orders ("
+    "    OrderID INTEGER PRIMARY KEY,"
+    "    CustomerID INTEGER NOT NULL,"
+    "    CompositionID INTEGER NOT NULL,"
+    "    OrderDate INTEGER NOT NULL,"
+    "    FulfillmentDate INTEGER NOT NULL,"
+    "    Quantity INTEGER NOT NULL,"
+    "    UrgencyRate DECIMAL(4, 2) DEFAULT 0"
+    ");"
+    "CREATE INDEX idx_orders_orderdate ON Orders(OrderDate);"
+    "CREATE TABLE OrderSummary ("
+    "    OrderID INTEGER PRIMARY KEY,"
+    "    BasePrice DECIMAL(10, 2) NOT NULL,"
+    "    UrgencyFee DECIMAL(10, 2) NOT NULL,"
+    "    TotalPrice DECIMAL(10, 2) NOT NULL"
+    ");";
+
+static const char* ORDER_ARCHIVES_SQL =
+    "SELECT Year, FileName, FirstOrderDate, LastOrderDate, LastFulfillmentDate, FirstOrderID, LastOrderID, OrderCount "
+    "FROM OrderArchives ORDER BY Year";
+
+// Pages copied per sqlite3_backup_step when refreshing the report snapshot; the source
+// file is only read-locked for the duration of one step
+static const int SNAPSHOT_PAGES_PER_STEP = 256;
+
+// Approximate heap footprint of cached report results
+static size_t approximateSize(double) {
+    return sizeof(double);
+}
+
+static size_t approximateSize(const std::vector<std::pair<int, int>>& stats) {
+    return sizeof(stats) + stats.size() * sizeof(std::pair<int, int>);
+}
+
+static size_t approximateSize(const std::map<std::string, std::map<std::string, int>>& usage) {
+    const size_t nodeOverhead = 48;
+    size_t size = sizeof(usage);
+    for (const auto& [flowerName, varieties] : usage) {
+        size += nodeOverhead + sizeof(std::string) + flowerName.capacity() + sizeof(varieties);
+        for (const auto& [variety, quantity] : varieties) {
+            size += nodeOverhead + sizeof(std::string) + variety.capacity() + sizeof(quantity);
+        }
+    }
+    return size;
+}
+
+static size_t approximateSize(const std::map<std::string, std::pair<int, double>>& summary) {
+    const size_t nodeOverhead = 48;
+    size_t size = sizeof(summary);
+    for (const auto& entry : summary) {
+        size += nodeOverhead + sizeof(entry) + entry.first.capacity();
+    }
+    return size;
+}
+
+static size_t approximateSize(const std::vector<Database::RevenueBucket>& series) {
+    return sizeof(series) + series.size() * sizeof(Database::RevenueBucket);
+}
+
+template <typename Row>
+static size_t approximateSize(const Database::ResultSet<Row>& result) {
+    return sizeof(result) + result.rows.capacity() * sizeof(Row) + (result.arena ? result.arena->bytesUsed() : 0);
+}
+
+// Page queries select one row more than requested to learn whether more rows follow
+template <typename Row>
+static void finishPage(Database::Page<Row>& page, int pageSize) {
+    if (static_cast<int>(page.rows.size()) > pageSize) {
+        page.rows.pop_back();
+        page.hasMore = true;
+    }
+}
+
+// Turns free text into an FTS5 query: every whitespace-separated term becomes a quoted
+// prefix match and all terms must match. Returns an empty string when there are no terms.
+static std::string ftsPrefixQuery(const std::string& text) {
+    std::string query;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t start = text.find_first_not_of(" \t", pos);
+        if (start == std::string::npos) {
+            break;
+        }
+        size_t end = text.find_first_of(" \t", start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        std::string term = "\"";
+        for (size_t i = start; i < end; i++) {
+            term += text[i];
+            if (text[i] == '"') {
+                term += '"';
+            }
+        }
+        term += "\"*";
+        query += (query.empty() ? "" : " ") + term;
+        pos = end;
+    }
+    return query;
+}
+
+// Order columns in the order OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate,
+// Quantity, UrgencyRate
+static Database::Order readOrder(sqlite3_stmt* stmt) {
+    return {sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 2),
+            sqlite3_column_int(stmt, 3), sqlite3_column_int(stmt, 4), sqlite3_column_int(stmt, 5),
+            sqlite3_column_double(stmt, 6)};
+}
+
+// "file:" URI for a path, percent-encoding everything but unreserved characters and '/'
+static std::string fileUri(const std::string& path) {
+    static const char* HEX = "0123456789ABCDEF";
+    std::string uri = "file:";
+    for (unsigned char c : path) {
+        if (std::isalnum(c) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~') {
+            uri += static_cast<char>(c);
+        } else {
+            uri += '%';
+            uri += HEX[c >> 4];
+            uri += HEX[c & 15];
+        }
+    }
+    return uri;
+}
+
+// Quotes a value as an SQL string literal
+static std::string sqlLiteral(const std::string& value) {
+    std::string literal = "'";
+    for (char c : value) {
+        literal += c;
+        if (c == '\'') {
+            literal += '\'';
+        }
+    }
+    return literal + "'";
+}
+
+static std::string_view columnText(sqlite3_stmt* stmt, int column) {
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+    return text ? std::string_view(text, sqlite3_column_bytes(stmt, column)) : std::string_view();
+}
+
+Database::Database(const std::string& dbPath, const DatabaseOptions& options)
+    : dbPath_(dbPath), options_(options), db_(nullptr), connected_(false),
+      snapshot_(nullptr), snapshotEnabled_(false), snapshotMaxAge_(0), snapshotWriteLimit_(0),
+      writesSinceSnapshot_(0), snapshotGeneration_(0), reportCache_(DEFAULT_REPORT_CACHE_BUDGET),
+      writeGeneration_(0), dataVersion_(-1), customerCache_(DEFAULT_CUSTOMER_CACHE_SIZE),
+      nextListenerId_(1), ordersSinceSalesFold_(0), tracing_(false) {}
 
 Database::~Database() {
     disconnect();
 }
 
 bool Database::connect() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (connected_) {
         return true;
     }
     
-    int rc = sqlite3_open(dbPath_.c_str(), &db_);
+    int rc;
+    if (options_.readOnly || options_.immutable) {
+        // The URI form is needed for immutable=1, which skips locking and change detection
+        std::string uri = fileUri(dbPath_) + "?mode=ro" + (options_.immutable ? "&immutable=1" : "");
+        rc = sqlite3_open_v2(uri.c_str(), &db_, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr);
+    } else {
+        rc = sqlite3_open(dbPath_.c_str(), &db_);
+    }
     if (rc) {
         std::cerr << "Can't open database: " << sqlite3_errmsg(db_) << std::endl;
+        sqlite3_close(db_);
+        db_ = nullptr;
         return false;
     }
     
     connected_ = true;
+    if (tracing_) {
+        sqlite3_trace_v2(db_, SQLITE_TRACE_STMT, traceCallback, this);
+    }
+
+    for (const auto& pragma : options_.pragmas()) {
+        if (!executeSQL(pragma)) {
+            disconnect();
+            return false;
+        }
+    }
+
+    if (!migrate()) {
+        std::cerr << "Can't migrate database schema" << std::endl;
+        disconnect();
+        return false;
+    }
+
+    // Other connections and bulk loads may have left the aggregate far behind
+    foldCompositionSalesIfBehind();
     return true;
 }
 
 void Database::disconnect() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (connected_ && db_) {
+        closeSnapshot();
+        finalizeStatements(nullptr);
+        for (const auto& entry : archiveHandles_) {
+            sqlite3_close(entry.second);
+        }
+        archiveHandles_.clear();
         sqlite3_close(db_);
         db_ = nullptr;
         connected_ = false;
+        reportCache_.clear();
+        customerCache_.clear();
+        dataVersion_ = -1;
     }
 }
 
 bool Database::isConnected() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     return connected_;
 }
 
-bool Database::authenticateUser(const std::string& username, const std::string& password) {    
+const DatabaseOptions& Database::getOptions() const {
+    return options_;
+}
+
+void Database::setReportCacheBudget(size_t bytes) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    reportCache_.setCapacity(bytes);
+}
+
+LruCacheStats Database::getReportCacheStats() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return reportCache_.stats();
+}
+
+void Database::setCustomerCacheSize(size_t entries) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    customerCache_.setCapacity(entries);
+}
+
+LruCacheStats Database::getCustomerCacheStats() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return customerCache_.stats();
+}
+
+bool Database::enableReportSnapshot(int maxAgeSeconds, int writesBeforeRefresh) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    snapshotEnabled_ = true;
+    snapshotMaxAge_ = std::chrono::seconds(maxAgeSeconds);
+    snapshotWriteLimit_ = writesBeforeRefresh;
+    reportCache_.clear();
+    return !connected_ || refreshReportSnapshot();
+}
+
+void Database::disableReportSnapshot() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    snapshotEnabled_ = false;
+    closeSnapshot();
+    reportCache_.clear();
+}
+
+bool Database::hasReportSnapshot() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return snapshot_ != nullptr;
+}
+
+bool Database::refreshReportSnapshot() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!connected_ || !snapshotEnabled_) {
+        return false;
+    }
+
+    if (!snapshot_ && sqlite3_open(":memory:", &snapshot_) != SQLITE_OK) {
+        std::cerr << "Can't open report snapshot: " << sqlite3_errmsg(snapshot_) << std::endl;
+        closeSnapshot();
+        return false;
+    }
+
+    sqlite3_backup* backup = sqlite3_backup_init(snapshot_, "main", db_, "main");
+    if (!backup) {
+        std::cerr << "Can't start snapshot backup: " << sqlite3_errmsg(snapshot_) << std::endl;
+        return false;
+    }
+
+    int rc;
+    do {
+        rc = sqlite3_backup_step(backup, SNAPSHOT_PAGES_PER_STEP);
+        if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+            sqlite3_sleep(5);
+        }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+    sqlite3_backup_finish(backup);
+
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Report snapshot refresh failed: " << sqlite3_errstr(rc) << std::endl;
+        closeSnapshot();
+        return false;
+    }
+
+    snapshotTakenAt_ = std::chrono::steady_clock::now();
+    writesSinceSnapshot_ = 0;
+    snapshotGeneration_++;
+    return true;
+}
+
+void Database::closeSnapshot() {
+    if (snapshot_) {
+        finalizeStatements(snapshot_);
+        sqlite3_close(snapshot_);
+        snapshot_ = nullptr;
+    }
+}
+
+sqlite3* Database::reportHandle() {
+    if (!snapshotEnabled_ || !connected_) {
+        return db_;
+    }
+
+    bool stale = !snapshot_ ||
+                 std::chrono::steady_clock::now() - snapshotTakenAt_ >= snapshotMaxAge_ ||
+                 (snapshotWriteLimit_ > 0 && writesSinceSnapshot_ >= snapshotWriteLimit_);
+    if (stale && !refreshReportSnapshot()) {
+        return db_;
+    }
+
+    return snapshot_;
+}
+
+void Database::setStatementTracing(bool enabled) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    tracing_ = enabled;
+    if (connected_) {
+        sqlite3_trace_v2(db_, enabled ? SQLITE_TRACE_STMT : 0, enabled ? traceCallback : nullptr, this);
+    }
+}
+
+std::vector<std::string> Database::takeTracedStatements() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<std::string> statements;
+    statements.swap(tracedStatements_);
+    return statements;
+}
+
+int Database::traceCallback(unsigned type, void* context, void*, void* sql) {
+    const char* text = static_cast<const char*>(sql);
+    // Trigger invocations are reported as "-- TRIGGER name" comments
+    if (type == SQLITE_TRACE_STMT && text && std::string(text).compare(0, 2, "--") != 0) {
+        static_cast<Database*>(context)->tracedStatements_.push_back(text);
+    }
+    return 0;
+}
+
+std::vector<std::string> Database::explainQueryPlan(const std::string& sql) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<std::string> plan;
+    forEachRow(db_, "EXPLAIN QUERY PLAN " + sql, [&](sqlite3_stmt* stmt) {
+        plan.push_back(std::string(columnText(stmt, 3)));
+    });
+    return plan;
+}
+
+std::string Database::reportVersion() {
+    // Snapshot contents only change on refresh, so the refresh count versions the cache.
+    // The two counters are unrelated, hence the prefix: snapshot refresh 3 and write
+    // generation 3 are different data.
+    if (snapshotEnabled_ && reportHandle() == snapshot_) {
+        return "snap:" + std::to_string(snapshotGeneration_);
+    }
+
+    checkExternalWrites();
+    return "live:" + std::to_string(writeGeneration_);
+}
+
+void Database::checkExternalWrites() {
+    // Writes by other connections do not go through createOrder/updateFlowerPrice;
+    // PRAGMA data_version changes whenever one of them has committed to the file.
+    std::vector<std::vector<std::string>> results;
+    if (executeSQLWithCallback("PRAGMA data_version", callbackWrapper, &results) && !results.empty()) {
+        long long version = std::stoll(results[0][0]);
+        if (version != dataVersion_) {
+            dataVersion_ = version;
+            writeGeneration_++;
+            // Any of those writes may have changed a customer
+            customerCache_.clear();
+        }
+    }
+}
+
+template <typename T, typename Compute>
+T Database::cachedReport(const std::string& key, Compute compute) {
+    std::string versionedKey = reportVersion() + "|" + key;
+
+    std::any cached;
+    if (reportCache_.get(versionedKey, cached)) {
+        return std::any_cast<const T&>(cached);
+    }
+
+    T result = compute();
+    size_t cost = versionedKey.size() + approximateSize(result);
+    reportCache_.put(versionedKey, result, cost);
+    return result;
+}
+
+// Reads PRAGMA user_version
+static bool schemaVersion(sqlite3* db, int& version) {
+    std::vector<std::vector<std::string>> results;
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, "PRAGMA user_version", callbackWrapper, &results, &errMsg) != SQLITE_OK || results.empty()) {
+        std::cerr << "SQL error: " << (errMsg ? errMsg : "no schema version") << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    version = std::stoi(results[0][0]);
+    return true;
+}
+
+bool Database::migrate() {
+    int version;
+    if (!schemaVersion(db_, version)) {
+        return false;
+    }
+
+    int latest = MIGRATIONS[sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0]) - 1].version;
+    if (options_.readOnly || options_.immutable) {
+        if (version != latest) {
+            std::cerr << "Database schema version " << version << " does not match " << latest
+                      << "; open it read-write once to upgrade" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    for (const auto& migration : MIGRATIONS) {
+        if (migration.version <= version) {
+            continue;
+        }
+
+        // Another connection may be migrating the same file; the version is checked again
+        // under the write lock so that each step runs once
+        if (!executeSQL("BEGIN IMMEDIATE")) {
+            return false;
+        }
+        if (!schemaVersion(db_, version)) {
+            executeSQL("ROLLBACK");
+            return false;
+        }
+        if (migration.version <= version) {
+            executeSQL("COMMIT");
+            continue;
+        }
+
+        std::string sql = std::string(migration.sql) +
+                          "PRAGMA user_version = " + std::to_string(migration.version) + ";"
+                          "COMMIT;";
+        if (!executeSQL(sql)) {
+            if (!sqlite3_get_autocommit(db_)) {
+                executeSQL("ROLLBACK");
+            }
+            return false;
+        }
+        version = migration.version;
+    }
+
+    return true;
+}
+
+bool Database::authenticateUser(const std::string& username, const std::string& password) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string sql = "SELECT CustomerID FROM Customers WHERE CustomerName = '" + username + "'";
     std::vector<std::vector<std::string>> results;
     
@@ -58,6 +732,7 @@ bool Database::authenticateUser(const std::string& username, const std::string&
 }
 
 std::vector<Database::Flower> Database::getAllFlowers() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::vector<Flower> flowers;
     std::string sql = "SELECT FlowerID, FlowerName, Variety, Price FROM Flowers";
     std::vector<std::vector<std::string>> results;
@@ -78,7 +753,22 @@ std::vector<Database::Flower> Database::getAllFlowers() {
     return flowers;
 }
 
+Database::ResultSet<Database::FlowerView> Database::getFlowerTable() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    ResultSet<FlowerView> flowers{std::make_shared<StringArena>(), {}};
+    StringArena& arena = *flowers.arena;
+    std::string sql = "SELECT FlowerID, FlowerName, Variety, Price FROM Flowers";
+    
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        flowers.rows.push_back({sqlite3_column_int(stmt, 0), arena.intern(columnText(stmt, 1)),
+                                arena.intern(columnText(stmt, 2)), sqlite3_column_double(stmt, 3)});
+    });
+    
+    return flowers;
+}
+
 bool Database::updateFlowerPrice(int flowerId, double newPrice) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     // Get current price
     std::string checkSql = "SELECT Price FROM Flowers WHERE FlowerID = " + std::to_string(flowerId);
     std::vector<std::vector<std::string>> results;
@@ -89,7 +779,7 @@ bool Database::updateFlowerPrice(int flowerId, double newPrice) {
     
     double currentPrice = std::stod(results[0][0]);
    
-    if (newPrice > currentPrice * 1.1) {
+    if (newPrice > currentPrice * MAX_PRICE_INCREASE) {
         std::cout << "Price increase cannot exceed 10%" << std::endl;
         return false;
     }
@@ -97,10 +787,17 @@ bool Database::updateFlowerPrice(int flowerId, double newPrice) {
     std::string sql = "UPDATE Flowers SET Price = " + std::to_string(newPrice) + 
                       " WHERE FlowerID = " + std::to_string(flowerId);
     
-    return executeSQL(sql);
+    if (!executeSQL(sql)) {
+        return false;
+    }
+    
+    writeGeneration_++;
+    writesSinceSnapshot_++;
+    return true;
 }
 
 std::vector<Database::Composition> Database::getAllCompositions() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::vector<Composition> compositions;
     std::string sql = "SELECT CompositionID, CompositionName, Description FROM Compositions";
     std::vector<std::vector<std::string>> results;
@@ -120,7 +817,29 @@ std::vector<Database::Composition> Database::getAllCompositions() {
     return compositions;
 }
 
+std::vector<Database::Composition> Database::searchCompositions(const std::string& query, int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<Composition> compositions;
+    std::string match = ftsPrefixQuery(query);
+    if (match.empty()) {
+        return compositions;
+    }
+    
+    std::string sql = "SELECT c.CompositionID, c.CompositionName, c.Description "
+                      "FROM CompositionSearch s JOIN Compositions c ON c.CompositionID = s.rowid "
+                      "WHERE CompositionSearch MATCH " + sqlLiteral(match) +
+                      " ORDER BY s.rank LIMIT " + std::to_string(limit);
+    
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        compositions.push_back({sqlite3_column_int(stmt, 0), std::string(columnText(stmt, 1)),
+                                std::string(columnText(stmt, 2))});
+    });
+    
+    return compositions;
+}
+
 std::map<int, int> Database::getCompositionFlowers(int compositionId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::map<int, int> flowerQuantities;
     std::string sql = "SELECT FlowerID, Quantity FROM CompositionFlowers WHERE CompositionID = " + 
                       std::to_string(compositionId);
@@ -139,26 +858,50 @@ std::map<int, int> Database::getCompositionFlowers(int compositionId) {
     return flowerQuantities;
 }
 
+std::vector<Database::RecipeLine> Database::getRecipeLines() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<RecipeLine> lines;
+    std::string sql = "SELECT CompositionID, FlowerID, Quantity FROM CompositionFlowers ORDER BY CompositionID, FlowerID";
+    
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        lines.push_back({sqlite3_column_int(stmt, 0), sqlite3_column_int(stmt, 1), sqlite3_column_int(stmt, 2)});
+    });
+    
+    return lines;
+}
+
 Database::Composition Database::getMostPopularComposition() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     Composition mostPopular;
     std::string sql = "SELECT c.CompositionID, c.CompositionName, c.Description, COUNT(o.OrderID) as OrderCount "
                       "FROM Compositions c "
                       "JOIN Orders o ON c.CompositionID = o.CompositionID "
-                      "GROUP BY c.CompositionID "
-                      "ORDER BY OrderCount DESC LIMIT 1";
+                      "GROUP BY c.CompositionID";
     
     std::vector<std::vector<std::string>> results;
+    for (sqlite3* partition : orderPartitions(reportHandle(), [](const OrderArchive&) { return true; })) {
+        executeQuery(partition, sql, callbackWrapper, &results);
+    }
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results) && !results.empty()) {
-        mostPopular.id = std::stoi(results[0][0]);
-        mostPopular.name = results[0][1];
-        mostPopular.description = results[0][2];
+    // Counts per composition over all partitions; ties go to the lowest id
+    std::map<int, int> orderCounts;
+    int bestCount = 0;
+    for (const auto& row : results) {
+        int compositionId = std::stoi(row[0]);
+        int count = orderCounts[compositionId] += std::stoi(row[3]);
+        if (count > bestCount || (count == bestCount && compositionId < mostPopular.id)) {
+            bestCount = count;
+            mostPopular.id = compositionId;
+            mostPopular.name = row[1];
+            mostPopular.description = row[2];
+        }
     }
     
     return mostPopular;
 }
 
 std::vector<Database::Customer> Database::getAllCustomers() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::vector<Customer> customers;
     std::string sql = "SELECT CustomerID, CustomerName, PhoneNumber, Email FROM Customers";
     std::vector<std::vector<std::string>> results;
@@ -179,189 +922,771 @@ std::vector<Database::Customer> Database::getAllCustomers() {
     return customers;
 }
 
-Database::Customer Database::getCustomerById(int customerId) {
-    Customer customer;
-    std::string sql = "SELECT CustomerID, CustomerName, PhoneNumber, Email FROM Customers WHERE CustomerID = " + 
-                      std::to_string(customerId);
-    std::vector<std::vector<std::string>> results;
+Database::ResultSet<Database::CustomerView> Database::getCustomerTable() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    ResultSet<CustomerView> customers{std::make_shared<StringArena>(), {}};
+    StringArena& arena = *customers.arena;
+    std::string sql = "SELECT CustomerID, CustomerName, PhoneNumber, Email FROM Customers";
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results) && !results.empty()) {
-        customer.id = std::stoi(results[0][0]);
-        customer.name = results[0][1];
-        customer.phone = results[0][2];
-        customer.email = results[0][3];
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        customers.rows.push_back({sqlite3_column_int(stmt, 0), arena.intern(columnText(stmt, 1)),
+                                  arena.store(columnText(stmt, 2)), arena.store(columnText(stmt, 3))});
+    });
+    
+    return customers;
+}
+
+Database::Customer Database::getCustomerById(int customerId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Customer customer{};
+    auto found = getCustomersByIds({customerId});
+    if (!found.empty()) {
+        customer = found.begin()->second;
     }
     
     return customer;
 }
 
-bool Database::createOrder(int customerId, int compositionId, const std::string& orderDate, 
-                          const std::string& fulfillmentDate, int quantity) {
+std::map<int, Database::Customer> Database::getCustomersByIds(const std::vector<int>& customerIds) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::map<int, Customer> customers;
+    std::vector<int> missing;
+    
+    checkExternalWrites();
+    std::set<int> uniqueIds(customerIds.begin(), customerIds.end());
+    for (int customerId : uniqueIds) {
+        Customer customer;
+        if (customerCache_.get(customerId, customer)) {
+            customers[customerId] = customer;
+        } else {
+            missing.push_back(customerId);
+        }
+    }
+    
+    // Keep each statement to a reasonable length for very large batches
+    const size_t BATCH_SIZE = 500;
+    for (size_t first = 0; first < missing.size(); first += BATCH_SIZE) {
+        std::string sql = "SELECT CustomerID, CustomerName, PhoneNumber, Email FROM Customers WHERE CustomerID IN (";
+        for (size_t i = first; i < missing.size() && i < first + BATCH_SIZE; i++) {
+            if (i > first) {
+                sql += ", ";
+            }
+            sql += std::to_string(missing[i]);
+        }
+        sql += ")";
+        
+        forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+            Customer customer{sqlite3_column_int(stmt, 0), std::string(columnText(stmt, 1)),
+                              std::string(columnText(stmt, 2)), std::string(columnText(stmt, 3))};
+            customerCache_.put(customer.id, customer);
+            customers[customer.id] = std::move(customer);
+        });
+    }
+    
+    return customers;
+}
+
+std::vector<Database::Customer> Database::searchCustomers(const std::string& query, int limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<Customer> customers;
+    std::string match = ftsPrefixQuery(query);
+    if (match.empty()) {
+        return customers;
+    }
+    
+    std::string sql = "SELECT c.CustomerID, c.CustomerName, c.PhoneNumber, c.Email "
+                      "FROM CustomerSearch s JOIN Customers c ON c.CustomerID = s.rowid "
+                      "WHERE CustomerSearch MATCH " + sqlLiteral(match) +
+                      " ORDER BY s.rank LIMIT " + std::to_string(limit);
+    
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        customers.push_back({sqlite3_column_int(stmt, 0), std::string(columnText(stmt, 1)),
+                             std::string(columnText(stmt, 2)), std::string(columnText(stmt, 3))});
+    });
+    
+    return customers;
+}
+
+double Database::urgencyRateFor(int orderDate, int fulfillmentDate) {
+    int leadDays = fulfillmentDate - orderDate;
+    if (leadDays <= 1) {
+        return 0.25;
+    }
+    if (leadDays <= 2) {
+        return 0.15;
+    }
+    return 0.0;
+}
+
+bool Database::createOrder(int customerId, int compositionId, int orderDate, int fulfillmentDate, int quantity) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::string sql = "INSERT INTO Orders (CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate) "
                       "VALUES (" + std::to_string(customerId) + ", " +
-                                   std::to_string(compositionId) + ", '" +
-                                   orderDate + "', '" +
-                                   fulfillmentDate + "', " +
-                                   std::to_string(quantity) + ", 0)";
+                                   std::to_string(compositionId) + ", " +
+                                   std::to_string(orderDate) + ", " +
+                                   std::to_string(fulfillmentDate) + ", " +
+                                   std::to_string(quantity) + ", " +
+                                   std::to_string(urgencyRateFor(orderDate, fulfillmentDate)) + ")";
     
-    return executeSQL(sql);
+    if (!executeSQL(sql)) {
+        return false;
+    }
+    
+    writeGeneration_++;
+    writesSinceSnapshot_++;
+    
+    if (!orderListeners_.empty()) {
+        Order order{static_cast<int>(sqlite3_last_insert_rowid(db_)), customerId, compositionId, orderDate,
+                    fulfillmentDate, quantity, urgencyRateFor(orderDate, fulfillmentDate)};
+        for (const auto& entry : orderListeners_) {
+            entry.second(order);
+        }
+    }
+    foldCompositionSalesIfDue(1);
+    return true;
 }
 
-std::vector<Database::Order> Database::getOrdersByDate(const std::string& date) {
-    std::vector<Order> orders;
-    std::string sql = "SELECT OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate "
-                      "FROM Orders WHERE OrderDate = '" + date + "'";
-    std::vector<std::vector<std::string>> results;
+bool Database::applyJournaledOrders(const std::vector<NewOrder>& orders, uint64_t lastSequence) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    // IMMEDIATE takes the write lock up front, so a busy database fails here and not halfway
+    if (!executeSQL("BEGIN IMMEDIATE")) {
+        return false;
+    }
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results)) {
-        for (const auto& row : results) {
-            if (row.size() >= 7) {
-                Order order;
-                order.id = std::stoi(row[0]);
-                order.customerId = std::stoi(row[1]);
-                order.compositionId = std::stoi(row[2]);
-                order.orderDate = row[3];
-                order.fulfillmentDate = row[4];
-                order.quantity = std::stoi(row[5]);
-                order.urgencyRate = std::stod(row[6]);
-                orders.push_back(order);
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "INSERT INTO Orders (CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate) "
+                      "VALUES (?, ?, ?, ?, ?, ?)";
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db_) << std::endl;
+        executeSQL("ROLLBACK");
+        return false;
+    }
+    
+    std::vector<Order> inserted;
+    for (const auto& order : orders) {
+        double urgencyRate = urgencyRateFor(order.orderDate, order.fulfillmentDate);
+        sqlite3_bind_int(stmt, 1, order.customerId);
+        sqlite3_bind_int(stmt, 2, order.compositionId);
+        sqlite3_bind_int(stmt, 3, order.orderDate);
+        sqlite3_bind_int(stmt, 4, order.fulfillmentDate);
+        sqlite3_bind_int(stmt, 5, order.quantity);
+        sqlite3_bind_double(stmt, 6, urgencyRate);
+        
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) {
+            inserted.push_back({static_cast<int>(sqlite3_last_insert_rowid(db_)), order.customerId, order.compositionId,
+                                order.orderDate, order.fulfillmentDate, order.quantity, urgencyRate});
+        } else if ((rc & 0xff) == SQLITE_CONSTRAINT) {
+            // Only this statement is undone; the rest of the batch goes ahead
+            std::cerr << "Journaled order rejected: " << sqlite3_errmsg(db_) << std::endl;
+        } else {
+            // Disk full, I/O errors and the like: the entries stay in the journal for a retry
+            std::cerr << "Can't apply journaled orders: " << sqlite3_errmsg(db_) << std::endl;
+            sqlite3_finalize(stmt);
+            if (!sqlite3_get_autocommit(db_)) {
+                executeSQL("ROLLBACK");
             }
+            return false;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    
+    // SQLite may have rolled the transaction back by itself; the UPDATE would then commit
+    // on its own and mark entries applied that are not
+    if (sqlite3_get_autocommit(db_)) {
+        std::cerr << "Can't apply journaled orders: the transaction was rolled back" << std::endl;
+        return false;
+    }
+    if (!executeSQL("UPDATE OrderJournalState SET AppliedSequence = " + std::to_string(lastSequence)) ||
+        !executeSQL("COMMIT")) {
+        if (!sqlite3_get_autocommit(db_)) {
+            executeSQL("ROLLBACK");
+        }
+        return false;
+    }
+    
+    writeGeneration_++;
+    writesSinceSnapshot_ += static_cast<int>(inserted.size());
+    for (const auto& order : inserted) {
+        for (const auto& entry : orderListeners_) {
+            entry.second(order);
         }
     }
+    foldCompositionSalesIfDue(static_cast<int>(inserted.size()));
+    return true;
+}
+
+bool Database::orderReferencesExist(int customerId, int compositionId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    bool exist = false;
+    if (!connected_) {
+        return false;
+    }
+    forEachRow(db_,
+               "SELECT EXISTS (SELECT 1 FROM Customers WHERE CustomerID = " + std::to_string(customerId) + ") "
+               "AND EXISTS (SELECT 1 FROM Compositions WHERE CompositionID = " + std::to_string(compositionId) + ")",
+               [&](sqlite3_stmt* stmt) { exist = sqlite3_column_int(stmt, 0) != 0; });
+    return exist;
+}
+
+uint64_t Database::getAppliedJournalSequence() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    uint64_t sequence = 0;
+    forEachRow(db_, "SELECT AppliedSequence FROM OrderJournalState", [&](sqlite3_stmt* stmt) {
+        sequence = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+    });
+    return sequence;
+}
+
+int Database::addOrderListener(OrderListener listener) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    int listenerId = nextListenerId_++;
+    orderListeners_[listenerId] = std::move(listener);
+    return listenerId;
+}
+
+void Database::removeOrderListener(int listenerId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    orderListeners_.erase(listenerId);
+}
+
+std::vector<Database::Order> Database::getOrdersByDate(int date) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<Order> orders;
+    std::string sql = "SELECT OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate "
+                      "FROM Orders WHERE OrderDate = ?";
+    
+    for (sqlite3* partition : orderPartitionsForDates(db_, date, date)) {
+        forEachCachedRow(partition, sql, {date}, [&](sqlite3_stmt* stmt) {
+            orders.push_back(readOrder(stmt));
+        });
+    }
     
     return orders;
 }
 
-std::vector<Database::Order> Database::getOrdersByDateRange(const std::string& startDate, const std::string& endDate) {
+std::vector<Database::Order> Database::getOrdersByDateRange(int startDate, int endDate) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::vector<Order> orders;
     std::string sql = "SELECT OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate "
-                      "FROM Orders WHERE OrderDate BETWEEN '" + startDate + "' AND '" + endDate + "'";
-    std::vector<std::vector<std::string>> results;
+                      "FROM Orders WHERE OrderDate BETWEEN ? AND ?";
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results)) {
-        for (const auto& row : results) {
-            if (row.size() >= 7) {
-                Order order;
-                order.id = std::stoi(row[0]);
-                order.customerId = std::stoi(row[1]);
-                order.compositionId = std::stoi(row[2]);
-                order.orderDate = row[3];
-                order.fulfillmentDate = row[4];
-                order.quantity = std::stoi(row[5]);
-                order.urgencyRate = std::stod(row[6]);
-                orders.push_back(order);
-            }
+    for (sqlite3* partition : orderPartitionsForDates(db_, startDate, endDate)) {
+        forEachCachedRow(partition, sql, {startDate, endDate}, [&](sqlite3_stmt* stmt) {
+            orders.push_back(readOrder(stmt));
+        });
+    }
+    
+    return orders;
+}
+
+Database::Page<Database::Customer> Database::getCustomersPage(const PageCursor& after, int pageSize) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Page<Customer> page;
+    page.next = after;
+    std::string sql = "SELECT CustomerID, CustomerName, PhoneNumber, Email FROM Customers "
+                      "WHERE CustomerID > " + std::to_string(after.id) +
+                      " ORDER BY CustomerID LIMIT " + std::to_string(pageSize + 1);
+    
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        page.rows.push_back({sqlite3_column_int(stmt, 0), std::string(columnText(stmt, 1)),
+                             std::string(columnText(stmt, 2)), std::string(columnText(stmt, 3))});
+    });
+    
+    finishPage(page, pageSize);
+    if (!page.rows.empty()) {
+        page.next.id = page.rows.back().id;
+    }
+    return page;
+}
+
+Database::Page<Database::Composition> Database::getCompositionsPage(const PageCursor& after, int pageSize) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Page<Composition> page;
+    page.next = after;
+    std::string sql = "SELECT CompositionID, CompositionName, Description FROM Compositions "
+                      "WHERE CompositionID > " + std::to_string(after.id) +
+                      " ORDER BY CompositionID LIMIT " + std::to_string(pageSize + 1);
+    
+    forEachRow(db_, sql, [&](sqlite3_stmt* stmt) {
+        page.rows.push_back({sqlite3_column_int(stmt, 0), std::string(columnText(stmt, 1)),
+                             std::string(columnText(stmt, 2))});
+    });
+    
+    finishPage(page, pageSize);
+    if (!page.rows.empty()) {
+        page.next.id = page.rows.back().id;
+    }
+    return page;
+}
+
+Database::Page<Database::Order> Database::getOrdersPage(const PageCursor& after, int pageSize) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Page<Order> page;
+    page.next = after;
+    // The row-value comparison is answered by idx_orders_orderdate, which also carries OrderID
+    std::string sql = "SELECT OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate "
+                      "FROM Orders WHERE (OrderDate, OrderID) > (" + std::to_string(after.date) + ", " +
+                      std::to_string(after.id) + ") ORDER BY OrderDate, OrderID LIMIT " + std::to_string(pageSize + 1);
+    
+    std::vector<sqlite3*> partitions = orderPartitions(db_, [&](const OrderArchive& archive) {
+        return archive.lastOrderDate >= after.date;
+    });
+    for (sqlite3* partition : partitions) {
+        forEachRow(partition, sql, [&](sqlite3_stmt* stmt) {
+            Order order;
+            order.id = sqlite3_column_int(stmt, 0);
+            order.customerId = sqlite3_column_int(stmt, 1);
+            order.compositionId = sqlite3_column_int(stmt, 2);
+            order.orderDate = sqlite3_column_int(stmt, 3);
+            order.fulfillmentDate = sqlite3_column_int(stmt, 4);
+            order.quantity = sqlite3_column_int(stmt, 5);
+            order.urgencyRate = sqlite3_column_double(stmt, 6);
+            page.rows.push_back(order);
+        });
+    }
+    
+    // Each partition returned its own first rows past the cursor; keep the overall first
+    if (partitions.size() > 1) {
+        std::sort(page.rows.begin(), page.rows.end(), [](const Order& a, const Order& b) {
+            return std::make_pair(a.orderDate, a.id) < std::make_pair(b.orderDate, b.id);
+        });
+        if (page.rows.size() > static_cast<size_t>(pageSize) + 1) {
+            page.rows.resize(pageSize + 1);
         }
     }
+    finishPage(page, pageSize);
+    if (!page.rows.empty()) {
+        page.next.date = page.rows.back().orderDate;
+        page.next.id = page.rows.back().id;
+    }
+    return page;
+}
+
+std::vector<Database::Order> Database::getPendingOrders(int fromDate) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::vector<Order> orders;
+    std::string sql = "SELECT OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate "
+                      "FROM Orders WHERE FulfillmentDate >= " + std::to_string(fromDate);
+    
+    auto pending = [&](const OrderArchive& archive) { return archive.lastFulfillmentDate >= fromDate; };
+    for (sqlite3* partition : orderPartitions(db_, pending)) {
+        forEachRow(partition, sql, [&](sqlite3_stmt* stmt) {
+            orders.push_back(readOrder(stmt));
+        });
+    }
     
     return orders;
 }
 
 Database::OrderSummary Database::getOrderSummary(int orderId) {
-    OrderSummary summary;
-    std::string sql = "SELECT OrderID, BasePrice, UrgencyFee, TotalPrice FROM OrderSummary WHERE OrderID = " + 
-                      std::to_string(orderId);
-    std::vector<std::vector<std::string>> results;
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    OrderSummary summary{};
+    std::string sql = "SELECT OrderID, BasePrice, UrgencyFee, TotalPrice FROM OrderSummary WHERE OrderID = ?";
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results) && !results.empty()) {
-        summary.orderId = std::stoi(results[0][0]);
-        summary.basePrice = std::stod(results[0][1]);
-        summary.urgencyFee = std::stod(results[0][2]);
-        summary.totalPrice = std::stod(results[0][3]);
+    auto holdsId = [&](const OrderArchive& archive) {
+        return archive.firstOrderId <= orderId && archive.lastOrderId >= orderId;
+    };
+    for (sqlite3* partition : orderPartitions(db_, holdsId)) {
+        forEachCachedRow(partition, sql, {orderId}, [&](sqlite3_stmt* stmt) {
+            summary = {sqlite3_column_int(stmt, 0), sqlite3_column_double(stmt, 1), sqlite3_column_double(stmt, 2),
+                       sqlite3_column_double(stmt, 3)};
+        });
     }
     
     return summary;
 }
 
-double Database::getTotalRevenue(const std::string& startDate, const std::string& endDate) {
-    double total = 0.0;
-    std::string sql = "SELECT SUM(os.TotalPrice) "
-                      "FROM OrderSummary os "
-                      "JOIN Orders o ON os.OrderID = o.OrderID "
-                      "WHERE o.OrderDate BETWEEN '" + startDate + "' AND '" + endDate + "'";
-    std::vector<std::vector<std::string>> results;
+double Database::getTotalRevenue(int startDate, int endDate) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string key = "revenue:" + std::to_string(startDate) + ":" + std::to_string(endDate);
+    return cachedReport<double>(key, [&]() {
+        double total = 0.0;
+        std::string sql = "SELECT SUM(os.TotalPrice) "
+                          "FROM OrderSummary os "
+                          "JOIN Orders o ON os.OrderID = o.OrderID "
+                          "WHERE o.OrderDate BETWEEN " + std::to_string(startDate) + " AND " + std::to_string(endDate);
+        std::vector<std::vector<std::string>> results;
+        for (sqlite3* partition : orderPartitionsForDates(reportHandle(), startDate, endDate)) {
+            executeQuery(partition, sql, callbackWrapper, &results);
+        }
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results) && !results.empty() && results[0][0] != "NULL") {
-        total = std::stod(results[0][0]);
-    }
+        for (const auto& row : results) {
+            if (row[0] != "NULL") {
+                total += std::stod(row[0]);
+            }
+        }
     
-    return total;
+        return total;
+    });
+}
+
+bool Database::parseGranularity(const std::string& text, Granularity& granularity) {
+    static const std::map<std::string, Granularity> NAMES = {
+        {"day", Granularity::Day}, {"week", Granularity::Week},
+        {"month", Granularity::Month}, {"year", Granularity::Year}};
+    auto it = NAMES.find(text);
+    if (it == NAMES.end()) {
+        return false;
+    }
+    granularity = it->second;
+    return true;
+}
+
+// First day of the calendar bucket containing date
+static int bucketStart(int date, Database::Granularity granularity) {
+    int year, month, day;
+    switch (granularity) {
+        case Database::Granularity::Day:
+            return date;
+        case Database::Granularity::Week:
+            // Day 0 (1970-01-01) was a Thursday
+            return date - ((date % 7 + 7 + 3) % 7);
+        case Database::Granularity::Month:
+            civilFromDays(date, year, month, day);
+            return daysFromCivil(year, month, 1);
+        case Database::Granularity::Year:
+            civilFromDays(date, year, month, day);
+            return daysFromCivil(year, 1, 1);
+    }
+    return date;
+}
+
+static int nextBucket(int start, Database::Granularity granularity) {
+    int year, month, day;
+    switch (granularity) {
+        case Database::Granularity::Day:
+            return start + 1;
+        case Database::Granularity::Week:
+            return start + 7;
+        case Database::Granularity::Month:
+            civilFromDays(start, year, month, day);
+            return month == 12 ? daysFromCivil(year + 1, 1, 1) : daysFromCivil(year, month + 1, 1);
+        case Database::Granularity::Year:
+            civilFromDays(start, year, month, day);
+            return daysFromCivil(year + 1, 1, 1);
+    }
+    return start + 1;
+}
+
+std::vector<Database::RevenueBucket> Database::getRevenueSeries(int startDate, int endDate, Granularity granularity) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string key = "series:" + std::to_string(static_cast<int>(granularity)) + ":" +
+                      std::to_string(startDate) + ":" + std::to_string(endDate);
+    return cachedReport<std::vector<RevenueBucket>>(key, [&]() {
+        std::vector<RevenueBucket> series;
+        if (endDate < startDate) {
+            return series;
+        }
+        
+        // Empty buckets first, so that days without orders still show up
+        std::vector<double> urgencyFees;
+        for (int start = bucketStart(startDate, granularity); start <= endDate; start = nextBucket(start, granularity)) {
+            series.push_back({start, 0.0, 0, 0.0});
+            urgencyFees.push_back(0.0);
+        }
+        
+        // One pass over the date index, grouped per day; days are folded into buckets here
+        std::string sql = "SELECT o.OrderDate, SUM(os.TotalPrice), COUNT(*), SUM(os.UrgencyFee) "
+                          "FROM Orders o "
+                          "JOIN OrderSummary os ON os.OrderID = o.OrderID "
+                          "WHERE o.OrderDate BETWEEN " + std::to_string(startDate) + " AND " + std::to_string(endDate) +
+                          " GROUP BY o.OrderDate ORDER BY o.OrderDate";
+        std::vector<std::vector<std::string>> results;
+        for (sqlite3* partition : orderPartitionsForDates(reportHandle(), startDate, endDate)) {
+            executeQuery(partition, sql, callbackWrapper, &results);
+        }
+        
+        // Days are in order within a partition but not across them
+        for (const auto& row : results) {
+            if (row.size() < 4 || row[1] == "NULL") {
+                continue;
+            }
+            int date = std::stoi(row[0]);
+            auto next = std::upper_bound(series.begin(), series.end(), date,
+                                         [](int day, const RevenueBucket& bucket) { return day < bucket.startDate; });
+            size_t bucket = next - series.begin() - 1;
+            series[bucket].revenue += std::stod(row[1]);
+            series[bucket].orderCount += std::stoi(row[2]);
+            urgencyFees[bucket] += std::stod(row[3]);
+        }
+        
+        for (size_t i = 0; i < series.size(); i++) {
+            if (series[i].revenue > 0.0) {
+                series[i].urgencyFeeShare = urgencyFees[i] / series[i].revenue;
+            }
+        }
+        return series;
+    });
 }
 
 std::vector<std::pair<int, int>> Database::getOrdersByUrgency() {
-    std::vector<std::pair<int, int>> urgencyStats;
-    std::string sql = "SELECT UrgencyRate, COUNT(OrderID) "
-                      "FROM Orders "
-                      "GROUP BY UrgencyRate";
-    std::vector<std::vector<std::string>> results;
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string key = "urgency";
+    return cachedReport<std::vector<std::pair<int, int>>>(key, [&]() {
+        std::vector<std::pair<int, int>> urgencyStats;
+        std::string sql = "SELECT UrgencyRate, COUNT(OrderID) "
+                          "FROM Orders "
+                          "GROUP BY UrgencyRate";
+        std::vector<std::vector<std::string>> results;
+        for (sqlite3* partition : orderPartitions(reportHandle(), [](const OrderArchive&) { return true; })) {
+            executeQuery(partition, sql, callbackWrapper, &results);
+        }
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results)) {
+        std::map<int, int> countsByPercent;
         for (const auto& row : results) {
             if (row.size() >= 2) {
                 double urgencyRate = std::stod(row[0]);
                 int count = std::stoi(row[1]);
-                
+            
                 // Convert urgency rate to a percentage
                 int urgencyPercent = static_cast<int>(urgencyRate * 100);
-                urgencyStats.push_back({urgencyPercent, count});
+                countsByPercent[urgencyPercent] += count;
             }
         }
-    }
+        urgencyStats.assign(countsByPercent.begin(), countsByPercent.end());
     
-    return urgencyStats;
+        return urgencyStats;
+    });
 }
 
-std::map<std::string, std::map<std::string, int>> Database::getFlowerUsageByPeriod(
-    const std::string& startDate, const std::string& endDate) {
+std::map<std::string, std::map<std::string, int>> Database::getFlowerUsageByPeriod(int startDate, int endDate) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string key = "usage:" + std::to_string(startDate) + ":" + std::to_string(endDate);
+    return cachedReport<std::map<std::string, std::map<std::string, int>>>(key, [&]() {
+        std::map<std::string, std::map<std::string, int>> flowerUsage;
+        std::string sql = "SELECT f.FlowerName, f.Variety, SUM(cf.Quantity * o.Quantity) as TotalUsed "
+                          "FROM Orders o "
+                          "JOIN CompositionFlowers cf ON o.CompositionID = cf.CompositionID "
+                          "JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+                          "WHERE o.OrderDate BETWEEN " + std::to_string(startDate) + " AND " + std::to_string(endDate) + " "
+                          "GROUP BY f.FlowerName, f.Variety";
     
-    std::map<std::string, std::map<std::string, int>> flowerUsage;
-    std::string sql = "SELECT f.FlowerName, f.Variety, SUM(cf.Quantity * o.Quantity) as TotalUsed "
-                      "FROM Orders o "
-                      "JOIN CompositionFlowers cf ON o.CompositionID = cf.CompositionID "
-                      "JOIN Flowers f ON cf.FlowerID = f.FlowerID "
-                      "WHERE o.OrderDate BETWEEN '" + startDate + "' AND '" + endDate + "' "
-                      "GROUP BY f.FlowerName, f.Variety";
-    
-    std::vector<std::vector<std::string>> results;
+        std::vector<std::vector<std::string>> results;
+        for (sqlite3* partition : orderPartitionsForDates(reportHandle(), startDate, endDate)) {
+            executeQuery(partition, sql, callbackWrapper, &results);
+        }
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results)) {
         for (const auto& row : results) {
             if (row.size() >= 3) {
                 std::string flowerName = row[0];
                 std::string variety = row[1];
                 int quantity = std::stoi(row[2]);
-                
-                flowerUsage[flowerName][variety] = quantity;
+            
+                flowerUsage[flowerName][variety] += quantity;
             }
         }
-    }
     
-    return flowerUsage;
+        return flowerUsage;
+    });
+}
+
+Database::ResultSet<Database::FlowerUsageView> Database::getFlowerUsageTable(int startDate, int endDate) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string key = "usage_table:" + std::to_string(startDate) + ":" + std::to_string(endDate);
+    return cachedReport<ResultSet<FlowerUsageView>>(key, [&]() {
+        ResultSet<FlowerUsageView> usage{std::make_shared<StringArena>(), {}};
+        StringArena& arena = *usage.arena;
+        std::string sql = "SELECT f.FlowerName, f.Variety, SUM(cf.Quantity * o.Quantity) as TotalUsed "
+                          "FROM Orders o "
+                          "JOIN CompositionFlowers cf ON o.CompositionID = cf.CompositionID "
+                          "JOIN Flowers f ON cf.FlowerID = f.FlowerID "
+                          "WHERE o.OrderDate BETWEEN " + std::to_string(startDate) + " AND " + std::to_string(endDate) + " "
+                          "GROUP BY f.FlowerName, f.Variety "
+                          "ORDER BY f.FlowerName, f.Variety";
+    
+        std::vector<sqlite3*> partitions = orderPartitionsForDates(reportHandle(), startDate, endDate);
+        for (sqlite3* partition : partitions) {
+            forEachRow(partition, sql, [&](sqlite3_stmt* stmt) {
+                usage.rows.push_back({arena.intern(columnText(stmt, 0)), arena.intern(columnText(stmt, 1)),
+                                      sqlite3_column_int(stmt, 2)});
+            });
+        }
+    
+        // Each partition's rows are sorted; merge them into one row per flower and variety
+        if (partitions.size() > 1) {
+            auto key = [](const FlowerUsageView& row) { return std::make_pair(row.flowerName, row.variety); };
+            std::stable_sort(usage.rows.begin(), usage.rows.end(),
+                             [&](const FlowerUsageView& a, const FlowerUsageView& b) { return key(a) < key(b); });
+            size_t merged = 0;
+            for (size_t i = 0; i < usage.rows.size(); i++) {
+                if (merged > 0 && key(usage.rows[merged - 1]) == key(usage.rows[i])) {
+                    usage.rows[merged - 1].quantity += usage.rows[i].quantity;
+                } else {
+                    usage.rows[merged++] = usage.rows[i];
+                }
+            }
+            usage.rows.resize(merged);
+        }
+    
+        return usage;
+    });
 }
 
 std::map<std::string, std::pair<int, double>> Database::getCompositionSalesSummary() {
-    std::map<std::string, std::pair<int, double>> salesSummary;
-    std::string sql = "SELECT c.CompositionName, COUNT(o.OrderID) as OrderCount, SUM(os.TotalPrice) as TotalRevenue "
-                      "FROM Compositions c "
-                      "JOIN Orders o ON c.CompositionID = o.CompositionID "
-                      "JOIN OrderSummary os ON o.OrderID = os.OrderID "
-                      "GROUP BY c.CompositionName";
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string key = "sales";
+    return cachedReport<std::map<std::string, std::pair<int, double>>>(key, [&]() {
+        // The aggregate plus whatever is past its watermark. A writable connection folds a
+        // large backlog in first, so this normally adds up fewer than
+        // COMPOSITION_SALES_FOLD_ORDERS orders; only a read-only one may have to add up more.
+        foldCompositionSalesIfBehind();
+        std::map<std::string, std::pair<int, double>> salesSummary;
+        std::string sql = "SELECT c.CompositionName, SUM(s.OrderCount) as OrderCount, SUM(s.TotalRevenue) as TotalRevenue "
+                          "FROM (SELECT CompositionID, OrderCount, TotalRevenue FROM CompositionSales "
+                          "      UNION ALL " + std::string(NEW_COMPOSITION_SALES_SQL) + ") s "
+                          "JOIN Compositions c ON c.CompositionID = s.CompositionID "
+                          "GROUP BY c.CompositionName";
     
-    std::vector<std::vector<std::string>> results;
+        std::vector<std::vector<std::string>> results;
     
-    if (executeSQLWithCallback(sql, callbackWrapper, &results)) {
-        for (const auto& row : results) {
-            if (row.size() >= 3) {
-                std::string compositionName = row[0];
-                int orderCount = std::stoi(row[1]);
-                double totalRevenue = std::stod(row[2]);
+        if (executeReportQuery(sql, callbackWrapper, &results)) {
+            for (const auto& row : results) {
+                if (row.size() >= 3) {
+                    std::string compositionName = row[0];
+                    int orderCount = std::stoi(row[1]);
+                    double totalRevenue = std::stod(row[2]);
                 
-                salesSummary[compositionName] = {orderCount, totalRevenue};
+                    salesSummary[compositionName] = {orderCount, totalRevenue};
+                }
             }
         }
+    
+        return salesSummary;
+    });
+}
+
+bool Database::refreshCompositionSales() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!executeSQL("BEGIN IMMEDIATE")) {
+        return false;
     }
     
-    return salesSummary;
+    // Both statements find the new orders through the OrderID primary key, so the work is
+    // proportional to the number of orders since the last refresh
+    if (!executeSQL(FOLD_COMPOSITION_SALES_SQL + "COMMIT;")) {
+        executeSQL("ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+void Database::foldCompositionSalesIfDue(int newOrders) {
+    ordersSinceSalesFold_ += newOrders;
+    if (ordersSinceSalesFold_ < COMPOSITION_SALES_FOLD_ORDERS) {
+        return;
+    }
+    // The orders are already committed; if the refresh fails, the next order retries it
+    if (refreshCompositionSales()) {
+        ordersSinceSalesFold_ = 0;
+    }
+}
+
+void Database::foldCompositionSalesIfBehind() {
+    if (options_.readOnly || options_.immutable) {
+        return;
+    }
+    // Both lookups are on the OrderID primary key
+    long long behind = 0;
+    forEachRow(db_,
+               "SELECT COALESCE((SELECT MAX(OrderID) FROM Orders), 0) - LastOrderID FROM CompositionSalesWatermark",
+               [&](sqlite3_stmt* stmt) { behind = sqlite3_column_int64(stmt, 0); });
+    if (behind >= COMPOSITION_SALES_FOLD_ORDERS && refreshCompositionSales()) {
+        ordersSinceSalesFold_ = 0;
+    }
+}
+
+int Database::getCompositionSalesWatermark() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    int lastOrderId = 0;
+    forEachRow(db_, "SELECT LastOrderID FROM CompositionSalesWatermark", [&](sqlite3_stmt* stmt) {
+        lastOrderId = sqlite3_column_int(stmt, 0);
+    });
+    return lastOrderId;
+}
+
+bool Database::archiveYear(int year) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!connected_ || options_.readOnly || options_.immutable) {
+        std::cerr << "Orders can only be archived through a writable connection" << std::endl;
+        return false;
+    }
+    int firstDate = daysFromCivil(year, 1, 1);
+    int lastDate = daysFromCivil(year, 12, 31);
+    if (lastDate >= currentDay()) {
+        std::cerr << "Year " << year << " is not over yet" << std::endl;
+        return false;
+    }
+
+    // The write lock keeps orders for the year from arriving between the copy and the delete
+    if (!executeSQL("BEGIN IMMEDIATE")) {
+        return false;
+    }
+    auto fail = [&](const std::string& message) {
+        if (!message.empty()) {
+            std::cerr << message << std::endl;
+        }
+        executeSQL("ROLLBACK");
+        return false;
+    };
+
+    for (const auto& archive : listArchives(db_)) {
+        if (archive.year == year) {
+            return fail("Year " + std::to_string(year) + " is already archived");
+        }
+    }
+
+    std::string range = " BETWEEN " + std::to_string(firstDate) + " AND " + std::to_string(lastDate);
+    OrderArchive archive{year, "", 0, 0, 0, 0, 0, 0};
+    forEachRow(db_, "SELECT COUNT(*), MIN(OrderDate), MAX(OrderDate), MAX(FulfillmentDate), MIN(OrderID), MAX(OrderID) "
+                    "FROM Orders WHERE OrderDate" + range,
+               [&](sqlite3_stmt* stmt) {
+                   archive.orderCount = sqlite3_column_int(stmt, 0);
+                   archive.firstOrderDate = sqlite3_column_int(stmt, 1);
+                   archive.lastOrderDate = sqlite3_column_int(stmt, 2);
+                   archive.lastFulfillmentDate = sqlite3_column_int(stmt, 3);
+                   archive.firstOrderId = sqlite3_column_int(stmt, 4);
+                   archive.lastOrderId = sqlite3_column_int(stmt, 5);
+               });
+    if (archive.orderCount == 0) {
+        return fail("No orders were placed in " + std::to_string(year));
+    }
+    if (archive.lastFulfillmentDate >= currentDay()) {
+        return fail("Orders placed in " + std::to_string(year) + " are still to be fulfilled");
+    }
+
+    std::string stem = dbPath_.substr(dbPath_.find_last_of('/') + 1);
+    size_t dot = stem.find_last_of('.');
+    archive.fileName = (dot == std::string::npos ? stem : stem.substr(0, dot)) + ".orders-" +
+                       std::to_string(year) + ".db";
+    if (!writeArchive(archivePath(archive.fileName), firstDate, lastDate)) {
+        return fail("");
+    }
+
+    // CompositionSales covers all history, so the orders are folded in before they leave
+    std::string sql = FOLD_COMPOSITION_SALES_SQL +
+                      "DELETE FROM OrderSummary WHERE OrderID IN (SELECT OrderID FROM Orders WHERE OrderDate" + range + ");"
+                      "DELETE FROM Orders WHERE OrderDate" + range + ";"
+                      "INSERT INTO OrderArchives (Year, FileName, FirstOrderDate, LastOrderDate, LastFulfillmentDate, "
+                      "FirstOrderID, LastOrderID, OrderCount) VALUES (" +
+                      std::to_string(year) + ", " + sqlLiteral(archive.fileName) + ", " +
+                      std::to_string(archive.firstOrderDate) + ", " + std::to_string(archive.lastOrderDate) + ", " +
+                      std::to_string(archive.lastFulfillmentDate) + ", " + std::to_string(archive.firstOrderId) + ", " +
+                      std::to_string(archive.lastOrderId) + ", " + std::to_string(archive.orderCount) + ");"
+                      "COMMIT;";
+    if (!executeSQL(sql)) {
+        return fail("");
+    }
+
+    writeGeneration_++;
+    writesSinceSnapshot_ += archive.orderCount;
+    return true;
+}
+
+std::vector<Database::OrderArchive> Database::getOrderArchives() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return listArchives(db_);
 }
 
 bool Database::executeSQL(const std::string& sql) {
@@ -389,3 +1714,181 @@ bool Database::executeSQLWithCallback(const std::string& sql, sqlite3_callback c
     
     return true;
 }
+
+bool Database::executeReportQuery(const std::string& sql, sqlite3_callback callback, void* data) {
+    return executeQuery(reportHandle(), sql, callback, data);
+}
+
+bool Database::executeQuery(sqlite3* handle, const std::string& sql, sqlite3_callback callback, void* data) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(handle, sql.c_str(), callback, data, &errMsg);
+    
+    if (rc != SQLITE_OK) {
+        std::cerr << "SQL error: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    
+    return true;
+}
+
+bool Database::forEachRow(sqlite3* handle, const std::string& sql, const std::function<void(sqlite3_stmt*)>& onRow) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(handle, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(handle) << std::endl;
+        return false;
+    }
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        onRow(stmt);
+    }
+    
+    if (rc != SQLITE_DONE) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(handle) << std::endl;
+    }
+    sqlite3_finalize(stmt);
+    
+    return rc == SQLITE_DONE;
+}
+
+bool Database::forEachCachedRow(sqlite3* handle, const std::string& sql, const std::vector<long long>& params,
+                                const std::function<void(sqlite3_stmt*)>& onRow) {
+    auto key = std::make_pair(handle, sql);
+    sqlite3_stmt*& stmt = statements_[key];
+    if (!stmt && sqlite3_prepare_v3(handle, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(handle) << std::endl;
+        statements_.erase(key);
+        return false;
+    }
+    
+    for (size_t i = 0; i < params.size(); i++) {
+        sqlite3_bind_int64(stmt, static_cast<int>(i + 1), params[i]);
+    }
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        onRow(stmt);
+    }
+    
+    if (rc != SQLITE_DONE) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(handle) << std::endl;
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    
+    return rc == SQLITE_DONE;
+}
+
+void Database::finalizeStatements(sqlite3* handle) {
+    for (auto it = statements_.begin(); it != statements_.end();) {
+        if (handle && it->first.first != handle) {
+            ++it;
+            continue;
+        }
+        sqlite3_finalize(it->second);
+        it = statements_.erase(it);
+    }
+}
+
+std::string Database::archivePath(const std::string& fileName) const {
+    size_t slash = dbPath_.find_last_of('/');
+    return slash == std::string::npos ? fileName : dbPath_.substr(0, slash + 1) + fileName;
+}
+
+sqlite3* Database::archiveHandle(const OrderArchive& archive) {
+    auto found = archiveHandles_.find(archive.year);
+    if (found != archiveHandles_.end()) {
+        return found->second;
+    }
+
+    // A listed archive never changes, so it is read without locking or change detection
+    sqlite3* handle = nullptr;
+    std::string uri = fileUri(archivePath(archive.fileName)) + "?mode=ro&immutable=1";
+    std::string hot = fileUri(dbPath_) + "?mode=ro" + (options_.immutable ? "&immutable=1" : "");
+    char* errMsg = nullptr;
+    if (sqlite3_open_v2(uri.c_str(), &handle, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, nullptr) != SQLITE_OK ||
+        sqlite3_exec(handle, ("ATTACH " + sqlLiteral(hot) + " AS hot").c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Can't open order archive " << archive.fileName << ": "
+                  << (errMsg ? errMsg : sqlite3_errmsg(handle)) << std::endl;
+        sqlite3_free(errMsg);
+        sqlite3_close(handle);
+        return nullptr;
+    }
+    if (options_.busyTimeoutMs > 0) {
+        sqlite3_busy_timeout(handle, options_.busyTimeoutMs);
+    }
+
+    archiveHandles_[archive.year] = handle;
+    return handle;
+}
+
+std::vector<Database::OrderArchive> Database::listArchives(sqlite3* handle) {
+    std::vector<OrderArchive> archives;
+    forEachCachedRow(handle, ORDER_ARCHIVES_SQL, {}, [&](sqlite3_stmt* stmt) {
+        archives.push_back({sqlite3_column_int(stmt, 0), std::string(columnText(stmt, 1)), sqlite3_column_int(stmt, 2),
+                            sqlite3_column_int(stmt, 3), sqlite3_column_int(stmt, 4), sqlite3_column_int(stmt, 5),
+                            sqlite3_column_int(stmt, 6), sqlite3_column_int(stmt, 7)});
+    });
+    return archives;
+}
+
+std::vector<sqlite3*> Database::orderPartitions(sqlite3* handle,
+                                                const std::function<bool(const OrderArchive&)>& matches) {
+    // The catalog is read from the connection being queried, so that a report snapshot
+    // taken before an archive was written keeps those orders and does not list the archive
+    std::vector<sqlite3*> partitions;
+    for (const auto& archive : listArchives(handle)) {
+        if (matches(archive)) {
+            if (sqlite3* archiveDb = archiveHandle(archive)) {
+                partitions.push_back(archiveDb);
+            }
+        }
+    }
+    partitions.push_back(handle);
+    return partitions;
+}
+
+std::vector<sqlite3*> Database::orderPartitionsForDates(sqlite3* handle, int startDate, int endDate) {
+    return orderPartitions(handle, [&](const OrderArchive& archive) {
+        return archive.firstOrderDate <= endDate && archive.lastOrderDate >= startDate;
+    });
+}
+
+bool Database::writeArchive(const std::string& path, int firstDate, int lastDate) {
+    // A separate connection, so that the archive is committed on its own and durable before
+    // the orders are deleted here. It reads the orders through an attachment while this
+    // connection holds the write lock but has not changed anything yet.
+    sqlite3* archive = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &archive, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI,
+                        nullptr) != SQLITE_OK) {
+        std::cerr << "Can't create order archive " << path << ": " << sqlite3_errmsg(archive) << std::endl;
+        sqlite3_close(archive);
+        return false;
+    }
+
+    std::string range = " BETWEEN " + std::to_string(firstDate) + " AND " + std::to_string(lastDate);
+    // A file left by an interrupted run was never listed, so it is rebuilt
+    std::string sql = "DROP TABLE IF EXISTS Orders;"
+                      "DROP TABLE IF EXISTS OrderSummary;" +
+                      std::string(ARCHIVE_SCHEMA_SQL) +
+                      "ATTACH " + sqlLiteral(fileUri(dbPath_) + "?mode=ro") + " AS hot;"
+                      "BEGIN;"
+                      "INSERT INTO Orders (OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate) "
+                      "SELECT OrderID, CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate "
+                      "FROM hot.Orders WHERE OrderDate" + range + ";"
+                      "INSERT INTO OrderSummary (OrderID, BasePrice, UrgencyFee, TotalPrice) "
+                      "SELECT os.OrderID, os.BasePrice, os.UrgencyFee, os.TotalPrice "
+                      "FROM hot.Orders o JOIN hot.OrderSummary os ON os.OrderID = o.OrderID "
+                      "WHERE o.OrderDate" + range + ";"
+                      "COMMIT;"
+                      "DETACH hot;";
+    char* errMsg = nullptr;
+    bool written = sqlite3_exec(archive, sql.c_str(), nullptr, nullptr, &errMsg) == SQLITE_OK;
+    if (!written) {
+        std::cerr << "Can't write order archive " << path << ": " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+    }
+    sqlite3_close(archive);
+    return written;
+}
@@ -0,0 +1,177 @@
+#include "../includes/database_options.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+
+static std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+static std::string toUpper(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::toupper(c); });
+    return text;
+}
+
+static bool parseBool(const std::string& value, bool& result) {
+    std::string upper = toUpper(value);
+    if (upper == "TRUE" || upper == "YES" || upper == "ON" || upper == "1") {
+        result = true;
+    } else if (upper == "FALSE" || upper == "NO" || upper == "OFF" || upper == "0") {
+        result = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isOneOf(const std::string& value, const std::vector<std::string>& allowed) {
+    return std::find(allowed.begin(), allowed.end(), value) != allowed.end();
+}
+
+DatabaseOptions DatabaseOptions::counterTerminal() {
+    DatabaseOptions options;
+    options.cacheSizeKiB = 8 * 1024;
+    options.mmapSize = 64LL * 1024 * 1024;
+    options.synchronous = "FULL";
+    options.tempStore = "MEMORY";
+    options.journalMode = "WAL";
+    return options;
+}
+
+DatabaseOptions DatabaseOptions::reportingServer() {
+    DatabaseOptions options;
+    options.cacheSizeKiB = 512 * 1024;
+    options.mmapSize = 2LL * 1024 * 1024 * 1024;
+    options.synchronous = "NORMAL";
+    options.tempStore = "MEMORY";
+    options.journalMode = "WAL";
+    return options;
+}
+
+bool DatabaseOptions::preset(const std::string& name, DatabaseOptions& options) {
+    if (name == "default") {
+        options = DatabaseOptions();
+    } else if (name == "counter_terminal") {
+        options = counterTerminal();
+    } else if (name == "reporting_server") {
+        options = reportingServer();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseOptions::loadFromFile(const std::string& path, DatabaseOptions& options) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Can't open database config: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            std::cerr << path << ":" << lineNumber << ": expected key = value" << std::endl;
+            return false;
+        }
+        std::string key = trim(line.substr(0, separator));
+        std::string value = trim(line.substr(separator + 1));
+
+        bool valid = true;
+        try {
+            if (key == "preset") {
+                valid = preset(value, options);
+            } else if (key == "page_size") {
+                options.pageSize = std::stoi(value);
+                valid = options.pageSize >= 512 && options.pageSize <= 65536 &&
+                        (options.pageSize & (options.pageSize - 1)) == 0;
+            } else if (key == "cache_size_kib") {
+                options.cacheSizeKiB = std::stoll(value);
+                valid = options.cacheSizeKiB >= 0;
+            } else if (key == "mmap_size") {
+                options.mmapSize = std::stoll(value);
+                valid = options.mmapSize >= 0;
+            } else if (key == "synchronous") {
+                options.synchronous = toUpper(value);
+                valid = isOneOf(options.synchronous, {"OFF", "NORMAL", "FULL", "EXTRA"});
+            } else if (key == "temp_store") {
+                options.tempStore = toUpper(value);
+                valid = isOneOf(options.tempStore, {"DEFAULT", "FILE", "MEMORY"});
+            } else if (key == "journal_mode") {
+                options.journalMode = toUpper(value);
+                valid = isOneOf(options.journalMode, {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"});
+            } else if (key == "busy_timeout_ms") {
+                options.busyTimeoutMs = std::stoi(value);
+                valid = options.busyTimeoutMs >= 0;
+            } else if (key == "auto_checkpoint") {
+                valid = parseBool(value, options.autoCheckpoint);
+            } else if (key == "read_only") {
+                valid = parseBool(value, options.readOnly);
+            } else if (key == "immutable") {
+                valid = parseBool(value, options.immutable);
+            } else {
+                std::cerr << path << ":" << lineNumber << ": unknown key " << key << std::endl;
+                return false;
+            }
+        } catch (const std::exception&) {
+            valid = false;
+        }
+
+        if (!valid) {
+            std::cerr << path << ":" << lineNumber << ": invalid value for " << key << ": " << value << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<std::string> DatabaseOptions::pragmas() const {
+    std::vector<std::string> statements;
+
+    // Connection-local and needed by the others: switching to WAL takes a lock that another
+    // connection may be holding
+    if (busyTimeoutMs > 0) {
+        statements.push_back("PRAGMA busy_timeout = " + std::to_string(busyTimeoutMs));
+    }
+
+    // page_size must precede anything that writes to a new file, including WAL setup
+    if (pageSize > 0 && !readOnly && !immutable) {
+        statements.push_back("PRAGMA page_size = " + std::to_string(pageSize));
+    }
+    if (!journalMode.empty() && !readOnly && !immutable) {
+        statements.push_back("PRAGMA journal_mode = " + journalMode);
+    }
+    if (!autoCheckpoint && !readOnly && !immutable) {
+        statements.push_back("PRAGMA wal_autocheckpoint = 0");
+    }
+    if (!synchronous.empty()) {
+        statements.push_back("PRAGMA synchronous = " + synchronous);
+    }
+    if (cacheSizeKiB > 0) {
+        // Negative values are interpreted as KiB rather than pages
+        statements.push_back("PRAGMA cache_size = -" + std::to_string(cacheSizeKiB));
+    }
+    if (mmapSize > 0) {
+        statements.push_back("PRAGMA mmap_size = " + std::to_string(mmapSize));
+    }
+    if (!tempStore.empty()) {
+        statements.push_back("PRAGMA temp_store = " + tempStore);
+    }
+
+    return statements;
+}
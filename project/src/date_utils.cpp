@@ -0,0 +1,70 @@
+#include "../includes/date_utils.h"
+#include <cstdio>
+#include <ctime>
+
+// Civil calendar conversions (proleptic Gregorian), see H. Hinnant's "chrono-compatible
+// low-level date algorithms".
+int daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yoe = year - era * 400;
+    const int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void civilFromDays(int days, int& year, int& month, int& day) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int doe = days - era * 146097;
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2);
+}
+
+bool parseDate(const std::string& text, int& days) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); i++) {
+        if (i != 4 && i != 7 && (text[i] < '0' || text[i] > '9')) {
+            return false;
+        }
+    }
+
+    int year = std::stoi(text.substr(0, 4));
+    int month = std::stoi(text.substr(5, 2));
+    int day = std::stoi(text.substr(8, 2));
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    // Reject dates such as 2025-02-30 that do not survive a round trip
+    int result = daysFromCivil(year, month, day);
+    int y, m, d;
+    civilFromDays(result, y, m, d);
+    if (y != year || m != month || d != day) {
+        return false;
+    }
+
+    days = result;
+    return true;
+}
+
+std::string formatDate(int days) {
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, day);
+    return buffer;
+}
+
+int currentDay() {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
@@ -0,0 +1,154 @@
+#include "../includes/demand_planner.h"
+#include "../includes/thread_pool.h"
+#include <algorithm>
+#include <limits>
+
+DemandPlanner::DemandPlanner(Database& db, size_t workerCount)
+    : db_(db), workerCount_(std::max<size_t>(workerCount, 1)), listenerId_(0),
+      fromDate_(std::numeric_limits<int>::max()), rebuilding_(false) {
+    listenerId_ = db_.addOrderListener([this](const Database::Order& order) {
+        addOrder(order);
+    });
+}
+
+DemandPlanner::~DemandPlanner() {
+    db_.removeOrderListener(listenerId_);
+}
+
+bool DemandPlanner::rebuild(int fromDate) {
+    if (!db_.isConnected()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> rebuildLock(rebuildMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rebuilding_ = true;
+        ordersDuringRebuild_.clear();
+    }
+
+    std::vector<Database::RecipeLine> lines = db_.getRecipeLines();
+    std::vector<Database::Order> orders = db_.getPendingOrders(fromDate);
+
+    // Lines arrive grouped by composition, which is exactly the compressed-row layout
+    RecipeMatrix matrix;
+    std::unordered_map<int, size_t> flowerColumn;
+    for (const auto& line : lines) {
+        if (!matrix.compositionRow.count(line.compositionId)) {
+            matrix.compositionRow[line.compositionId] = matrix.rowStart.size();
+            matrix.rowStart.push_back(matrix.columns.size());
+        }
+        auto column = flowerColumn.find(line.flowerId);
+        if (column == flowerColumn.end()) {
+            column = flowerColumn.emplace(line.flowerId, matrix.flowerIds.size()).first;
+            matrix.flowerIds.push_back(line.flowerId);
+        }
+        matrix.columns.push_back(column->second);
+        matrix.stems.push_back(line.quantity);
+    }
+    matrix.rowStart.push_back(matrix.columns.size());
+
+    // Each worker expands a contiguous slice of the orders into its own partial totals
+    size_t workers = std::min(workerCount_, std::max<size_t>(orders.size(), 1));
+    std::vector<std::map<int, DayDemand>> partials(workers);
+    {
+        ThreadPool pool(workers);
+        size_t sliceSize = (orders.size() + workers - 1) / workers;
+        for (size_t w = 0; w < workers; w++) {
+            pool.submit([&, w] {
+                size_t end = std::min(orders.size(), (w + 1) * sliceSize);
+                for (size_t i = w * sliceSize; i < end; i++) {
+                    accumulate(orders[i], matrix, fromDate, partials[w]);
+                }
+            });
+        }
+    }
+
+    std::map<int, DayDemand> demand;
+    for (auto& partial : partials) {
+        for (auto& [date, totals] : partial) {
+            DayDemand& merged = demand[date];
+            if (merged.empty()) {
+                merged = std::move(totals);
+                continue;
+            }
+            for (size_t column = 0; column < totals.size(); column++) {
+                merged[column] += totals[column];
+            }
+        }
+    }
+
+    // An order created while the data loaded may or may not be part of it
+    std::unordered_set<int> loaded;
+    for (const auto& order : orders) {
+        loaded.insert(order.id);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& order : ordersDuringRebuild_) {
+        if (!loaded.count(order.id)) {
+            accumulate(order, matrix, fromDate, demand);
+        }
+    }
+    ordersDuringRebuild_.clear();
+    rebuilding_ = false;
+    fromDate_ = fromDate;
+    matrix_ = std::move(matrix);
+    demand_ = std::move(demand);
+    return true;
+}
+
+void DemandPlanner::addOrder(const Database::Order& order) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rebuilding_) {
+        ordersDuringRebuild_.push_back(order);
+        return;
+    }
+    accumulate(order, matrix_, fromDate_, demand_);
+}
+
+void DemandPlanner::accumulate(const Database::Order& order, const RecipeMatrix& matrix, int fromDate,
+                               std::map<int, DayDemand>& demand) {
+    if (order.fulfillmentDate < fromDate) {
+        return;
+    }
+    auto row = matrix.compositionRow.find(order.compositionId);
+    if (row == matrix.compositionRow.end()) {
+        return;
+    }
+
+    DayDemand& totals = demand[order.fulfillmentDate];
+    totals.resize(matrix.flowerIds.size(), 0);
+    for (size_t entry = matrix.rowStart[row->second]; entry < matrix.rowStart[row->second + 1]; entry++) {
+        totals[matrix.columns[entry]] += static_cast<long long>(matrix.stems[entry]) * order.quantity;
+    }
+}
+
+std::map<int, long long> DemandPlanner::toFlowerMap(const DayDemand& totals) const {
+    std::map<int, long long> flowers;
+    for (size_t column = 0; column < totals.size(); column++) {
+        if (totals[column] != 0) {
+            flowers[matrix_.flowerIds[column]] = totals[column];
+        }
+    }
+    return flowers;
+}
+
+std::map<int, long long> DemandPlanner::getDemand(int date) const {
+    return getDemand(date, date);
+}
+
+std::map<int, long long> DemandPlanner::getDemand(int startDate, int endDate) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DayDemand totals(matrix_.flowerIds.size(), 0);
+    for (auto it = demand_.lower_bound(startDate); it != demand_.end() && it->first <= endDate; ++it) {
+        for (size_t column = 0; column < it->second.size(); column++) {
+            totals[column] += it->second[column];
+        }
+    }
+    return toFlowerMap(totals);
+}
+
+int DemandPlanner::getFromDate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fromDate_;
+}
@@ -0,0 +1,107 @@
+#include "../includes/client.h"
+#include "../includes/date_utils.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Command-line client for "flower_shop --serve".
+//
+//   flower_client [-s socket] [-u user -p password] [COMMAND ARGS...]
+//
+// Without a command, requests are read from stdin, one per line. Arguments written as
+// YYYY-MM-DD are sent as day numbers, and results are printed tab-separated.
+
+static void printUsage() {
+    std::cerr << "Usage: flower_client [-s socket] [-u user -p password] [COMMAND ARGS...]\n";
+}
+
+static bool runCommand(Client& client, std::vector<std::string> request, bool printRows = true) {
+    for (auto& argument : request) {
+        int days;
+        if (parseDate(argument, days)) {
+            argument = std::to_string(days);
+        }
+    }
+
+    Message response;
+    if (!client.call(request, response)) {
+        std::cerr << "Connection to server lost" << std::endl;
+        return false;
+    }
+
+    if (response[0][0] != "OK") {
+        std::cerr << "Error: " << (response[0].size() > 1 ? response[0][1] : "unknown") << std::endl;
+        return false;
+    }
+
+    for (size_t i = 1; printRows && i < response.size(); i++) {
+        for (size_t j = 0; j < response[i].size(); j++) {
+            std::cout << (j ? "\t" : "") << response[i][j];
+        }
+        std::cout << "\n";
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string socketPath = "flower_shop.sock";
+    std::string username;
+    std::string password;
+    std::vector<std::string> command;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (command.empty() && (arg == "-s" || arg == "-u" || arg == "-p") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "-s") {
+                socketPath = value;
+            } else if (arg == "-u") {
+                username = value;
+            } else {
+                password = value;
+            }
+        } else if (command.empty() && (arg == "-h" || arg == "--help")) {
+            printUsage();
+            return 0;
+        } else {
+            command.push_back(arg);
+        }
+    }
+
+    Client client(socketPath);
+    if (!client.connect()) {
+        std::cerr << "Can't connect to " << socketPath << std::endl;
+        return 1;
+    }
+
+    if (!username.empty() && !runCommand(client, {"LOGIN", username, password}, false)) {
+        return 1;
+    }
+
+    if (!command.empty()) {
+        return runCommand(client, command) ? 0 : 1;
+    }
+
+    int failures = 0;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream words(line);
+        std::vector<std::string> request;
+        std::string word;
+        while (words >> word) {
+            request.push_back(word);
+        }
+        if (request.empty()) {
+            continue;
+        }
+        if (!runCommand(client, request)) {
+            failures++;
+            if (!client.isConnected()) {
+                return 1;
+            }
+        }
+    }
+
+    return failures ? 1 : 0;
+}
@@ -1,17 +1,225 @@
 #include "../includes/database.h"
 #include "../includes/authentication.h"
+#include "../includes/backup_manager.h"
+#include "../includes/date_utils.h"
+#include "../includes/multi_shop_database.h"
+#include "../includes/server.h"
 #include "../includes/ui.h"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+static const char* DATABASE_PATH = "flower.db";
+// Password hashing cost is tuned at startup so a login takes about this long on this machine
+static const double PASSWORD_HASH_TARGET_MS = 50.0;
+
+static Server* activeServer = nullptr;
+
+static void handleStopSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+// flower_shop --serve [socket]: serve all counter terminals from one process
+static int serve(Database& db, Authentication& auth, const std::string& socketPath, const std::string& journalPath) {
+    if (!db.connect()) {
+        std::cerr << "Failed to connect to the database." << std::endl;
+        return 1;
+    }
+
+    // Replays what a previous run left in the journal before any client connects
+    std::unique_ptr<OrderJournal> journal;
+    if (!journalPath.empty()) {
+        journal = std::make_unique<OrderJournal>(journalPath, DATABASE_PATH, db.getOptions());
+        if (!journal->open()) {
+            return 1;
+        }
+    }
+
+    Server server(db, auth, socketPath);
+    if (!server.listen()) {
+        return 1;
+    }
+    server.setOrderJournal(journal.get());
+
+    activeServer = &server;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    std::cout << "Serving on " << socketPath << std::endl;
+    server.run();
+
+    activeServer = nullptr;
+    return 0;
+}
+
+// flower_shop --chain START END SHOP_DB...: chain-wide revenue and sales over several branches
+static int chainReport(const std::vector<std::string>& shopPaths, const std::string& start, const std::string& end,
+                       const DatabaseOptions& options) {
+    int startDate, endDate;
+    if (!parseDate(start, startDate) || !parseDate(end, endDate)) {
+        std::cerr << "Dates must be YYYY-MM-DD" << std::endl;
+        return 1;
+    }
+
+    std::vector<MultiShopDatabase::Shop> shops;
+    for (const auto& path : shopPaths) {
+        shops.push_back({path, path});
+    }
+    MultiShopDatabase chain(shops, options);
+    if (!chain.connect()) {
+        return 1;
+    }
+
+    auto revenue = chain.getTotalRevenue(startDate, endDate);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Revenue " << start << " .. " << end << "\n";
+    for (const auto& [shop, total] : revenue.byShop) {
+        std::cout << "  " << std::left << std::setw(40) << shop << std::right << std::setw(14) << total << "\n";
+    }
+    std::cout << "  " << std::left << std::setw(40) << "Chain" << std::right << std::setw(14) << revenue.total
+              << "\n\nComposition sales (all time)\n";
+    for (const auto& [composition, sales] : chain.getCompositionSalesSummary().total) {
+        std::cout << "  " << std::left << std::setw(40) << composition << std::right << std::setw(6) << sales.first
+                  << std::setw(14) << sales.second << "\n";
+    }
+    return 0;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: flower_shop [--preset NAME | --config FILE] [--serve [SOCKET] [--journal FILE] | --record FILE]\n"
+              << "       flower_shop [--preset NAME | --config FILE] --chain START END SHOP_DB...\n"
+              << "       flower_shop [--preset NAME | --config FILE] --archive YEAR...\n"
+              << "       flower_shop --backup FILE\n"
+              << "  presets: default, counter_terminal, reporting_server\n"
+              << "  --journal: acknowledge orders once journaled and insert them in batches\n"
+              << "  --record: save the session's input as a replay script (see session_replay_bench)\n"
+              << "  --chain: revenue and sales of several branch databases, per branch and combined\n"
+              << "  --archive: move the orders of closed years to per-year archive files, then exit\n"
+              << "  --backup: copy the database to FILE while the shop keeps running, then exit\n";
+}
+
+int main(int argc, char** argv) {
+    DatabaseOptions options;
+    bool serverMode = false;
+    std::string socketPath = "flower_shop.sock";
+    std::string journalPath;
+    std::string recordPath;
+    std::vector<std::string> chainArgs;
+    std::vector<int> archiveYears;
+    std::string backupPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--serve") {
+            serverMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                socketPath = argv[++i];
+            }
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--chain" && i + 3 < argc) {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                chainArgs.push_back(argv[++i]);
+            }
+        } else if (arg == "--archive" && i + 1 < argc) {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                archiveYears.push_back(std::atoi(argv[++i]));
+            }
+        } else if (arg == "--backup" && i + 1 < argc) {
+            backupPath = argv[++i];
+        } else if (arg == "--preset" && i + 1 < argc) {
+            if (!DatabaseOptions::preset(argv[++i], options)) {
+                std::cerr << "Unknown preset: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--config" && i + 1 < argc) {
+            if (!DatabaseOptions::loadFromFile(argv[++i], options)) {
+                return 1;
+            }
+        } else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if ((!journalPath.empty() && !serverMode) || (!recordPath.empty() && serverMode)) {
+        printUsage();
+        return 1;
+    }
+    if (!chainArgs.empty()) {
+        if (chainArgs.size() < 3 || serverMode || !recordPath.empty()) {
+            printUsage();
+            return 1;
+        }
+        return chainReport({chainArgs.begin() + 2, chainArgs.end()}, chainArgs[0], chainArgs[1], options);
+    }
+    if (!backupPath.empty()) {
+        if (serverMode || !recordPath.empty() || !archiveYears.empty()) {
+            printUsage();
+            return 1;
+        }
+        BackupManager backups(DATABASE_PATH);
+        if (!backups.start() || !backups.startBackup(backupPath) || !backups.waitForBackup()) {
+            return 1;
+        }
+        BackupManager::Status status = backups.getStatus();
+        std::cout << "Backed up " << status.pageCount << " pages to " << backupPath << " in " << std::fixed
+                  << std::setprecision(0) << status.elapsedMs << " ms" << std::endl;
+        return 0;
+    }
+    // The journal applies orders through a second connection
+    if (!journalPath.empty() && options.busyTimeoutMs == 0) {
+        options.busyTimeoutMs = 5000;
+    }
 
-int main() {
     // Initialize the database with the path to the SQLite file
-    Database db("flower.db");
+    Database db(DATABASE_PATH, options);
+    
+    if (!archiveYears.empty()) {
+        if (serverMode || !recordPath.empty() || !db.connect()) {
+            return 1;
+        }
+        for (int year : archiveYears) {
+            if (!db.archiveYear(year)) {
+                return 1;
+            }
+            std::cout << "Archived " << year << std::endl;
+        }
+        return 0;
+    }
+    
+    // Without automatic checkpoints the WAL is checkpointed from a background thread
+    BackupManager checkpoints(DATABASE_PATH);
+    if (!options.autoCheckpoint && !options.readOnly && !options.immutable) {
+        checkpoints.start();
+    }
     
     // Initialize authentication system
-    Authentication auth;
+    Authentication auth(PasswordHasher::calibrate(PASSWORD_HASH_TARGET_MS));
+    
+    if (serverMode) {
+        return serve(db, auth, socketPath, journalPath);
+    }
     
     // Initialize the UI with the database and authentication objects
     UI ui(db, auth);
+    std::ofstream script;
+    if (!recordPath.empty()) {
+        script.open(recordPath);
+        if (!script) {
+            std::cerr << "Cannot write " << recordPath << std::endl;
+            return 1;
+        }
+        ui.recordTo(&script);
+    }
     
     // Start the UI
     ui.start();
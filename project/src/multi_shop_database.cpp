@@ -0,0 +1,160 @@
+#include "../includes/multi_shop_database.h"
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <set>
+
+MultiShopDatabase::MultiShopDatabase(const std::vector<Shop>& shops, const DatabaseOptions& options) {
+    std::set<std::string> names;
+    for (const auto& shop : shops) {
+        if (!names.insert(shop.name).second && duplicateName_.empty()) {
+            duplicateName_ = shop.name;
+        }
+        Shard shard;
+        shard.name = shop.name;
+        shard.db = std::make_unique<Database>(shop.path, options);
+        shard.worker = std::make_unique<ThreadPool>(1);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+MultiShopDatabase::~MultiShopDatabase() {
+    disconnect();
+}
+
+template <typename T>
+std::vector<T> MultiShopDatabase::runOnAll(const std::function<T(Database&)>& query) {
+    std::vector<std::promise<T>> promises(shards_.size());
+    std::vector<std::future<T>> futures;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        futures.push_back(promises[i].get_future());
+        Database* db = shards_[i].db.get();
+        std::promise<T>* promise = &promises[i];
+        shards_[i].worker->submit([db, promise, &query] {
+            try {
+                promise->set_value(query(*db));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    }
+
+    std::vector<T> results;
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+template <typename T>
+MultiShopDatabase::ChainReport<T> MultiShopDatabase::collect(const std::function<T(Database&)>& query,
+                                                             const std::function<void(T&, const T&)>& merge) {
+    ChainReport<T> report{};
+    std::vector<T> results = runOnAll(query);
+    for (size_t i = 0; i < results.size(); i++) {
+        merge(report.total, results[i]);
+        report.byShop[shards_[i].name] = std::move(results[i]);
+    }
+    return report;
+}
+
+bool MultiShopDatabase::connect() {
+    if (!duplicateName_.empty()) {
+        std::cerr << "Two shops are named " << duplicateName_ << std::endl;
+        return false;
+    }
+
+    // Opening may migrate a shop's schema, so the shops connect in parallel as well
+    std::vector<bool> connected = runOnAll<bool>([](Database& db) { return db.connect(); });
+    bool allConnected = true;
+    for (size_t i = 0; i < connected.size(); i++) {
+        if (!connected[i]) {
+            std::cerr << "Cannot connect to shop " << shards_[i].name << std::endl;
+            allConnected = false;
+        }
+    }
+    return allConnected;
+}
+
+void MultiShopDatabase::disconnect() {
+    runOnAll<bool>([](Database& db) {
+        db.disconnect();
+        return true;
+    });
+}
+
+size_t MultiShopDatabase::getShopCount() const {
+    return shards_.size();
+}
+
+MultiShopDatabase::ChainReport<double> MultiShopDatabase::getTotalRevenue(int startDate, int endDate) {
+    return collect<double>([=](Database& db) { return db.getTotalRevenue(startDate, endDate); },
+                           [](double& total, const double& shop) { total += shop; });
+}
+
+MultiShopDatabase::ChainReport<std::vector<std::pair<int, int>>> MultiShopDatabase::getOrdersByUrgency() {
+    using Counts = std::vector<std::pair<int, int>>;
+    return collect<Counts>([](Database& db) { return db.getOrdersByUrgency(); },
+                           [](Counts& total, const Counts& shop) {
+                               for (const auto& [rate, count] : shop) {
+                                   auto it = std::lower_bound(total.begin(), total.end(), std::make_pair(rate, 0));
+                                   if (it != total.end() && it->first == rate) {
+                                       it->second += count;
+                                   } else {
+                                       total.insert(it, {rate, count});
+                                   }
+                               }
+                           });
+}
+
+MultiShopDatabase::ChainReport<std::map<std::string, std::map<std::string, int>>>
+MultiShopDatabase::getFlowerUsageByPeriod(int startDate, int endDate) {
+    using Usage = std::map<std::string, std::map<std::string, int>>;
+    return collect<Usage>([=](Database& db) { return db.getFlowerUsageByPeriod(startDate, endDate); },
+                          [](Usage& total, const Usage& shop) {
+                              for (const auto& [flower, varieties] : shop) {
+                                  for (const auto& [variety, stems] : varieties) {
+                                      total[flower][variety] += stems;
+                                  }
+                              }
+                          });
+}
+
+MultiShopDatabase::ChainReport<std::map<std::string, std::pair<int, double>>>
+MultiShopDatabase::getCompositionSalesSummary() {
+    using Sales = std::map<std::string, std::pair<int, double>>;
+    return collect<Sales>([](Database& db) { return db.getCompositionSalesSummary(); },
+                          [](Sales& total, const Sales& shop) {
+                              for (const auto& [composition, sales] : shop) {
+                                  total[composition].first += sales.first;
+                                  total[composition].second += sales.second;
+                              }
+                          });
+}
+
+MultiShopDatabase::ChainReport<std::vector<Database::RevenueBucket>>
+MultiShopDatabase::getRevenueSeries(int startDate, int endDate, Database::Granularity granularity) {
+    using Series = std::vector<Database::RevenueBucket>;
+    ChainReport<Series> report =
+        collect<Series>([=](Database& db) { return db.getRevenueSeries(startDate, endDate, granularity); },
+                        [](Series& total, const Series& shop) {
+                            // Every shop has the same calendar buckets; the surcharge is summed as an
+                            // amount here and turned back into a share below
+                            if (total.empty()) {
+                                total = shop;
+                                for (auto& bucket : total) {
+                                    bucket.urgencyFeeShare *= bucket.revenue;
+                                }
+                                return;
+                            }
+                            for (size_t i = 0; i < total.size() && i < shop.size(); i++) {
+                                total[i].revenue += shop[i].revenue;
+                                total[i].orderCount += shop[i].orderCount;
+                                total[i].urgencyFeeShare += shop[i].urgencyFeeShare * shop[i].revenue;
+                            }
+                        });
+    for (auto& bucket : report.total) {
+        bucket.urgencyFeeShare = bucket.revenue > 0.0 ? bucket.urgencyFeeShare / bucket.revenue : 0.0;
+    }
+    return report;
+}
@@ -0,0 +1,297 @@
+#include "../includes/order_journal.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+// Journal records are fixed-size, in host byte order:
+//   uint64 sequence, int32 customerId, compositionId, orderDate, fulfillmentDate, quantity,
+//   uint32 checksum of the preceding 28 bytes.
+// A record that is short or fails its checksum marks the torn end of the last write.
+static const size_t RECORD_SIZE = 32;
+static const size_t CHECKSUM_OFFSET = 28;
+
+// FNV-1a
+static uint32_t checksum(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void encodeRecord(uint64_t sequence, const Database::NewOrder& order, unsigned char* record) {
+    int32_t fields[5] = {order.customerId, order.compositionId, order.orderDate, order.fulfillmentDate,
+                         order.quantity};
+    std::memcpy(record, &sequence, sizeof(sequence));
+    std::memcpy(record + sizeof(sequence), fields, sizeof(fields));
+    uint32_t sum = checksum(record, CHECKSUM_OFFSET);
+    std::memcpy(record + CHECKSUM_OFFSET, &sum, sizeof(sum));
+}
+
+static bool decodeRecord(const unsigned char* record, uint64_t& sequence, Database::NewOrder& order) {
+    uint32_t sum;
+    std::memcpy(&sum, record + CHECKSUM_OFFSET, sizeof(sum));
+    if (sum != checksum(record, CHECKSUM_OFFSET)) {
+        return false;
+    }
+
+    int32_t fields[5];
+    std::memcpy(&sequence, record, sizeof(sequence));
+    std::memcpy(fields, record + sizeof(sequence), sizeof(fields));
+    order = {fields[0], fields[1], fields[2], fields[3], fields[4]};
+    return true;
+}
+
+static bool writeAll(int fd, const unsigned char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+OrderJournal::OrderJournal(const std::string& journalPath, const std::string& dbPath, const DatabaseOptions& options)
+    : journalPath_(journalPath), db_(dbPath, options), fd_(-1), fileSize_(0), nextSequence_(1),
+      durableSequence_(0), appliedSequence_(0), running_(false), stopping_(false), writerDone_(false),
+      failed_(false) {}
+
+OrderJournal::~OrderJournal() {
+    close();
+}
+
+bool OrderJournal::open() {
+    if (running_) {
+        return true;
+    }
+    if (!db_.connect()) {
+        return false;
+    }
+
+    fd_ = ::open(journalPath_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Can't open order journal " << journalPath_ << ": " << std::strerror(errno) << std::endl;
+        db_.disconnect();
+        return false;
+    }
+    if (!replay()) {
+        ::close(fd_);
+        fd_ = -1;
+        db_.disconnect();
+        return false;
+    }
+
+    stopping_ = false;
+    writerDone_ = false;
+    failed_ = false;
+    running_ = true;
+    writer_ = std::thread([this] { writerLoop(); });
+    applier_ = std::thread([this] { applierLoop(); });
+    return true;
+}
+
+bool OrderJournal::replay() {
+    uint64_t applied = db_.getAppliedJournalSequence();
+    uint64_t last = applied;
+    std::vector<Database::NewOrder> orders;
+    long long validSize = 0;
+
+    unsigned char record[RECORD_SIZE];
+    while (::pread(fd_, record, RECORD_SIZE, validSize) == static_cast<ssize_t>(RECORD_SIZE)) {
+        uint64_t sequence;
+        Database::NewOrder order;
+        if (!decodeRecord(record, sequence, order)) {
+            break;
+        }
+        if (sequence <= last) {
+            // Records from before the last truncation that are already applied are fine;
+            // anything else out of order is not a record we wrote
+            if (sequence > applied) {
+                break;
+            }
+            validSize += RECORD_SIZE;
+            continue;
+        }
+        validSize += RECORD_SIZE;
+
+        orders.push_back(order);
+        last = sequence;
+        if (orders.size() == MAX_APPLY_BATCH) {
+            if (!db_.applyJournaledOrders(orders, last)) {
+                return false;
+            }
+            orders.clear();
+        }
+    }
+    if (!orders.empty() && !db_.applyJournaledOrders(orders, last)) {
+        return false;
+    }
+
+    // Drop a torn tail so that new records follow the last complete one
+    if (::ftruncate(fd_, validSize) != 0) {
+        std::cerr << "Can't truncate order journal: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    fileSize_ = validSize;
+    nextSequence_ = last + 1;
+    durableSequence_ = last;
+    appliedSequence_ = last;
+    return true;
+}
+
+void OrderJournal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    writerWake_.notify_all();
+    writer_.join();
+    applier_.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        ::close(fd_);
+        fd_ = -1;
+        db_.disconnect();
+    }
+    appliedChanged_.notify_all();
+}
+
+bool OrderJournal::submit(const Database::NewOrder& order) {
+    // Checked here so that a bad order is refused instead of acknowledged and then dropped
+    if (order.quantity <= 0 || order.fulfillmentDate < order.orderDate ||
+        !db_.orderReferencesExist(order.customerId, order.compositionId)) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_ || stopping_ || failed_) {
+        return false;
+    }
+
+    uint64_t sequence = nextSequence_++;
+    pending_.push_back({sequence, order});
+    writerWake_.notify_one();
+    durableChanged_.wait(lock, [&] { return durableSequence_ >= sequence || failed_; });
+    return durableSequence_ >= sequence;
+}
+
+void OrderJournal::waitUntilApplied() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    appliedChanged_.wait(lock, [&] { return appliedSequence_ >= durableSequence_ || !running_; });
+}
+
+uint64_t OrderJournal::getDurableSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return durableSequence_;
+}
+
+uint64_t OrderJournal::getAppliedSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return appliedSequence_;
+}
+
+void OrderJournal::writerLoop() {
+    std::vector<unsigned char> buffer;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        writerWake_.wait(lock, [&] { return !pending_.empty() || stopping_; });
+        if (pending_.empty()) {
+            break;
+        }
+
+        // Everything submitted up to now goes out in this write
+        std::vector<Entry> group;
+        group.swap(pending_);
+        bool truncate = appliedSequence_ == durableSequence_ && fileSize_ >= TRUNCATE_THRESHOLD;
+        lock.unlock();
+
+        // Only this thread writes the file, and every record in it is already applied
+        bool ok = true;
+        if (truncate) {
+            ok = ::ftruncate(fd_, 0) == 0;
+            if (ok) {
+                fileSize_ = 0;
+            }
+        }
+
+        buffer.resize(group.size() * RECORD_SIZE);
+        for (size_t i = 0; i < group.size(); i++) {
+            encodeRecord(group[i].sequence, group[i].order, &buffer[i * RECORD_SIZE]);
+        }
+        ok = ok && writeAll(fd_, buffer.data(), buffer.size()) && ::fdatasync(fd_) == 0;
+        if (!ok) {
+            std::cerr << "Order journal write failed: " << std::strerror(errno) << std::endl;
+            // Unacknowledged records must not be replayed later
+            if (::ftruncate(fd_, fileSize_) != 0) {
+                std::cerr << "Can't truncate order journal: " << std::strerror(errno) << std::endl;
+            }
+        } else {
+            fileSize_ += static_cast<long long>(buffer.size());
+        }
+
+        lock.lock();
+        if (!ok) {
+            failed_ = true;
+            durableChanged_.notify_all();
+            continue;
+        }
+        durableSequence_ = group.back().sequence;
+        applyQueue_.insert(applyQueue_.end(), group.begin(), group.end());
+        durableChanged_.notify_all();
+        applierWake_.notify_one();
+    }
+
+    writerDone_ = true;
+    applierWake_.notify_one();
+}
+
+void OrderJournal::applierLoop() {
+    std::vector<Database::NewOrder> orders;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        applierWake_.wait(lock, [&] { return !applyQueue_.empty() || writerDone_; });
+        if (applyQueue_.empty()) {
+            break;
+        }
+
+        size_t count = std::min(applyQueue_.size(), MAX_APPLY_BATCH);
+        uint64_t lastSequence = applyQueue_[count - 1].sequence;
+        orders.clear();
+        for (size_t i = 0; i < count; i++) {
+            orders.push_back(applyQueue_[i].order);
+        }
+        lock.unlock();
+
+        bool applied = db_.applyJournaledOrders(orders, lastSequence);
+
+        lock.lock();
+        if (!applied) {
+            // Usually a lock held by another connection for longer than the busy timeout.
+            // When shutting down, the entries stay in the journal for the next open().
+            if (writerDone_) {
+                break;
+            }
+            applierWake_.wait_for(lock, std::chrono::milliseconds(100));
+            continue;
+        }
+        applyQueue_.erase(applyQueue_.begin(), applyQueue_.begin() + count);
+        appliedSequence_ = lastSequence;
+        appliedChanged_.notify_all();
+    }
+    appliedChanged_.notify_all();
+}
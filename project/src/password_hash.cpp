@@ -0,0 +1,222 @@
+#include "../includes/password_hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+static const size_t SALT_LENGTH = 16;
+static const size_t KEY_LENGTH = 32;
+static const int MIN_LOG_N = 10;
+
+static bool validParams(const PasswordHashParams& params) {
+    // Caps memory per evaluation at 1 GiB
+    return params.logN >= 1 && params.logN <= 24 && params.r >= 1 && params.r <= 32 && params.p >= 1 &&
+           params.p <= 16 && params.memoryBytes() <= (size_t(1) << 30);
+}
+
+// --- hash string format ---
+
+static const char* BASE64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static std::string base64Encode(const uint8_t* data, size_t length) {
+    std::string text;
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (size_t i = 0; i < length; i++) {
+        buffer = (buffer << 8) | data[i];
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            text += BASE64[(buffer >> bits) & 63];
+        }
+    }
+    if (bits > 0) {
+        text += BASE64[(buffer << (6 - bits)) & 63];
+    }
+    return text;
+}
+
+static bool base64Decode(const std::string& text, std::string& data) {
+    data.clear();
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : text) {
+        const char* pos = std::strchr(BASE64, c);
+        if (c == '\0' || !pos) {
+            return false;
+        }
+        buffer = (buffer << 6) | uint32_t(pos - BASE64);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            data += char((buffer >> bits) & 0xff);
+        }
+    }
+    return true;
+}
+
+struct ParsedHash {
+    PasswordHashParams params;
+    std::string salt;
+    std::string key;
+};
+
+static bool parseHash(const std::string& stored, ParsedHash& parsed) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = stored.find('$', start);
+        fields.push_back(stored.substr(start, end - start));
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    if (fields.size() != 6 || !fields[0].empty() || fields[1] != "scrypt" || fields[2] != "v=1") {
+        return false;
+    }
+
+    int consumed = 0;
+    PasswordHashParams& params = parsed.params;
+    if (std::sscanf(fields[3].c_str(), "ln=%d,r=%d,p=%d%n", &params.logN, &params.r, &params.p, &consumed) != 3 ||
+        size_t(consumed) != fields[3].size() || !validParams(params)) {
+        return false;
+    }
+
+    return base64Decode(fields[4], parsed.salt) && base64Decode(fields[5], parsed.key) && !parsed.salt.empty() &&
+           !parsed.key.empty();
+}
+
+static std::string formatHash(const PasswordHashParams& params, const std::string& salt,
+                              const std::vector<uint8_t>& key) {
+    return "$scrypt$v=1$ln=" + std::to_string(params.logN) + ",r=" + std::to_string(params.r) +
+           ",p=" + std::to_string(params.p) + "$" +
+           base64Encode(reinterpret_cast<const uint8_t*>(salt.data()), salt.size()) + "$" +
+           base64Encode(key.data(), key.size());
+}
+
+// --- PasswordHashParams / PasswordHasher ---
+
+size_t PasswordHashParams::memoryBytes() const {
+    return size_t(128) * r * (size_t(1) << logN);
+}
+
+bool PasswordHashParams::operator==(const PasswordHashParams& other) const {
+    return logN == other.logN && r == other.r && p == other.p;
+}
+
+PasswordHasher::PasswordHasher(const PasswordHashParams& params, size_t maxConcurrent)
+    : params_(params), maxConcurrent_(maxConcurrent), active_(0), peak_(0) {
+    if (maxConcurrent_ == 0) {
+        maxConcurrent_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+bool PasswordHasher::scrypt(const std::string& password, const std::string& salt, const PasswordHashParams& params,
+                            size_t keyLength, std::vector<uint8_t>& key) {
+    if (!validParams(params) || keyLength == 0) {
+        return false;
+    }
+
+    // OpenSSL refuses evaluations above maxmem; its working set is the N + 2 blocks of V plus
+    // the p lanes
+    uint64_t maxMemory = params.memoryBytes() + size_t(128) * params.r * (params.p + 2);
+    key.resize(keyLength);
+    return EVP_PBE_scrypt(password.data(), password.size(), reinterpret_cast<const unsigned char*>(salt.data()),
+                          salt.size(), uint64_t(1) << params.logN, params.r, params.p, maxMemory, key.data(),
+                          keyLength) == 1;
+}
+
+bool PasswordHasher::derive(const std::string& password, const std::string& salt, const PasswordHashParams& params,
+                            size_t keyLength, std::vector<uint8_t>& key) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slotFree_.wait(lock, [this] { return active_ < maxConcurrent_; });
+        active_++;
+        peak_ = std::max(peak_, active_);
+    }
+
+    bool derived = scrypt(password, salt, params, keyLength, key);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_--;
+    }
+    slotFree_.notify_one();
+    return derived;
+}
+
+std::string PasswordHasher::hash(const std::string& password) {
+    std::string salt(SALT_LENGTH, '\0');
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(&salt[0]), int(salt.size())) != 1) {
+        return "";
+    }
+
+    std::vector<uint8_t> key;
+    if (!derive(password, salt, params_, KEY_LENGTH, key)) {
+        return "";
+    }
+    return formatHash(params_, salt, key);
+}
+
+bool PasswordHasher::verify(const std::string& password, const std::string& stored) {
+    ParsedHash parsed;
+    if (!parseHash(stored, parsed)) {
+        return false;
+    }
+
+    std::vector<uint8_t> key;
+    if (!derive(password, parsed.salt, parsed.params, parsed.key.size(), key)) {
+        return false;
+    }
+    // Comparison time does not depend on where the first difference is
+    return CRYPTO_memcmp(key.data(), parsed.key.data(), key.size()) == 0;
+}
+
+bool PasswordHasher::needsRehash(const std::string& stored) const {
+    ParsedHash parsed;
+    return !parseHash(stored, parsed) || !(parsed.params == params_);
+}
+
+const PasswordHashParams& PasswordHasher::params() const {
+    return params_;
+}
+
+size_t PasswordHasher::maxConcurrent() const {
+    return maxConcurrent_;
+}
+
+size_t PasswordHasher::peakConcurrent() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+}
+
+PasswordHashParams PasswordHasher::calibrate(double targetMs, int r, int maxLogN) {
+    PasswordHashParams params;
+    params.r = r;
+    params.p = 1;
+
+    // Each step doubles the work, so the loop costs about twice the final evaluation
+    double previousMs = 0.0;
+    std::vector<uint8_t> key;
+    for (params.logN = MIN_LOG_N; params.logN <= maxLogN; params.logN++) {
+        auto start = std::chrono::steady_clock::now();
+        scrypt("calibration", "calibration salt", params, KEY_LENGTH, key);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (elapsedMs >= targetMs) {
+            if (params.logN > MIN_LOG_N && targetMs - previousMs < elapsedMs - targetMs) {
+                params.logN--;
+            }
+            return params;
+        }
+        previousMs = elapsedMs;
+    }
+
+    params.logN = maxLogN;
+    return params;
+}
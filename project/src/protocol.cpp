@@ -0,0 +1,112 @@
+#include "../includes/protocol.h"
+#include <cstdint>
+
+static void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static bool readVarint(const std::string& in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) {
+            return false;
+        }
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string encodeMessage(const Message& message) {
+    std::string out;
+    appendVarint(out, message.size());
+    for (const auto& row : message) {
+        appendVarint(out, row.size());
+        for (const auto& field : row) {
+            appendVarint(out, field.size());
+            out += field;
+        }
+    }
+    return out;
+}
+
+bool decodeMessage(const std::string& payload, Message& message) {
+    message.clear();
+    size_t pos = 0;
+    uint64_t rowCount;
+    if (!readVarint(payload, pos, rowCount) || rowCount > payload.size()) {
+        return false;
+    }
+
+    message.reserve(rowCount);
+    for (uint64_t r = 0; r < rowCount; r++) {
+        uint64_t fieldCount;
+        if (!readVarint(payload, pos, fieldCount) || fieldCount > payload.size() - pos) {
+            return false;
+        }
+
+        std::vector<std::string> row;
+        row.reserve(fieldCount);
+        for (uint64_t f = 0; f < fieldCount; f++) {
+            uint64_t length;
+            if (!readVarint(payload, pos, length) || length > payload.size() - pos) {
+                return false;
+            }
+            row.emplace_back(payload, pos, length);
+            pos += length;
+        }
+        message.push_back(std::move(row));
+    }
+
+    return pos == payload.size();
+}
+
+std::string encodeFrame(const std::string& payload) {
+    std::string frame;
+    frame.reserve(4 + payload.size());
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    frame.push_back(static_cast<char>(length >> 24));
+    frame.push_back(static_cast<char>(length >> 16));
+    frame.push_back(static_cast<char>(length >> 8));
+    frame.push_back(static_cast<char>(length));
+    frame += payload;
+    return frame;
+}
+
+bool extractFrame(std::string& buffer, std::string& payload, bool& error) {
+    error = false;
+    if (buffer.size() < 4) {
+        return false;
+    }
+
+    uint32_t length = (static_cast<uint32_t>(static_cast<uint8_t>(buffer[0])) << 24) |
+                      (static_cast<uint32_t>(static_cast<uint8_t>(buffer[1])) << 16) |
+                      (static_cast<uint32_t>(static_cast<uint8_t>(buffer[2])) << 8) |
+                      static_cast<uint32_t>(static_cast<uint8_t>(buffer[3]));
+    if (length > MAX_FRAME_SIZE) {
+        error = true;
+        return false;
+    }
+    if (buffer.size() < 4 + static_cast<size_t>(length)) {
+        return false;
+    }
+
+    payload.assign(buffer, 4, length);
+    buffer.erase(0, 4 + static_cast<size_t>(length));
+    return true;
+}
+
+Message okResponse() {
+    return {{"OK"}};
+}
+
+Message errorResponse(const std::string& error) {
+    return {{"ERR", error}};
+}
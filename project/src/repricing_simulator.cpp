@@ -0,0 +1,117 @@
+#include "../includes/repricing_simulator.h"
+#include "../includes/thread_pool.h"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+RepricingSimulator::RepricingSimulator(Database& db, size_t workerCount)
+    : db_(db), workerCount_(std::max<size_t>(workerCount, 1)) {}
+
+bool RepricingSimulator::load(int startDate, int endDate) {
+    if (!db_.isConnected()) {
+        return false;
+    }
+
+    flowerIds_.clear();
+    currentPrices_.clear();
+    std::unordered_map<int, size_t> flowerColumn;
+    for (const auto& flower : db_.getAllFlowers()) {
+        flowerColumn[flower.id] = flowerIds_.size();
+        flowerIds_.push_back(flower.id);
+        currentPrices_.push_back(flower.price);
+    }
+
+    // Orders only matter through their composition, so sum them per composition first
+    // and expand each composition's recipe once
+    std::unordered_map<int, std::pair<double, double>> sold;  // CompositionID -> (units, weighted units)
+    for (const auto& order : db_.getOrdersByDateRange(startDate, endDate)) {
+        auto& units = sold[order.compositionId];
+        units.first += order.quantity;
+        units.second += order.quantity * (1.0 + order.urgencyRate);
+    }
+
+    stems_.assign(flowerIds_.size(), 0.0);
+    weightedStems_.assign(flowerIds_.size(), 0.0);
+    for (const auto& line : db_.getRecipeLines()) {
+        auto units = sold.find(line.compositionId);
+        auto column = flowerColumn.find(line.flowerId);
+        if (units == sold.end() || column == flowerColumn.end()) {
+            continue;
+        }
+        stems_[column->second] += line.quantity * units->second.first;
+        weightedStems_[column->second] += line.quantity * units->second.second;
+    }
+    return true;
+}
+
+const std::vector<int>& RepricingSimulator::flowerIds() const {
+    return flowerIds_;
+}
+
+const std::vector<double>& RepricingSimulator::currentPrices() const {
+    return currentPrices_;
+}
+
+RepricingSimulator::Outcome RepricingSimulator::baseline() const {
+    return evaluateOne(currentPrices_.data());
+}
+
+RepricingSimulator::Outcome RepricingSimulator::evaluateOne(const double* prices) const {
+    // Four independent partial sums per product so the loop has no serial dependency
+    // and compiles to packed multiply-adds
+    const size_t count = flowerIds_.size();
+    const double* stems = stems_.data();
+    const double* weighted = weightedStems_.data();
+    double base[4] = {0.0, 0.0, 0.0, 0.0};
+    double total[4] = {0.0, 0.0, 0.0, 0.0};
+    bool withinRule = true;
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (size_t lane = 0; lane < 4; lane++) {
+            base[lane] += prices[i + lane] * stems[i + lane];
+            total[lane] += prices[i + lane] * weighted[i + lane];
+        }
+    }
+    for (; i < count; i++) {
+        base[0] += prices[i] * stems[i];
+        total[0] += prices[i] * weighted[i];
+    }
+    for (i = 0; i < count; i++) {
+        withinRule &= prices[i] <= currentPrices_[i] * Database::MAX_PRICE_INCREASE;
+    }
+
+    Outcome outcome;
+    outcome.baseRevenue = (base[0] + base[1]) + (base[2] + base[3]);
+    outcome.totalRevenue = (total[0] + total[1]) + (total[2] + total[3]);
+    outcome.urgencyFees = outcome.totalRevenue - outcome.baseRevenue;
+    outcome.withinPriceRule = withinRule;
+    return outcome;
+}
+
+bool RepricingSimulator::evaluate(const std::vector<std::vector<double>>& scenarios,
+                                  std::vector<Outcome>& outcomes) const {
+    for (const auto& prices : scenarios) {
+        if (prices.size() != flowerIds_.size()) {
+            std::cerr << "Price vector has " << prices.size() << " prices, expected " << flowerIds_.size()
+                      << std::endl;
+            return false;
+        }
+    }
+
+    outcomes.resize(scenarios.size());
+    size_t workers = std::min(workerCount_, std::max<size_t>(scenarios.size(), 1));
+    size_t sliceSize = (scenarios.size() + workers - 1) / workers;
+    {
+        ThreadPool pool(workers);
+        for (size_t w = 0; w < workers; w++) {
+            pool.submit([&, w] {
+                size_t end = std::min(scenarios.size(), (w + 1) * sliceSize);
+                for (size_t i = w * sliceSize; i < end; i++) {
+                    outcomes[i] = evaluateOne(scenarios[i].data());
+                }
+            });
+        }
+    }
+    return true;
+}
@@ -0,0 +1,497 @@
+#include "../includes/server.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// epoll tags of the two non-connection descriptors; connection ids start above them
+static const uint64_t LISTEN_TAG = 0;
+static const uint64_t WAKE_TAG = 1;
+
+// Commands, the permission each one needs (nullptr: no login needed) and argument count
+struct CommandSpec {
+    const char* name;
+    const char* operation;
+    size_t argCount;
+};
+
+static const CommandSpec COMMANDS[] = {
+    {"PING", nullptr, 0},
+    {"LOGIN", nullptr, 2},
+    {"LOGOUT", nullptr, 0},
+    {"REGISTER", nullptr, 3},
+    {"FLOWERS", "view_flowers", 0},
+    {"UPDATE_PRICE", "update_flower_price", 2},
+    {"COMPOSITIONS", "view_compositions", 0},
+    {"COMPOSITION_FLOWERS", "view_compositions", 1},
+    {"POPULAR_COMPOSITION", "view_compositions", 0},
+    {"CUSTOMERS", "create_order", 0},
+    {"CUSTOMER", "create_order", 1},
+    {"CREATE_ORDER", "create_order", 5},
+    {"ORDERS_BY_DATE", "view_orders", 1},
+    {"ORDERS_BY_RANGE", "view_orders", 2},
+    {"ORDER_SUMMARY", "view_orders", 1},
+    {"REVENUE", "view_reports", 2},
+    {"REVENUE_SERIES", "view_reports", 3},
+    {"URGENCY", "view_reports", 0},
+    {"FLOWER_USAGE", "view_reports", 2},
+    {"SALES_SUMMARY", "view_reports", 0},
+};
+
+static std::string formatNumber(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+}
+
+static std::vector<std::string> orderRow(const Database::Order& order) {
+    return {std::to_string(order.id), std::to_string(order.customerId), std::to_string(order.compositionId),
+            std::to_string(order.orderDate), std::to_string(order.fulfillmentDate),
+            std::to_string(order.quantity), formatNumber(order.urgencyRate)};
+}
+
+Server::Server(Database& db, Authentication& auth, const std::string& socketPath, size_t workerCount)
+    : db_(db), auth_(auth), journal_(nullptr), socketPath_(socketPath), workerCount_(workerCount),
+      listenFd_(-1), epollFd_(-1), wakeFd_(-1), running_(false), nextConnectionId_(WAKE_TAG + 1) {}
+
+Server::~Server() {
+    // Workers may still reference connections; finish them before closing anything
+    pool_.reset();
+
+    for (auto& entry : connections_) {
+        close(entry.second->fd);
+    }
+    connections_.clear();
+
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        unlink(socketPath_.c_str());
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+}
+
+bool Server::listen() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath_.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath_ << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath_.c_str(), sizeof(address.sun_path) - 1);
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        std::cerr << "Can't create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A stale socket file from a previous run would make bind() fail
+    unlink(socketPath_.c_str());
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listenFd_, SOMAXCONN) < 0) {
+        std::cerr << "Can't listen on " << socketPath_ << ": " << std::strerror(errno) << std::endl;
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        std::cerr << "Can't set up event loop: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_TAG;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.u64 = WAKE_TAG;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    pool_.reset(new ThreadPool(workerCount_));
+    running_ = true;
+    return true;
+}
+
+void Server::run() {
+    const int maxEvents = 64;
+    epoll_event events[maxEvents];
+
+    while (running_) {
+        int count = epoll_wait(epollFd_, events, maxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptConnections();
+                continue;
+            }
+            if (tag == WAKE_TAG) {
+                uint64_t value;
+                while (read(wakeFd_, &value, sizeof(value)) > 0) {
+                }
+                drainCompletions();
+                continue;
+            }
+
+            auto it = connections_.find(tag);
+            if (it == connections_.end()) {
+                continue;
+            }
+            auto connection = it->second;
+
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                readConnection(connection);
+            }
+            if (!connection->closing && (events[i].events & EPOLLOUT)) {
+                flushConnection(connection);
+            }
+        }
+    }
+}
+
+void Server::stop() {
+    running_ = false;
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd_, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void Server::setOrderJournal(OrderJournal* journal) {
+    journal_ = journal;
+}
+
+void Server::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+            }
+            return;
+        }
+
+        auto connection = std::make_shared<Connection>();
+        connection->id = nextConnectionId_++;
+        connection->fd = fd;
+        connections_[connection->id] = connection;
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = connection->id;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void Server::readConnection(const std::shared_ptr<Connection>& connection) {
+    char buffer[16384];
+    // The largest frame fits in this; anything past it stays in the socket until the frames
+    // before it are extracted
+    const size_t inputLimit = MAX_FRAME_SIZE + 4;
+    while (connection->input.size() < inputLimit) {
+        ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection->input.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        closeConnection(connection);
+        return;
+    }
+
+    std::string payload;
+    bool error = false;
+    while (extractFrame(connection->input, payload, error)) {
+        connection->pending.push_back(std::move(payload));
+    }
+    if (error) {
+        closeConnection(connection);
+        return;
+    }
+
+    dispatchNext(connection);
+    if (connection->busy) {
+        updateInterest(connection);
+    }
+}
+
+void Server::dispatchNext(const std::shared_ptr<Connection>& connection) {
+    if (connection->busy || connection->pending.empty()) {
+        return;
+    }
+
+    connection->busy = true;
+    std::string payload = std::move(connection->pending.front());
+    connection->pending.pop_front();
+
+    pool_->submit([this, connection, payload]() {
+        Message request;
+        Message response;
+        if (!decodeMessage(payload, request) || request.size() != 1 || request[0].empty()) {
+            response = errorResponse("malformed request");
+        } else {
+            response = handleRequest(connection->session, request[0]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(completionsMutex_);
+            completions_.push_back({connection->id, encodeFrame(encodeMessage(response))});
+        }
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd_, &one, sizeof(one));
+        (void)written;
+    });
+}
+
+void Server::drainCompletions() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock(completionsMutex_);
+        completions.swap(completions_);
+    }
+
+    for (auto& completion : completions) {
+        auto it = connections_.find(completion.connectionId);
+        if (it == connections_.end()) {
+            continue;
+        }
+        auto connection = it->second;
+        connection->busy = false;
+
+        if (connection->closing) {
+            connections_.erase(it);
+            continue;
+        }
+
+        // Dispatching first lets the flush set the interest mask once for both
+        connection->output += completion.frame;
+        dispatchNext(connection);
+        flushConnection(connection);
+    }
+}
+
+void Server::flushConnection(const std::shared_ptr<Connection>& connection) {
+    while (!connection->output.empty()) {
+        ssize_t sent = send(connection->fd, connection->output.data(), connection->output.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->output.erase(0, static_cast<size_t>(sent));
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        closeConnection(connection);
+        return;
+    }
+    updateInterest(connection);
+}
+
+void Server::updateInterest(const std::shared_ptr<Connection>& connection) {
+    epoll_event event{};
+    // While a request is in flight further input is left in the socket, so a client that
+    // keeps sending meets the kernel's flow control instead of growing input and pending
+    uint32_t events = 0;
+    if (!connection->busy) {
+        events |= EPOLLIN;
+    }
+    if (!connection->output.empty()) {
+        events |= EPOLLOUT;
+    }
+    event.events = events;
+    event.data.u64 = connection->id;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+void Server::closeConnection(const std::shared_ptr<Connection>& connection) {
+    if (connection->closing) {
+        return;
+    }
+
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+    close(connection->fd);
+    connection->closing = true;
+    connection->pending.clear();
+
+    // A busy connection stays registered until its worker reports back
+    if (!connection->busy) {
+        connections_.erase(connection->id);
+    }
+}
+
+Message Server::handleRequest(Session& session, const std::vector<std::string>& request) {
+    const std::string& command = request[0];
+    const CommandSpec* spec = nullptr;
+    for (const auto& candidate : COMMANDS) {
+        if (command == candidate.name) {
+            spec = &candidate;
+            break;
+        }
+    }
+
+    if (!spec) {
+        return errorResponse("unknown command " + command);
+    }
+    if (request.size() - 1 != spec->argCount) {
+        return errorResponse(command + " expects " + std::to_string(spec->argCount) + " arguments");
+    }
+    if (spec->operation) {
+        if (!session.loggedIn) {
+            return errorResponse("not logged in");
+        }
+        if (!auth_.roleHasAccess(session.role, spec->operation)) {
+            return errorResponse("permission denied");
+        }
+    }
+
+    try {
+        if (command == "PING") {
+            return okResponse();
+        }
+
+        if (command == "LOGIN") {
+            std::string role;
+            // Runs concurrently with other logins, up to the hasher's limit
+            if (!auth_.verifyCredentials(request[1], request[2], role)) {
+                session = Session();
+                return errorResponse("invalid username or password");
+            }
+            session.loggedIn = true;
+            session.username = request[1];
+            session.role = role;
+            Message response = okResponse();
+            response.push_back({role});
+            return response;
+        }
+
+        if (command == "LOGOUT") {
+            session = Session();
+            return okResponse();
+        }
+
+        if (command == "REGISTER") {
+            if (!session.loggedIn || session.role != "admin") {
+                return errorResponse("permission denied");
+            }
+            if (!auth_.registerUser(request[1], request[2], request[3])) {
+                return errorResponse("user already exists");
+            }
+            return okResponse();
+        }
+
+        // The journal has its own locking and groups concurrent orders into one sync
+        if (command == "CREATE_ORDER" && journal_) {
+            Database::NewOrder order{std::stoi(request[1]), std::stoi(request[2]), std::stoi(request[3]),
+                                     std::stoi(request[4]), std::stoi(request[5])};
+            if (!journal_->submit(order)) {
+                return errorResponse("order rejected");
+            }
+            return okResponse();
+        }
+
+        Message response = okResponse();
+
+        if (command == "FLOWERS") {
+            for (const auto& flower : db_.getAllFlowers()) {
+                response.push_back({std::to_string(flower.id), flower.name, flower.variety,
+                                    formatNumber(flower.price)});
+            }
+        } else if (command == "UPDATE_PRICE") {
+            if (!db_.updateFlowerPrice(std::stoi(request[1]), std::stod(request[2]))) {
+                return errorResponse("price update rejected");
+            }
+        } else if (command == "COMPOSITIONS") {
+            for (const auto& comp : db_.getAllCompositions()) {
+                response.push_back({std::to_string(comp.id), comp.name, comp.description});
+            }
+        } else if (command == "COMPOSITION_FLOWERS") {
+            for (const auto& [flowerId, quantity] : db_.getCompositionFlowers(std::stoi(request[1]))) {
+                response.push_back({std::to_string(flowerId), std::to_string(quantity)});
+            }
+        } else if (command == "POPULAR_COMPOSITION") {
+            auto comp = db_.getMostPopularComposition();
+            response.push_back({std::to_string(comp.id), comp.name, comp.description});
+        } else if (command == "CUSTOMERS") {
+            for (const auto& customer : db_.getAllCustomers()) {
+                response.push_back({std::to_string(customer.id), customer.name, customer.phone, customer.email});
+            }
+        } else if (command == "CUSTOMER") {
+            auto customer = db_.getCustomerById(std::stoi(request[1]));
+            response.push_back({std::to_string(customer.id), customer.name, customer.phone, customer.email});
+        } else if (command == "CREATE_ORDER") {
+            if (!db_.createOrder(std::stoi(request[1]), std::stoi(request[2]), std::stoi(request[3]),
+                                 std::stoi(request[4]), std::stoi(request[5]))) {
+                return errorResponse("order rejected");
+            }
+        } else if (command == "ORDERS_BY_DATE") {
+            for (const auto& order : db_.getOrdersByDate(std::stoi(request[1]))) {
+                response.push_back(orderRow(order));
+            }
+        } else if (command == "ORDERS_BY_RANGE") {
+            for (const auto& order : db_.getOrdersByDateRange(std::stoi(request[1]), std::stoi(request[2]))) {
+                response.push_back(orderRow(order));
+            }
+        } else if (command == "ORDER_SUMMARY") {
+            auto summary = db_.getOrderSummary(std::stoi(request[1]));
+            response.push_back({std::to_string(summary.orderId), formatNumber(summary.basePrice),
+                                formatNumber(summary.urgencyFee), formatNumber(summary.totalPrice)});
+        } else if (command == "REVENUE") {
+            response.push_back({formatNumber(db_.getTotalRevenue(std::stoi(request[1]), std::stoi(request[2])))});
+        } else if (command == "REVENUE_SERIES") {
+            Database::Granularity granularity;
+            if (!Database::parseGranularity(request[3], granularity)) {
+                return errorResponse("granularity must be day, week, month or year");
+            }
+            for (const auto& bucket : db_.getRevenueSeries(std::stoi(request[1]), std::stoi(request[2]), granularity)) {
+                response.push_back({std::to_string(bucket.startDate), formatNumber(bucket.revenue),
+                                    std::to_string(bucket.orderCount), formatNumber(bucket.urgencyFeeShare)});
+            }
+        } else if (command == "URGENCY") {
+            for (const auto& [urgencyPercent, count] : db_.getOrdersByUrgency()) {
+                response.push_back({std::to_string(urgencyPercent), std::to_string(count)});
+            }
+        } else if (command == "FLOWER_USAGE") {
+            auto usage = db_.getFlowerUsageByPeriod(std::stoi(request[1]), std::stoi(request[2]));
+            for (const auto& [flowerName, varieties] : usage) {
+                for (const auto& [variety, quantity] : varieties) {
+                    response.push_back({flowerName, variety, std::to_string(quantity)});
+                }
+            }
+        } else if (command == "SALES_SUMMARY") {
+            for (const auto& [composition, data] : db_.getCompositionSalesSummary()) {
+                response.push_back({composition, std::to_string(data.first), formatNumber(data.second)});
+            }
+        }
+
+        return response;
+    } catch (const std::exception&) {
+        return errorResponse("invalid arguments for " + command);
+    }
+}
@@ -0,0 +1,253 @@
+#include "../includes/session_replay.h"
+#include "../includes/authentication.h"
+#include "../includes/ui.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+using ScreenSamples = std::map<std::string, std::vector<double>>;
+
+// Accepts and drops everything, so screens are still formatted but never printed
+class DiscardBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+// UI that runs a script and times each response, crediting it to the screen showing at
+// the time. Every screen is overridden only to keep track of which one that is.
+class ReplayUI : public UI {
+public:
+    ReplayUI(Database& db, Authentication& auth, std::istream& in, std::ostream& out,
+             const std::deque<std::string>& script, ScreenSamples& samples)
+        : UI(db, auth, in, out), samples_(samples), screen_("start"), inputScreen_("start"), inputs_(0) {
+        mockInputs = script;
+    }
+
+    size_t inputs() const {
+        return inputs_;
+    }
+
+    void showMainMenu() override { Screen screen(*this, "showMainMenu"); UI::showMainMenu(); }
+    void showAdminMenu() override { Screen screen(*this, "showAdminMenu"); UI::showAdminMenu(); }
+    void showUserMenu() override { Screen screen(*this, "showUserMenu"); UI::showUserMenu(); }
+    void showLoginScreen() override { Screen screen(*this, "showLoginScreen"); UI::showLoginScreen(); }
+    void showRegisterScreen() override { Screen screen(*this, "showRegisterScreen"); UI::showRegisterScreen(); }
+    void showFlowerManagement() override { Screen screen(*this, "showFlowerManagement"); UI::showFlowerManagement(); }
+    void displayAllFlowers() override { Screen screen(*this, "displayAllFlowers"); UI::displayAllFlowers(); }
+    void updateFlowerPrice() override { Screen screen(*this, "updateFlowerPrice"); UI::updateFlowerPrice(); }
+    void simulatePriceChange() override { Screen screen(*this, "simulatePriceChange"); UI::simulatePriceChange(); }
+    void showCompositionManagement() override {
+        Screen screen(*this, "showCompositionManagement");
+        UI::showCompositionManagement();
+    }
+    void displayAllCompositions() override {
+        Screen screen(*this, "displayAllCompositions");
+        UI::displayAllCompositions();
+    }
+    void displayCompositionDetails(int compositionId) override {
+        Screen screen(*this, "displayCompositionDetails");
+        UI::displayCompositionDetails(compositionId);
+    }
+    void displayMostPopularComposition() override {
+        Screen screen(*this, "displayMostPopularComposition");
+        UI::displayMostPopularComposition();
+    }
+    void showOrderManagement() override { Screen screen(*this, "showOrderManagement"); UI::showOrderManagement(); }
+    void createNewOrder() override { Screen screen(*this, "createNewOrder"); UI::createNewOrder(); }
+    void displayOrdersByDate() override { Screen screen(*this, "displayOrdersByDate"); UI::displayOrdersByDate(); }
+    void displayOrdersByPeriod() override { Screen screen(*this, "displayOrdersByPeriod"); UI::displayOrdersByPeriod(); }
+    void displayOrderStatistics() override {
+        Screen screen(*this, "displayOrderStatistics");
+        UI::displayOrderStatistics();
+    }
+    void displayFlowerUsageReport() override {
+        Screen screen(*this, "displayFlowerUsageReport");
+        UI::displayFlowerUsageReport();
+    }
+    void displayCompositionSalesReport() override {
+        Screen screen(*this, "displayCompositionSalesReport");
+        UI::displayCompositionSalesReport();
+    }
+    void displayFlowerDemand() override { Screen screen(*this, "displayFlowerDemand"); UI::displayFlowerDemand(); }
+
+protected:
+    std::string readLine(bool secret) override {
+        if (inputs_ > 0) {
+            samples_[inputScreen_].push_back(
+                std::chrono::duration<double, std::milli>(Clock::now() - lastInput_).count());
+        }
+        std::string line = UI::readLine(secret);
+        inputs_++;
+        inputScreen_ = screen_;
+        lastInput_ = Clock::now();
+        return line;
+    }
+
+private:
+    // Marks a screen as showing while it runs; the menus call each other, so scopes nest
+    struct Screen {
+        ReplayUI& ui;
+        const char* previous;
+
+        Screen(ReplayUI& ui, const char* name) : ui(ui), previous(ui.screen_) {
+            ui.screen_ = name;
+        }
+        ~Screen() {
+            ui.screen_ = previous;
+        }
+    };
+
+    ScreenSamples& samples_;
+    const char* screen_;
+    const char* inputScreen_;  // screen that took the last input
+    size_t inputs_;
+    Clock::time_point lastInput_;
+};
+
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index];
+}
+
+bool loadReplayScript(const std::string& path, ReplayScript& script) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot open replay script " << path << std::endl;
+        return false;
+    }
+
+    script.name = path;
+    script.lines.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        script.lines.push_back(line);
+    }
+    return true;
+}
+
+double SessionReplay::Report::sessionsPerSecond() const {
+    return wallMs > 0.0 ? sessions * 1000.0 / wallMs : 0.0;
+}
+
+double SessionReplay::Report::inputsPerSecond() const {
+    return wallMs > 0.0 ? inputs * 1000.0 / wallMs : 0.0;
+}
+
+SessionReplay::SessionReplay(Database& db, std::vector<ReplayScript> scripts, const Options& options)
+    : db_(db), scripts_(std::move(scripts)), options_(options) {}
+
+SessionReplay::Report SessionReplay::run() {
+    Report report;
+    if (scripts_.empty() || options_.sessions == 0) {
+        return report;
+    }
+
+    // Fill in passwords: the line before a secret is the username being logged in
+    std::vector<std::deque<std::string>> inputs;
+    std::map<std::string, std::string> hashes;  // extra accounts, hashed once for all sessions
+    PasswordHasher hasher(options_.hashParams);
+    for (const auto& script : scripts_) {
+        std::deque<std::string> lines = script.lines;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (lines[i] != UI::SECRET_LINE) {
+                continue;
+            }
+            std::string username = i > 0 ? lines[i - 1] : "";
+            auto known = options_.passwords.find(username);
+            if (known != options_.passwords.end()) {
+                lines[i] = known->second;
+                continue;
+            }
+            lines[i] = options_.defaultPassword;
+            if (!hashes.count(username)) {
+                hashes[username] = hasher.hash(options_.defaultPassword);
+            }
+        }
+        inputs.push_back(std::move(lines));
+    }
+
+    std::atomic<size_t> nextSession(0);
+    std::atomic<size_t> inputCount(0);
+    std::vector<ScreenSamples> samples(std::max<size_t>(1, options_.concurrency));
+    std::vector<std::thread> workers;
+
+    auto start = Clock::now();
+    for (size_t w = 0; w < samples.size(); w++) {
+        workers.emplace_back([&, w] {
+            DiscardBuffer discard;
+            std::ostream out(&discard);
+            for (size_t session = nextSession++; session < options_.sessions; session = nextSession++) {
+                // Login state lives in Authentication, so every session needs its own
+                Authentication auth(options_.hashParams);
+                for (const auto& [username, hash] : hashes) {
+                    auth.loadUser(username, hash, "user");
+                }
+
+                std::istringstream in;
+                ReplayUI ui(db_, auth, in, out, inputs[session % inputs.size()], samples[w]);
+                ui.start();
+                inputCount += ui.inputs();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    report.wallMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    report.sessions = options_.sessions;
+    report.inputs = inputCount;
+
+    ScreenSamples merged;
+    for (auto& workerSamples : samples) {
+        for (auto& [screen, times] : workerSamples) {
+            auto& all = merged[screen];
+            all.insert(all.end(), times.begin(), times.end());
+        }
+    }
+    for (auto& [screen, times] : merged) {
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (double time : times) {
+            total += time;
+        }
+        report.screens.push_back({screen, times.size(), total, percentile(times, 0.5), percentile(times, 0.95),
+                                  times.back()});
+    }
+    std::sort(report.screens.begin(), report.screens.end(),
+              [](const ScreenStats& a, const ScreenStats& b) { return a.totalMs > b.totalMs; });
+
+    return report;
+}
+
+void SessionReplay::printReport(const Report& report, std::ostream& out) {
+    out << std::fixed << std::setprecision(2);
+    out << report.sessions << " sessions, " << report.inputs << " inputs in " << report.wallMs << " ms ("
+        << report.sessionsPerSecond() << " sessions/s, " << report.inputsPerSecond() << " inputs/s)\n\n";
+
+    out << std::left << std::setw(32) << "Screen" << std::right << std::setw(8) << "Count" << std::setw(12)
+        << "Total ms" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "Max ms"
+        << "\n";
+    out << std::string(82, '-') << "\n";
+    for (const auto& screen : report.screens) {
+        out << std::left << std::setw(32) << screen.screen << std::right << std::setw(8) << screen.count
+            << std::setw(12) << screen.totalMs << std::setw(10) << screen.p50Ms << std::setw(10) << screen.p95Ms
+            << std::setw(10) << screen.maxMs << "\n";
+    }
+}
@@ -0,0 +1,54 @@
+#include "../includes/string_arena.h"
+#include <cstring>
+
+StringArena::StringArena(size_t blockSize)
+    : blockSize_(blockSize), blockOffset_(0), bytesUsed_(0), currentBlock_(nullptr) {}
+
+std::string_view StringArena::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+
+    char* data = allocate(text.size());
+    std::memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
+}
+
+std::string_view StringArena::intern(std::string_view text) {
+    auto it = interned_.find(text);
+    if (it != interned_.end()) {
+        return *it;
+    }
+
+    std::string_view stored = store(text);
+    interned_.insert(stored);
+    return stored;
+}
+
+size_t StringArena::blockCount() const {
+    return blocks_.size();
+}
+
+size_t StringArena::bytesUsed() const {
+    return bytesUsed_;
+}
+
+char* StringArena::allocate(size_t size) {
+    // Oversized strings get a block of their own; the current block stays open
+    if (size > blockSize_ / 4) {
+        blocks_.emplace_back(new char[size]);
+        bytesUsed_ += size;
+        return blocks_.back().get();
+    }
+
+    if (!currentBlock_ || blockOffset_ + size > blockSize_) {
+        blocks_.emplace_back(new char[blockSize_]);
+        currentBlock_ = blocks_.back().get();
+        blockOffset_ = 0;
+    }
+
+    char* data = currentBlock_ + blockOffset_;
+    blockOffset_ += size;
+    bytesUsed_ += size;
+    return data;
+}
@@ -1,19 +1,38 @@
 #include "../includes/ui.h"
+#include "../includes/date_utils.h"
+#include "../includes/repricing_simulator.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <limits>
 
-UI::UI(Database& db, Authentication& auth) : db_(db), auth_(auth) {}
+const char* const UI::SECRET_LINE = "#secret";
+
+UI::UI(Database& db, Authentication& auth) : UI(db, auth, std::cin, std::cout) {}
+
+UI::UI(Database& db, Authentication& auth, std::istream& in, std::ostream& out)
+    : in_(in), out_(out), recorder_(nullptr), db_(db), auth_(auth) {}
+
+void UI::recordTo(std::ostream* script) {
+    recorder_ = script;
+}
 
 void UI::start() {
+    try {
+        runSession();
+    } catch (const SessionEnded&) {
+    }
+}
+
+void UI::runSession() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "    FLOWER GREENHOUSE MANAGEMENT    \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "    FLOWER GREENHOUSE MANAGEMENT    \n";
+    out_ << "====================================\n\n";
     
     // Trying to connect to the database
     if (!db_.isConnected() && !db_.connect()) {
-        std::cout << "Failed to connect to the database. Exiting...\n";
+        out_ << "Failed to connect to the database. Exiting...\n";
         return;
     }
     
@@ -32,16 +51,16 @@ void UI::start() {
 
 void UI::showMainMenu() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "    FLOWER GREENHOUSE MANAGEMENT    \n";
-    std::cout << "====================================\n";
-    std::cout << "Logged in as: " << auth_.getCurrentUser() << " (" << auth_.getCurrentRole() << ")\n\n";
+    out_ << "====================================\n";
+    out_ << "    FLOWER GREENHOUSE MANAGEMENT    \n";
+    out_ << "====================================\n";
+    out_ << "Logged in as: " << auth_.getCurrentUser() << " (" << auth_.getCurrentRole() << ")\n\n";
     
-    std::cout << "1. Flower Management\n";
-    std::cout << "2. Composition Management\n";
-    std::cout << "3. Order Management\n";
-    std::cout << "4. Logout\n";
-    std::cout << "0. Exit\n\n";
+    out_ << "1. Flower Management\n";
+    out_ << "2. Composition Management\n";
+    out_ << "3. Order Management\n";
+    out_ << "4. Logout\n";
+    out_ << "0. Exit\n\n";
     
     int choice = getIntInput("Enter your choice: ");
     
@@ -57,14 +76,13 @@ void UI::showMainMenu() {
             break;
         case 4:
             auth_.logout();
-            start();
+            runSession();
             break;
         case 0:
-            std::cout << "Goodbye!\n";
-            db_.disconnect();
-            exit(0);
+            out_ << "Goodbye!\n";
+            throw SessionEnded();
         default:
-            std::cout << "Invalid choice. Please try again.\n";
+            out_ << "Invalid choice. Please try again.\n";
             waitForKey();
             showMainMenu();
     }
@@ -73,23 +91,23 @@ void UI::showMainMenu() {
 void UI::showAdminMenu() {
     while (auth_.isLoggedIn() && auth_.getCurrentRole() == "admin") {
         clearScreen();
-        std::cout << "====================================\n";
-        std::cout << "           ADMIN MENU              \n";
-        std::cout << "====================================\n";
-        std::cout << "Logged in as: " << auth_.getCurrentUser() << " (Administrator)\n\n";
+        out_ << "====================================\n";
+        out_ << "           ADMIN MENU              \n";
+        out_ << "====================================\n";
+        out_ << "Logged in as: " << auth_.getCurrentUser() << " (Administrator)\n\n";
         
-        std::cout << "1. View All Flowers\n";
-        std::cout << "2. Update Flower Price\n";
-        std::cout << "3. View All Compositions\n";
-        std::cout << "4. View Most Popular Composition\n";
-        std::cout << "5. Create New Order\n";
-        std::cout << "6. View Orders by Date\n";
-        std::cout << "7. View Total Revenue Report\n";
-        std::cout << "8. View Orders by Urgency Report\n";
-        std::cout << "9. View Flower Usage Report\n";
-        std::cout << "10. View Composition Sales Report\n";
-        std::cout << "11. Logout\n";
-        std::cout << "0. Exit\n\n";
+        out_ << "1. View All Flowers\n";
+        out_ << "2. Update Flower Price\n";
+        out_ << "3. View All Compositions\n";
+        out_ << "4. View Most Popular Composition\n";
+        out_ << "5. Create New Order\n";
+        out_ << "6. View Orders by Date\n";
+        out_ << "7. View Total Revenue Report\n";
+        out_ << "8. View Orders by Urgency Report\n";
+        out_ << "9. View Flower Usage Report\n";
+        out_ << "10. View Composition Sales Report\n";
+        out_ << "11. Logout\n";
+        out_ << "0. Exit\n\n";
         
         int choice = getIntInput("Enter your choice: ");
         
@@ -126,14 +144,13 @@ void UI::showAdminMenu() {
                 break;
             case 11:
                 auth_.logout();
-                start();
+                runSession();
                 break;
             case 0:
-                std::cout << "Goodbye!\n";
-                db_.disconnect();
-                exit(0);
+                out_ << "Goodbye!\n";
+                throw SessionEnded();
             default:
-                std::cout << "Invalid choice. Please try again.\n";
+                out_ << "Invalid choice. Please try again.\n";
                 waitForKey();
         }
     }
@@ -142,17 +159,17 @@ void UI::showAdminMenu() {
 void UI::showUserMenu() {
     while (auth_.isLoggedIn() && auth_.getCurrentRole() == "user") {
         clearScreen();
-        std::cout << "====================================\n";
-        std::cout << "           USER MENU               \n";
-        std::cout << "====================================\n";
-        std::cout << "Logged in as: " << auth_.getCurrentUser() << "\n\n";
+        out_ << "====================================\n";
+        out_ << "           USER MENU               \n";
+        out_ << "====================================\n";
+        out_ << "Logged in as: " << auth_.getCurrentUser() << "\n\n";
         
-        std::cout << "1. View All Flowers\n";
-        std::cout << "2. View All Compositions\n";
-        std::cout << "3. Create New Order\n";
-        std::cout << "4. View My Orders\n";
-        std::cout << "5. Logout\n";
-        std::cout << "0. Exit\n\n";
+        out_ << "1. View All Flowers\n";
+        out_ << "2. View All Compositions\n";
+        out_ << "3. Create New Order\n";
+        out_ << "4. View My Orders\n";
+        out_ << "5. Logout\n";
+        out_ << "0. Exit\n\n";
         
         int choice = getIntInput("Enter your choice: ");
         
@@ -167,19 +184,18 @@ void UI::showUserMenu() {
                 createNewOrder();
                 break;
             case 4:
-                std::cout << "Feature not implemented yet.\n";
+                out_ << "Feature not implemented yet.\n";
                 waitForKey();
                 break;
             case 5:
                 auth_.logout();
-                start();
+                runSession();
                 break;
             case 0:
-                std::cout << "Goodbye!\n";
-                db_.disconnect();
-                exit(0);
+                out_ << "Goodbye!\n";
+                throw SessionEnded();
             default:
-                std::cout << "Invalid choice. Please try again.\n";
+                out_ << "Invalid choice. Please try again.\n";
                 waitForKey();
         }
     }
@@ -187,17 +203,17 @@ void UI::showUserMenu() {
 
 void UI::showLoginScreen() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "              LOGIN                \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "              LOGIN                \n";
+    out_ << "====================================\n\n";
     
     std::string username = getInput("Username: ");
-    std::string password = getInput("Password: ");
+    std::string password = getSecretInput("Password: ");
     
     if (auth_.login(username, password)) {
-        std::cout << "Login successful!\n";
+        out_ << "Login successful!\n";
     } else {
-        std::cout << "Invalid username or password.\n";
+        out_ << "Invalid username or password.\n";
         waitForKey();
         return;
     }
@@ -205,31 +221,32 @@ void UI::showLoginScreen() {
 
 void UI::showRegisterScreen() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "           REGISTRATION             \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "           REGISTRATION             \n";
+    out_ << "====================================\n\n";
     
     std::string username = getInput("Choose a username: ");
-    std::string password = getInput("Choose a password: ");
+    std::string password = getSecretInput("Choose a password: ");
     std::string role = getInput("Role (user/admin): ");
     
     if (auth_.registerUser(username, password, role)) {
-        std::cout << "Registration successful!\n";
+        out_ << "Registration successful!\n";
     } else {
-        std::cout << "Registration failed. Username may already exist.\n";
+        out_ << "Registration failed. Username may already exist.\n";
     }
     waitForKey();
 }
 
 void UI::showFlowerManagement() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "        FLOWER MANAGEMENT           \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "        FLOWER MANAGEMENT           \n";
+    out_ << "====================================\n\n";
     
-    std::cout << "1. View All Flowers\n";
-    std::cout << "2. Update Flower Price\n";
-    std::cout << "3. Back to Main Menu\n\n";
+    out_ << "1. View All Flowers\n";
+    out_ << "2. Update Flower Price\n";
+    out_ << "3. Simulate Price Change\n";
+    out_ << "4. Back to Main Menu\n\n";
     
     int choice = getIntInput("Enter your choice: ");
     
@@ -241,6 +258,9 @@ void UI::showFlowerManagement() {
             updateFlowerPrice();
             break;
         case 3:
+            simulatePriceChange();
+            break;
+        case 4:
             if (auth_.getCurrentRole() == "admin") {
                 showAdminMenu();
             } else {
@@ -248,7 +268,7 @@ void UI::showFlowerManagement() {
             }
             break;
         default:
-            std::cout << "Invalid choice. Please try again.\n";
+            out_ << "Invalid choice. Please try again.\n";
             waitForKey();
             showFlowerManagement();
     }
@@ -256,21 +276,21 @@ void UI::showFlowerManagement() {
 
 void UI::displayAllFlowers() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "          ALL FLOWERS              \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "          ALL FLOWERS              \n";
+    out_ << "====================================\n\n";
     
-    auto flowers = db_.getAllFlowers();
+    auto flowers = db_.getFlowerTable();
     
-    if (flowers.empty()) {
-        std::cout << "No flowers found in the database.\n";
+    if (flowers.rows.empty()) {
+        out_ << "No flowers found in the database.\n";
     } else {
-        std::cout << std::left << std::setw(5) << "ID" << std::setw(20) << "Name" 
+        out_ << std::left << std::setw(5) << "ID" << std::setw(20) << "Name" 
                   << std::setw(20) << "Variety" << std::setw(10) << "Price" << std::endl;
-        std::cout << std::string(55, '-') << std::endl;
+        out_ << std::string(55, '-') << std::endl;
         
-        for (const auto& flower : flowers) {
-            std::cout << std::left << std::setw(5) << flower.id << std::setw(20) << flower.name 
+        for (const auto& flower : flowers.rows) {
+            out_ << std::left << std::setw(5) << flower.id << std::setw(20) << flower.name 
                       << std::setw(20) << flower.variety << std::setw(10) << flower.price << std::endl;
         }
     }
@@ -281,12 +301,12 @@ void UI::displayAllFlowers() {
 
 void UI::updateFlowerPrice() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "       UPDATE FLOWER PRICE         \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "       UPDATE FLOWER PRICE         \n";
+    out_ << "====================================\n\n";
     
     if (!auth_.hasAccess("update_flower_price")) {
-        std::cout << "You don't have permission to update flower prices.\n";
+        out_ << "You don't have permission to update flower prices.\n";
         waitForKey();
         showFlowerManagement();
         return;
@@ -298,9 +318,72 @@ void UI::updateFlowerPrice() {
     double newPrice = getDoubleInput("Enter new price: ");
     
     if (db_.updateFlowerPrice(flowerId, newPrice)) {
-        std::cout << "Price updated successfully!\n";
+        out_ << "Price updated successfully!\n";
     } else {
-        std::cout << "Failed to update price. Please check if the ID is valid or if the price increase is too high.\n";
+        out_ << "Failed to update price. Please check if the ID is valid or if the price increase is too high.\n";
+    }
+    
+    waitForKey();
+    showFlowerManagement();
+}
+
+void UI::simulatePriceChange() {
+    clearScreen();
+    out_ << "====================================\n";
+    out_ << "      SIMULATE PRICE CHANGE        \n";
+    out_ << "====================================\n\n";
+    
+    if (!auth_.hasAccess("view_reports")) {
+        out_ << "You don't have permission to view reports.\n";
+        waitForKey();
+        showFlowerManagement();
+        return;
+    }
+    
+    // Replays the orders of a past period at the changed prices
+    std::string startDateText = getInput("Enter Start Date of the period to replay (YYYY-MM-DD): ");
+    std::string endDateText = getInput("Enter End Date (YYYY-MM-DD): ");
+    int flowerId = getIntInput("Enter Flower ID to change (0 for all flowers): ");
+    double percent = getDoubleInput("Enter price change in % (e.g. 5 or -10): ");
+    
+    int startDate, endDate;
+    RepricingSimulator simulator(db_);
+    if (!parseDate(startDateText, startDate) || !parseDate(endDateText, endDate)) {
+        out_ << "Invalid date. Please use the YYYY-MM-DD format.\n";
+    } else if (!simulator.load(startDate, endDate)) {
+        out_ << "Failed to load the orders of the period.\n";
+    } else {
+        const auto& ids = simulator.flowerIds();
+        std::vector<double> prices = simulator.currentPrices();
+        bool found = flowerId == 0;
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (flowerId == 0 || ids[i] == flowerId) {
+                prices[i] *= 1.0 + percent / 100.0;
+                found = true;
+            }
+        }
+        
+        std::vector<RepricingSimulator::Outcome> outcomes;
+        if (!found || !simulator.evaluate({prices}, outcomes)) {
+            out_ << "Flower not found.\n";
+        } else {
+            RepricingSimulator::Outcome before = simulator.baseline();
+            const RepricingSimulator::Outcome& after = outcomes[0];
+            out_ << std::fixed << std::setprecision(2);
+            out_ << std::left << std::setw(20) << "" << std::setw(15) << "Current" << std::setw(15) << "Changed"
+                 << std::endl;
+            out_ << std::string(50, '-') << std::endl;
+            out_ << std::left << std::setw(20) << "Base revenue" << std::setw(15) << before.baseRevenue
+                 << std::setw(15) << after.baseRevenue << std::endl;
+            out_ << std::left << std::setw(20) << "Urgency fees" << std::setw(15) << before.urgencyFees
+                 << std::setw(15) << after.urgencyFees << std::endl;
+            out_ << std::left << std::setw(20) << "Total revenue" << std::setw(15) << before.totalRevenue
+                 << std::setw(15) << after.totalRevenue << std::endl;
+            out_ << "\nRevenue change: $" << after.totalRevenue - before.totalRevenue << std::endl;
+            if (!after.withinPriceRule) {
+                out_ << "Note: price increases above 10% will be rejected by Update Flower Price.\n";
+            }
+        }
     }
     
     waitForKey();
@@ -309,14 +392,14 @@ void UI::updateFlowerPrice() {
 
 void UI::showCompositionManagement() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "      COMPOSITION MANAGEMENT        \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "      COMPOSITION MANAGEMENT        \n";
+    out_ << "====================================\n\n";
     
-    std::cout << "1. View All Compositions\n";
-    std::cout << "2. View Composition Details\n";
-    std::cout << "3. View Most Popular Composition\n";
-    std::cout << "4. Back to Main Menu\n\n";
+    out_ << "1. View All Compositions\n";
+    out_ << "2. View Composition Details\n";
+    out_ << "3. View Most Popular Composition\n";
+    out_ << "4. Back to Main Menu\n\n";
     
     int choice = getIntInput("Enter your choice: ");
     
@@ -340,7 +423,7 @@ void UI::showCompositionManagement() {
             }
             break;
         default:
-            std::cout << "Invalid choice. Please try again.\n";
+            out_ << "Invalid choice. Please try again.\n";
             waitForKey();
             showCompositionManagement();
     }
@@ -348,21 +431,21 @@ void UI::showCompositionManagement() {
 
 void UI::displayAllCompositions() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "        ALL COMPOSITIONS           \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "        ALL COMPOSITIONS           \n";
+    out_ << "====================================\n\n";
     
     auto compositions = db_.getAllCompositions();
     
     if (compositions.empty()) {
-        std::cout << "No compositions found in the database.\n";
+        out_ << "No compositions found in the database.\n";
     } else {
-        std::cout << std::left << std::setw(5) << "ID" << std::setw(25) << "Name" 
+        out_ << std::left << std::setw(5) << "ID" << std::setw(25) << "Name" 
                   << std::setw(40) << "Description" << std::endl;
-        std::cout << std::string(70, '-') << std::endl;
+        out_ << std::string(70, '-') << std::endl;
         
         for (const auto& comp : compositions) {
-            std::cout << std::left << std::setw(5) << comp.id << std::setw(25) << comp.name 
+            out_ << std::left << std::setw(5) << comp.id << std::setw(25) << comp.name 
                       << std::setw(40) << comp.description << std::endl;
         }
     }
@@ -373,9 +456,9 @@ void UI::displayAllCompositions() {
 
 void UI::displayCompositionDetails(int compositionId) {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "      COMPOSITION DETAILS          \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "      COMPOSITION DETAILS          \n";
+    out_ << "====================================\n\n";
     
     auto compositions = db_.getAllCompositions();
     Database::Composition selectedComp;
@@ -390,29 +473,29 @@ void UI::displayCompositionDetails(int compositionId) {
     }
     
     if (!found) {
-        std::cout << "Composition not found.\n";
+        out_ << "Composition not found.\n";
         waitForKey();
         showCompositionManagement();
         return;
     }
     
-    std::cout << "ID: " << selectedComp.id << "\n";
-    std::cout << "Name: " << selectedComp.name << "\n";
-    std::cout << "Description: " << selectedComp.description << "\n\n";
+    out_ << "ID: " << selectedComp.id << "\n";
+    out_ << "Name: " << selectedComp.name << "\n";
+    out_ << "Description: " << selectedComp.description << "\n\n";
     
-    std::cout << "Flowers in this composition:\n";
-    std::cout << std::string(40, '-') << std::endl;
-    std::cout << std::left << std::setw(20) << "Flower" << std::setw(20) << "Variety" 
+    out_ << "Flowers in this composition:\n";
+    out_ << std::string(40, '-') << std::endl;
+    out_ << std::left << std::setw(20) << "Flower" << std::setw(20) << "Variety" 
               << std::setw(10) << "Quantity" << std::endl;
-    std::cout << std::string(50, '-') << std::endl;
+    out_ << std::string(50, '-') << std::endl;
     
     auto flowerQuantities = db_.getCompositionFlowers(compositionId);
-    auto allFlowers = db_.getAllFlowers();
+    auto allFlowers = db_.getFlowerTable();
     
     for (const auto& [flowerId, quantity] : flowerQuantities) {
-        for (const auto& flower : allFlowers) {
+        for (const auto& flower : allFlowers.rows) {
             if (flower.id == flowerId) {
-                std::cout << std::left << std::setw(20) << flower.name << std::setw(20) << flower.variety
+                out_ << std::left << std::setw(20) << flower.name << std::setw(20) << flower.variety
                           << std::setw(10) << quantity << std::endl;
                 break;
             }
@@ -425,18 +508,18 @@ void UI::displayCompositionDetails(int compositionId) {
 
 void UI::displayMostPopularComposition() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "    MOST POPULAR COMPOSITION       \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "    MOST POPULAR COMPOSITION       \n";
+    out_ << "====================================\n\n";
     
     auto mostPopular = db_.getMostPopularComposition();
     
     if (mostPopular.id == 0) {
-        std::cout << "No compositions or orders found in the database.\n";
+        out_ << "No compositions or orders found in the database.\n";
     } else {
-        std::cout << "ID: " << mostPopular.id << "\n";
-        std::cout << "Name: " << mostPopular.name << "\n";
-        std::cout << "Description: " << mostPopular.description << "\n\n";
+        out_ << "ID: " << mostPopular.id << "\n";
+        out_ << "Name: " << mostPopular.name << "\n";
+        out_ << "Description: " << mostPopular.description << "\n\n";
     }
     
     waitForKey();
@@ -445,17 +528,18 @@ void UI::displayMostPopularComposition() {
 
 void UI::showOrderManagement() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "        ORDER MANAGEMENT           \n";
-    std::cout << "====================================\n\n";
-    
-    std::cout << "1. Create New Order\n";
-    std::cout << "2. View Orders by Date\n";
-    std::cout << "3. View Orders by Period\n";
-    std::cout << "4. View Order Statistics\n";
-    std::cout << "5. View Flower Usage Report\n";
-    std::cout << "6. View Composition Sales Report\n";
-    std::cout << "7. Back to Main Menu\n\n";
+    out_ << "====================================\n";
+    out_ << "        ORDER MANAGEMENT           \n";
+    out_ << "====================================\n\n";
+    
+    out_ << "1. Create New Order\n";
+    out_ << "2. View Orders by Date\n";
+    out_ << "3. View Orders by Period\n";
+    out_ << "4. View Order Statistics\n";
+    out_ << "5. View Flower Usage Report\n";
+    out_ << "6. View Composition Sales Report\n";
+    out_ << "7. View Flower Demand Forecast\n";
+    out_ << "8. Back to Main Menu\n\n";
     
     int choice = getIntInput("Enter your choice: ");
     
@@ -479,6 +563,9 @@ void UI::showOrderManagement() {
             displayCompositionSalesReport();
             break;
         case 7:
+            displayFlowerDemand();
+            break;
+        case 8:
             if (auth_.getCurrentRole() == "admin") {
                 showAdminMenu();
             } else {
@@ -486,7 +573,7 @@ void UI::showOrderManagement() {
             }
             break;
         default:
-            std::cout << "Invalid choice. Please try again.\n";
+            out_ << "Invalid choice. Please try again.\n";
             waitForKey();
             showOrderManagement();
     }
@@ -494,41 +581,72 @@ void UI::showOrderManagement() {
 
 void UI::createNewOrder() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "          CREATE ORDER             \n";
-    std::cout << "====================================\n\n";
-    
-    // Display customers for selection
-    auto customers = db_.getAllCustomers();
-    std::cout << "Available Customers:\n";
-    std::cout << std::left << std::setw(5) << "ID" << std::setw(20) << "Name" << std::endl;
-    std::cout << std::string(25, '-') << std::endl;
-    
-    for (const auto& customer : customers) {
-        std::cout << std::left << std::setw(5) << customer.id << std::setw(20) << customer.name << std::endl;
+    out_ << "====================================\n";
+    out_ << "          CREATE ORDER             \n";
+    out_ << "====================================\n\n";
+    
+    // Page through customers for selection, or search by name, phone or email; the list
+    // can be far too long to print at once
+    const int CUSTOMERS_PER_PAGE = 20;
+    Database::PageCursor cursor;
+    std::vector<Database::Customer> shown;
+    bool nextPage = true;
+    int customerId = 0;
+    while (customerId <= 0) {
+        if (nextPage) {
+            auto page = db_.getCustomersPage(cursor, CUSTOMERS_PER_PAGE);
+            shown = page.rows;
+            // Wrap around to the first page after the last one
+            cursor = page.hasMore ? page.next : Database::PageCursor();
+        }
+        
+        out_ << "Available Customers:\n";
+        out_ << std::left << std::setw(5) << "ID" << std::setw(20) << "Name" << std::endl;
+        out_ << std::string(25, '-') << std::endl;
+        
+        for (const auto& customer : shown) {
+            out_ << std::left << std::setw(5) << customer.id << std::setw(20) << customer.name << std::endl;
+        }
+        
+        std::string input = getInput("\nEnter Customer ID, a name/phone/email to search, or nothing for more: ");
+        nextPage = input.empty();
+        if (!input.empty() && input.find_first_not_of("0123456789") == std::string::npos) {
+            try {
+                customerId = std::stoi(input);
+            } catch (const std::exception&) {
+                out_ << "Invalid input. Please enter a number.\n";
+            }
+        } else if (!input.empty()) {
+            shown = db_.searchCustomers(input);
+            if (shown.empty()) {
+                out_ << "No customers match \"" << input << "\".\n";
+            }
+        }
+        out_ << std::endl;
     }
     
-    int customerId = getIntInput("\nEnter Customer ID: ");
-    
     // Display compositions for selection
     auto compositions = db_.getAllCompositions();
-    std::cout << "\nAvailable Compositions:\n";
-    std::cout << std::left << std::setw(5) << "ID" << std::setw(25) << "Name" << std::endl;
-    std::cout << std::string(30, '-') << std::endl;
+    out_ << "\nAvailable Compositions:\n";
+    out_ << std::left << std::setw(5) << "ID" << std::setw(25) << "Name" << std::endl;
+    out_ << std::string(30, '-') << std::endl;
     
     for (const auto& comp : compositions) {
-        std::cout << std::left << std::setw(5) << comp.id << std::setw(25) << comp.name << std::endl;
+        out_ << std::left << std::setw(5) << comp.id << std::setw(25) << comp.name << std::endl;
     }
     
     int compositionId = getIntInput("\nEnter Composition ID: ");
-    std::string orderDate = getInput("Enter Order Date (YYYY-MM-DD): ");
-    std::string fulfillmentDate = getInput("Enter Fulfillment Date (YYYY-MM-DD): ");
+    std::string orderDateText = getInput("Enter Order Date (YYYY-MM-DD): ");
+    std::string fulfillmentDateText = getInput("Enter Fulfillment Date (YYYY-MM-DD): ");
     int quantity = getIntInput("Enter Quantity: ");
     
-    if (db_.createOrder(customerId, compositionId, orderDate, fulfillmentDate, quantity)) {
-        std::cout << "Order created successfully!\n";
+    int orderDate, fulfillmentDate;
+    if (!parseDate(orderDateText, orderDate) || !parseDate(fulfillmentDateText, fulfillmentDate)) {
+        out_ << "Invalid date. Please use the YYYY-MM-DD format.\n";
+    } else if (db_.createOrder(customerId, compositionId, orderDate, fulfillmentDate, quantity)) {
+        out_ << "Order created successfully!\n";
     } else {
-        std::cout << "Failed to create order. Please check the provided information.\n";
+        out_ << "Failed to create order. Please check the provided information.\n";
     }
     
     waitForKey();
@@ -537,37 +655,48 @@ void UI::createNewOrder() {
 
 void UI::displayOrdersByDate() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "         ORDERS BY DATE            \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "         ORDERS BY DATE            \n";
+    out_ << "====================================\n\n";
+    
+    std::string dateText = getInput("Enter Date (YYYY-MM-DD): ");
+    int date;
+    if (!parseDate(dateText, date)) {
+        out_ << "Invalid date. Please use the YYYY-MM-DD format.\n";
+        waitForKey();
+        showOrderManagement();
+        return;
+    }
     
-    std::string date = getInput("Enter Date (YYYY-MM-DD): ");
     auto orders = db_.getOrdersByDate(date);
     
     if (orders.empty()) {
-        std::cout << "No orders found for the specified date.\n";
+        out_ << "No orders found for the specified date.\n";
     } else {
-        std::cout << std::left << std::setw(5) << "ID" << std::setw(12) << "Customer" 
+        out_ << std::left << std::setw(5) << "ID" << std::setw(12) << "Customer" 
                   << std::setw(12) << "Composition" << std::setw(12) << "Order Date"
                   << std::setw(15) << "Delivery Date" << std::setw(8) << "Quantity" 
                   << std::setw(10) << "Urgency %" << std::endl;
-        std::cout << std::string(74, '-') << std::endl;
+        out_ << std::string(74, '-') << std::endl;
         
+        // Resolve names for all rows up front instead of querying per order
+        std::vector<int> customerIds;
         for (const auto& order : orders) {
-            auto customer = db_.getCustomerById(order.customerId);
-            auto compositions = db_.getAllCompositions();
-            std::string compName = "Unknown";
-            
-            for (const auto& comp : compositions) {
-                if (comp.id == order.compositionId) {
-                    compName = comp.name;
-                    break;
-                }
-            }
+            customerIds.push_back(order.customerId);
+        }
+        auto customers = db_.getCustomersByIds(customerIds);
+        std::map<int, std::string> compositionNames;
+        for (const auto& comp : db_.getAllCompositions()) {
+            compositionNames[comp.id] = comp.name;
+        }
+        
+        for (const auto& order : orders) {
+            std::string customerName = customers.count(order.customerId) ? customers[order.customerId].name : "Unknown";
+            std::string compName = compositionNames.count(order.compositionId) ? compositionNames[order.compositionId] : "Unknown";
             
-            std::cout << std::left << std::setw(5) << order.id << std::setw(12) << customer.name 
-                      << std::setw(12) << compName << std::setw(12) << order.orderDate
-                      << std::setw(15) << order.fulfillmentDate << std::setw(8) << order.quantity 
+            out_ << std::left << std::setw(5) << order.id << std::setw(12) << customerName 
+                      << std::setw(12) << compName << std::setw(12) << formatDate(order.orderDate)
+                      << std::setw(15) << formatDate(order.fulfillmentDate) << std::setw(8) << order.quantity 
                       << std::setw(10) << (order.urgencyRate * 100) << "%" << std::endl;
         }
     }
@@ -578,38 +707,60 @@ void UI::displayOrdersByDate() {
 
 void UI::displayOrdersByPeriod() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "         REVENUE REPORT            \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "         REVENUE REPORT            \n";
+    out_ << "====================================\n\n";
     
-    std::string startDate = getInput("Enter Start Date (YYYY-MM-DD): ");
-    std::string endDate = getInput("Enter End Date (YYYY-MM-DD): ");
+    std::string startDateText = getInput("Enter Start Date (YYYY-MM-DD): ");
+    std::string endDateText = getInput("Enter End Date (YYYY-MM-DD): ");
+    
+    int startDate, endDate;
+    if (!parseDate(startDateText, startDate) || !parseDate(endDateText, endDate)) {
+        out_ << "Invalid date. Please use the YYYY-MM-DD format.\n";
+        waitForKey();
+        showOrderManagement();
+        return;
+    }
     
     double totalRevenue = db_.getTotalRevenue(startDate, endDate);
     
-    std::cout << "\nTotal Revenue for period " << startDate << " to " << endDate << ": $" 
+    out_ << "\nTotal Revenue for period " << startDateText << " to " << endDateText << ": $" 
               << std::fixed << std::setprecision(2) << totalRevenue << std::endl;
     
+    // Month-by-month breakdown from a single pass over the period
+    auto series = db_.getRevenueSeries(startDate, endDate, Database::Granularity::Month);
+    if (series.size() > 1) {
+        out_ << "\n" << std::left << std::setw(12) << "Month" << std::setw(10) << "Orders" 
+                  << std::setw(15) << "Revenue" << std::setw(10) << "Urgency %" << std::endl;
+        out_ << std::string(47, '-') << std::endl;
+        
+        for (const auto& bucket : series) {
+            out_ << std::left << std::setw(12) << formatDate(bucket.startDate).substr(0, 7) 
+                      << std::setw(10) << bucket.orderCount << "$" << std::setw(14) << bucket.revenue 
+                      << std::setw(10) << (bucket.urgencyFeeShare * 100) << std::endl;
+        }
+    }
+    
     waitForKey();
     showOrderManagement();
 }
 
 void UI::displayOrderStatistics() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "        URGENCY STATISTICS         \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "        URGENCY STATISTICS         \n";
+    out_ << "====================================\n\n";
     
     auto urgencyStats = db_.getOrdersByUrgency();
     
     if (urgencyStats.empty()) {
-        std::cout << "No order statistics available.\n";
+        out_ << "No order statistics available.\n";
     } else {
-        std::cout << std::left << std::setw(15) << "Urgency Rate" << std::setw(15) << "Order Count" << std::endl;
-        std::cout << std::string(30, '-') << std::endl;
+        out_ << std::left << std::setw(15) << "Urgency Rate" << std::setw(15) << "Order Count" << std::endl;
+        out_ << std::string(30, '-') << std::endl;
         
         for (const auto& [urgencyRate, count] : urgencyStats) {
-            std::cout << std::left << std::setw(15) << urgencyRate << "%" << std::setw(15) << count << std::endl;
+            out_ << std::left << std::setw(15) << urgencyRate << "%" << std::setw(15) << count << std::endl;
         }
     }
     
@@ -619,27 +770,33 @@ void UI::displayOrderStatistics() {
 
 void UI::displayFlowerUsageReport() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "       FLOWER USAGE REPORT         \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "       FLOWER USAGE REPORT         \n";
+    out_ << "====================================\n\n";
+    
+    std::string startDateText = getInput("Enter Start Date (YYYY-MM-DD): ");
+    std::string endDateText = getInput("Enter End Date (YYYY-MM-DD): ");
     
-    std::string startDate = getInput("Enter Start Date (YYYY-MM-DD): ");
-    std::string endDate = getInput("Enter End Date (YYYY-MM-DD): ");
+    int startDate, endDate;
+    if (!parseDate(startDateText, startDate) || !parseDate(endDateText, endDate)) {
+        out_ << "Invalid date. Please use the YYYY-MM-DD format.\n";
+        waitForKey();
+        showOrderManagement();
+        return;
+    }
     
-    auto flowerUsage = db_.getFlowerUsageByPeriod(startDate, endDate);
+    auto flowerUsage = db_.getFlowerUsageTable(startDate, endDate);
     
-    if (flowerUsage.empty()) {
-        std::cout << "No flower usage data for the specified period.\n";
+    if (flowerUsage.rows.empty()) {
+        out_ << "No flower usage data for the specified period.\n";
     } else {
-        std::cout << std::left << std::setw(20) << "Flower" << std::setw(20) << "Variety" 
+        out_ << std::left << std::setw(20) << "Flower" << std::setw(20) << "Variety" 
                   << std::setw(10) << "Quantity" << std::endl;
-        std::cout << std::string(50, '-') << std::endl;
+        out_ << std::string(50, '-') << std::endl;
         
-        for (const auto& [flowerName, varieties] : flowerUsage) {
-            for (const auto& [variety, quantity] : varieties) {
-                std::cout << std::left << std::setw(20) << flowerName << std::setw(20) << variety 
-                          << std::setw(10) << quantity << std::endl;
-            }
+        for (const auto& usage : flowerUsage.rows) {
+            out_ << std::left << std::setw(20) << usage.flowerName << std::setw(20) << usage.variety 
+                      << std::setw(10) << usage.quantity << std::endl;
         }
     }
     
@@ -649,24 +806,24 @@ void UI::displayFlowerUsageReport() {
 
 void UI::displayCompositionSalesReport() {
     clearScreen();
-    std::cout << "====================================\n";
-    std::cout << "    COMPOSITION SALES REPORT       \n";
-    std::cout << "====================================\n\n";
+    out_ << "====================================\n";
+    out_ << "    COMPOSITION SALES REPORT       \n";
+    out_ << "====================================\n\n";
     
     auto salesSummary = db_.getCompositionSalesSummary();
     
     if (salesSummary.empty()) {
-        std::cout << "No composition sales data available.\n";
+        out_ << "No composition sales data available.\n";
     } else {
-        std::cout << std::left << std::setw(25) << "Composition" << std::setw(15) << "Orders" 
+        out_ << std::left << std::setw(25) << "Composition" << std::setw(15) << "Orders" 
                   << std::setw(15) << "Revenue" << std::endl;
-        std::cout << std::string(55, '-') << std::endl;
+        out_ << std::string(55, '-') << std::endl;
         
         for (const auto& [composition, data] : salesSummary) {
             int orderCount = data.first;
             double revenue = data.second;
             
-            std::cout << std::left << std::setw(25) << composition << std::setw(15) << orderCount 
+            out_ << std::left << std::setw(25) << composition << std::setw(15) << orderCount 
                       << "$" << std::fixed << std::setprecision(2) << revenue << std::endl;
         }
     }
@@ -675,42 +832,98 @@ void UI::displayCompositionSalesReport() {
     showOrderManagement();
 }
 
+void UI::displayFlowerDemand() {
+    clearScreen();
+    out_ << "====================================\n";
+    out_ << "      FLOWER DEMAND FORECAST       \n";
+    out_ << "====================================\n\n";
+    
+    std::string startDateText = getInput("Enter Start Date (YYYY-MM-DD): ");
+    std::string endDateText = getInput("Enter End Date (YYYY-MM-DD): ");
+    
+    int startDate, endDate;
+    if (!parseDate(startDateText, startDate) || !parseDate(endDateText, endDate)) {
+        out_ << "Invalid date. Please use the YYYY-MM-DD format.\n";
+        waitForKey();
+        showOrderManagement();
+        return;
+    }
+    
+    // The planner covers pending orders from today on; earlier dates need a rebuild
+    int fromDate = std::min(startDate, currentDay());
+    if (!planner_) {
+        planner_ = std::make_unique<DemandPlanner>(db_);
+        planner_->rebuild(fromDate);
+    } else if (fromDate < planner_->getFromDate()) {
+        planner_->rebuild(fromDate);
+    }
+    
+    auto demand = planner_->getDemand(startDate, endDate);
+    
+    if (demand.empty()) {
+        out_ << "No flowers are needed for the specified period.\n";
+    } else {
+        std::map<int, Database::Flower> flowers;
+        for (const auto& flower : db_.getAllFlowers()) {
+            flowers[flower.id] = flower;
+        }
+        
+        out_ << std::left << std::setw(20) << "Flower" << std::setw(20) << "Variety" 
+                  << std::setw(10) << "Stems" << std::endl;
+        out_ << std::string(50, '-') << std::endl;
+        
+        for (const auto& [flowerId, stems] : demand) {
+            const Database::Flower& flower = flowers[flowerId];
+            out_ << std::left << std::setw(20) << flower.name << std::setw(20) << flower.variety 
+                      << std::setw(10) << stems << std::endl;
+        }
+    }
+    
+    waitForKey();
+    showOrderManagement();
+}
+
 std::string UI::getInput(const std::string& prompt) {
-    std::string input;
-    std::cout << prompt;
-    std::getline(std::cin, input);
-    return input;
+    out_ << prompt;
+    return readLine();
+}
+
+std::string UI::getSecretInput(const std::string& prompt) {
+    out_ << prompt;
+    return readLine(true);
 }
 
 int UI::getIntInput(const std::string& prompt) {
     while (true) {
-        std::cout << prompt;
-        std::string input;
-        std::getline(std::cin, input);
+        out_ << prompt;
+        std::string input = readLine();
         
         try {
             return std::stoi(input);
         } catch (const std::exception&) {
-            std::cout << "Invalid input. Please enter a number.\n";
+            out_ << "Invalid input. Please enter a number.\n";
         }
     }
 }
 
 double UI::getDoubleInput(const std::string& prompt) {
     while (true) {
-        std::cout << prompt;
-        std::string input;
-        std::getline(std::cin, input);
+        out_ << prompt;
+        std::string input = readLine();
         
         try {
             return std::stod(input);
         } catch (const std::exception&) {
-            std::cout << "Invalid input. Please enter a number.\n";
+            out_ << "Invalid input. Please enter a number.\n";
         }
     }
 }
 
 void UI::clearScreen() {
+    // Only a terminal session has a screen to clear
+    if (&out_ != &std::cout) {
+        return;
+    }
     #ifdef _WIN32
         system("cls");
     #else
@@ -719,6 +932,22 @@ void UI::clearScreen() {
 }
 
 void UI::waitForKey() {
-    std::cout << "\nPress Enter to continue...";
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    out_ << "\nPress Enter to continue...";
+    readLine();
+}
+
+std::string UI::readLine(bool secret) {
+    std::string line;
+    if (!mockInputs.empty()) {
+        line = mockInputs.front();
+        mockInputs.pop_front();
+    } else if (!std::getline(in_, line)) {
+        throw SessionEnded();
+    }
+    
+    if (recorder_) {
+        *recorder_ << (secret ? SECRET_LINE : line) << '\n';
+        recorder_->flush();
+    }
+    return line;
 }
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
  #include "../includes/authentication.h"
+ #include <chrono>
  #include <string>
  
  class AuthenticationTest : public ::testing::Test {
@@ -7,7 +8,10 @@
      Authentication* auth;
  
      void SetUp() override {
-         auth = new Authentication();
+         // Low cost keeps the tests fast; the format and upgrade logic do not depend on it
+         PasswordHashParams params;
+         params.logN = 8;
+         auth = new Authentication(params);
      }
  
      void TearDown() override {
@@ -96,3 +100,44 @@ TEST_F(AuthenticationTest, RoleBasedAccessTest) {
      ASSERT_TRUE(auth->registerUser(username, password, role));
      ASSERT_FALSE(auth->registerUser(username, "differentpassword", role));
  }
+
+// Test that a login re-hashes a password stored at an older cost
+TEST_F(AuthenticationTest, HashUpgradeOnLoginTest) {
+    PasswordHashParams oldParams;
+    oldParams.logN = 6;
+    Authentication oldAuth(oldParams);
+    ASSERT_TRUE(oldAuth.registerUser("florist", "peony", "user"));
+    std::string oldHash = oldAuth.getPasswordHash("florist");
+
+    ASSERT_TRUE(auth->loadUser("florist", oldHash, "user"));
+    ASSERT_FALSE(auth->login("florist", "wrong"));
+    ASSERT_EQ(auth->getPasswordHash("florist"), oldHash);
+
+    ASSERT_TRUE(auth->login("florist", "peony"));
+    std::string newHash = auth->getPasswordHash("florist");
+    ASSERT_NE(newHash, oldHash);
+    ASSERT_EQ(newHash.find("$ln=6,"), std::string::npos);
+
+    auth->logout();
+    ASSERT_TRUE(auth->login("florist", "peony"));
+    ASSERT_EQ(auth->getPasswordHash("florist"), newHash);
+    ASSERT_TRUE(auth->getPasswordHash("nobody").empty());
+}
+
+// Test that constructing costs no hashing; the built-in users are hashed when first needed
+TEST_F(AuthenticationTest, LazyBuiltInHashTest) {
+    PasswordHashParams params;
+    params.logN = 16;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++) {
+        Authentication costly(params);
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_LT(elapsedMs, 100.0);
+
+    std::string hash = auth->getPasswordHash("admin");
+    ASSERT_EQ(hash.compare(0, 16, "$scrypt$v=1$ln=8"), 0);
+    ASSERT_EQ(auth->getPasswordHash("admin"), hash);
+    ASSERT_TRUE(auth->login("admin", "admin123"));
+    ASSERT_EQ(auth->getPasswordHash("admin"), hash);
+}
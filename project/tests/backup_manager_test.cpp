@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include "../includes/backup_manager.h"
+#include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+const std::string BACKUP_SOURCE_PATH = "test_backup_flower.db";
+const std::string BACKUP_COPY_PATH = "test_backup_copy.db";
+
+class BackupManagerTest : public ::testing::Test {
+protected:
+    Database* db;
+    int orderDate;
+
+    // Copies flower.db and gives it enough orders to take many backup steps
+    void createSource(const DatabaseOptions& options) {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(BACKUP_SOURCE_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(BACKUP_SOURCE_PATH, options);
+        ASSERT_TRUE(db->connect());
+        db->setReportCacheBudget(0);
+        parseDate("2025-06-01", orderDate);
+        std::vector<Database::NewOrder> orders;
+        for (int i = 0; i < 5000; i++) {
+            orders.push_back({1 + i % 10, 1 + i % 5, orderDate, orderDate + i % 9, 1 + i % 3});
+        }
+        ASSERT_TRUE(db->applyJournaledOrders(orders, 1));
+    }
+
+    void SetUp() override {
+        db = nullptr;
+    }
+
+    void TearDown() override {
+        delete db;
+        for (const std::string& path : {BACKUP_SOURCE_PATH, BACKUP_COPY_PATH}) {
+            for (const char* suffix : {"", "-wal", "-shm", ".partial"}) {
+                std::remove((path + suffix).c_str());
+            }
+        }
+    }
+
+    // Small steps with a rest after each, so that the backup is still running while the test writes
+    static BackupOptions slowOptions() {
+        BackupOptions options;
+        options.pagesPerStep = 4;
+        options.stepPauseMs = 5;
+        options.checkpointIntervalSeconds = 0;
+        return options;
+    }
+
+    static size_t ordersIn(const std::string& path, int date) {
+        DatabaseOptions readOnly;
+        readOnly.readOnly = true;
+        Database copy(path, readOnly);
+        return copy.connect() ? copy.getOrdersByDate(date).size() : 0;
+    }
+};
+
+// Test that a WAL database is copied as of the moment the copy starts while orders keep coming in
+TEST_F(BackupManagerTest, BackupWhileWritingTest) {
+    DatabaseOptions options = DatabaseOptions::counterTerminal();
+    options.autoCheckpoint = false;
+    createSource(options);
+    size_t ordersBefore = db->getOrdersByDate(orderDate).size();
+
+    BackupManager manager(BACKUP_SOURCE_PATH, slowOptions());
+    ASSERT_TRUE(manager.start());
+    ASSERT_TRUE(manager.startBackup(BACKUP_COPY_PATH));
+    ASSERT_FALSE(manager.startBackup(BACKUP_COPY_PATH));
+    int written = 0;
+    while (manager.getStatus().state == BackupManager::State::Running) {
+        ASSERT_TRUE(db->createOrder(1, 1, orderDate, orderDate + 1, 1));
+        written++;
+    }
+    ASSERT_TRUE(manager.waitForBackup());
+    ASSERT_GT(written, 0);
+
+    BackupManager::Status status = manager.getStatus();
+    ASSERT_EQ(status.state, BackupManager::State::Succeeded);
+    ASSERT_TRUE(status.verified);
+    ASSERT_EQ(status.restarts, 0);
+    ASSERT_GT(status.pageCount, 50);
+    ASSERT_EQ(status.pagesCopied, status.pageCount);
+    // The copy starts on the background thread a little after startBackup
+    size_t ordersCopied = ordersIn(BACKUP_COPY_PATH, orderDate);
+    ASSERT_GE(ordersCopied, ordersBefore);
+    ASSERT_LT(ordersCopied, ordersBefore + written);
+    ASSERT_EQ(db->getOrdersByDate(orderDate).size(), ordersBefore + written);
+
+    // The backup ends with a checkpoint of the WAL it held back
+    ASSERT_GT(status.walFrames, 0);
+    ASSERT_GT(status.checkpointedFrames, 0);
+}
+
+// Test that the copy rate limit holds the copy back, whatever the step size
+TEST_F(BackupManagerTest, RateLimitTest) {
+    createSource(DatabaseOptions());
+    for (int pagesPerStep : {16, 0}) {
+        BackupOptions options;
+        options.pagesPerStep = pagesPerStep;
+        options.stepPauseMs = 0;
+        options.maxPagesPerSecond = 2000;
+        options.checkpointIntervalSeconds = 0;
+        BackupManager manager(BACKUP_SOURCE_PATH, options);
+        ASSERT_TRUE(manager.start());
+        ASSERT_TRUE(manager.startBackup(BACKUP_COPY_PATH));
+        ASSERT_TRUE(manager.waitForBackup());
+
+        BackupManager::Status status = manager.getStatus();
+        ASSERT_EQ(status.pagesCopied, status.pageCount);
+        if (pagesPerStep > 0) {
+            // Every step but the last one is paced
+            ASSERT_GE(status.elapsedMs, (status.pageCount - pagesPerStep) * 1000.0 / options.maxPagesPerSecond);
+        }
+    }
+}
+
+// Test a backup in rollback journal mode, where nothing writes during the copy
+TEST_F(BackupManagerTest, RollbackJournalTest) {
+    createSource(DatabaseOptions());
+    double revenue = db->getTotalRevenue(orderDate, orderDate);
+
+    BackupManager manager(BACKUP_SOURCE_PATH);
+    ASSERT_TRUE(manager.start());
+    ASSERT_TRUE(manager.startBackup(BACKUP_COPY_PATH));
+    ASSERT_TRUE(manager.waitForBackup());
+    ASSERT_EQ(manager.getStatus().walFrames, -1);
+
+    Database copy(BACKUP_COPY_PATH);
+    ASSERT_TRUE(copy.connect());
+    ASSERT_NEAR(copy.getTotalRevenue(orderDate, orderDate), revenue, 1e-6);
+}
+
+// Test that a cancelled backup leaves the previous one in place
+TEST_F(BackupManagerTest, CancelTest) {
+    createSource(DatabaseOptions());
+    {
+        std::ofstream previous(BACKUP_COPY_PATH);
+        previous << "previous backup";
+    }
+
+    BackupOptions options = slowOptions();
+    options.stepPauseMs = 1000;
+    BackupManager manager(BACKUP_SOURCE_PATH, options);
+    ASSERT_FALSE(manager.startBackup(BACKUP_COPY_PATH));
+    ASSERT_TRUE(manager.start());
+    ASSERT_TRUE(manager.startBackup(BACKUP_COPY_PATH));
+    manager.cancelBackup();
+    ASSERT_FALSE(manager.waitForBackup());
+    ASSERT_EQ(manager.getStatus().state, BackupManager::State::Cancelled);
+
+    std::ifstream previous(BACKUP_COPY_PATH);
+    std::string text;
+    std::getline(previous, text);
+    ASSERT_EQ(text, "previous backup");
+    ASSERT_FALSE(std::ifstream(BACKUP_COPY_PATH + ".partial").good());
+
+    // The manager takes the next backup as usual
+    manager.stop();
+    BackupManager next(BACKUP_SOURCE_PATH);
+    ASSERT_TRUE(next.start());
+    ASSERT_TRUE(next.startBackup(BACKUP_COPY_PATH));
+    ASSERT_TRUE(next.waitForBackup());
+}
+
+// Test integrity checking and that there is no backup of a database that does not exist
+TEST_F(BackupManagerTest, VerifyTest) {
+    std::string error;
+    ASSERT_TRUE(BackupManager::verify("flower.db", error));
+    ASSERT_TRUE(error.empty());
+
+    {
+        std::ofstream garbage(BACKUP_COPY_PATH);
+        garbage << "not a database at all, just some text that is long enough to have a header";
+    }
+    ASSERT_FALSE(BackupManager::verify(BACKUP_COPY_PATH, error));
+    ASSERT_FALSE(error.empty());
+
+    BackupManager manager("test_backup_missing.db");
+    ASSERT_FALSE(manager.start());
+}
+
+// Test that with automatic checkpoints off the WAL grows until the manager checkpoints it
+TEST_F(BackupManagerTest, CheckpointTest) {
+    DatabaseOptions options = DatabaseOptions::counterTerminal();
+    options.autoCheckpoint = false;
+    createSource(options);
+    for (int i = 0; i < 20; i++) {
+        ASSERT_TRUE(db->createOrder(1, 1, orderDate, orderDate + 1, 1));
+    }
+    std::ifstream wal(BACKUP_SOURCE_PATH + "-wal", std::ios::binary | std::ios::ate);
+    ASSERT_GT(static_cast<long long>(wal.tellg()), 0);
+    wal.close();
+
+    BackupManager manager(BACKUP_SOURCE_PATH);
+    ASSERT_TRUE(manager.checkpoint());
+    ASSERT_GT(manager.getStatus().walFrames, 0);
+    ASSERT_EQ(manager.getStatus().checkpointedFrames, manager.getStatus().walFrames);
+
+    ASSERT_TRUE(manager.checkpoint(true));
+    wal.open(BACKUP_SOURCE_PATH + "-wal", std::ios::binary | std::ios::ate);
+    ASSERT_EQ(static_cast<long long>(wal.tellg()), 0);
+    ASSERT_EQ(db->getOrdersByDate(orderDate).size(), 5020u);
+}
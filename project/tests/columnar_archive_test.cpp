@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include "../includes/columnar_archive.h"
+#include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+const std::string COLUMNAR_DB_PATH = "test_columnar_flower.db";
+const std::string COLUMNAR_PATH = "test_columnar_orders.col";
+
+class ColumnarArchiveTest : public ::testing::Test {
+protected:
+    Database* db;
+    int firstDay;
+    int lastDay;
+
+    static int day(const std::string& text) {
+        int days = 0;
+        parseDate(text, days);
+        return days;
+    }
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(COLUMNAR_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(COLUMNAR_DB_PATH);
+        ASSERT_TRUE(db->connect());
+        db->setReportCacheBudget(0);
+
+        // Two years of orders, enough for several blocks, with every urgency rate
+        firstDay = day("2023-01-01");
+        lastDay = day("2025-12-31");
+        std::vector<Database::NewOrder> orders;
+        for (int i = 0; i < 10000; i++) {
+            int date = firstDay + i * 730 / 10000;
+            orders.push_back({1 + i % 10, 1 + i % 5, date, date + i % 9, 1 + i % 7});
+        }
+        ASSERT_TRUE(db->applyJournaledOrders(orders, 1));
+        ASSERT_TRUE(ColumnarArchive::write(COLUMNAR_DB_PATH, firstDay, lastDay, COLUMNAR_PATH));
+    }
+
+    void TearDown() override {
+        delete db;
+        std::remove(COLUMNAR_DB_PATH.c_str());
+        std::remove(COLUMNAR_PATH.c_str());
+    }
+};
+
+// Test that range aggregates match the database's, including ranges cutting through blocks
+TEST_F(ColumnarArchiveTest, SameAggregatesTest) {
+    ColumnarArchive archive;
+    ASSERT_TRUE(archive.open(COLUMNAR_PATH));
+    ASSERT_EQ(archive.getOrderCount(), 10010u);
+    ASSERT_GT(archive.getBlockCount(), 2u);
+    ASSERT_EQ(archive.getFirstDate(), firstDay);
+    ASSERT_EQ(archive.getLastDate(), day("2025-04-17"));
+
+    auto recipes = db->getRecipeLines();
+    auto flowers = db->getAllFlowers();
+    std::vector<std::pair<int, int>> ranges = {{firstDay, lastDay},
+                                               {day("2023-03-15"), day("2023-03-15")},
+                                               {day("2023-05-10"), day("2024-08-20")},
+                                               {day("2024-12-01"), day("2025-04-30")},
+                                               {day("2021-01-01"), day("2022-12-31")}};
+    for (const auto& [start, end] : ranges) {
+        ASSERT_NEAR(archive.getTotalRevenue(start, end), db->getTotalRevenue(start, end), 1e-6) << start;
+        ASSERT_EQ(archive.getFlowerUsageByPeriod(start, end, recipes, flowers),
+                  db->getFlowerUsageByPeriod(start, end)) << start;
+    }
+
+    // A range inside one block looks at that block only
+    ASSERT_EQ(archive.countBlocks(day("2023-03-15"), day("2023-03-15")), 1u);
+    ASSERT_EQ(archive.countBlocks(day("2021-01-01"), day("2022-12-31")), 0u);
+    ASSERT_EQ(archive.countBlocks(firstDay, lastDay), archive.getBlockCount());
+}
+
+// Test that a composition id far above the others is counted like any other
+TEST_F(ColumnarArchiveTest, LargeCompositionIdTest) {
+    const int largeId = 2000000000;
+    sqlite3* handle = nullptr;
+    ASSERT_EQ(sqlite3_open(COLUMNAR_DB_PATH.c_str(), &handle), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(handle, ("INSERT INTO Compositions (CompositionID, CompositionName) VALUES (" +
+                                    std::to_string(largeId) + ", 'Sparse')").c_str(),
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(handle);
+    ASSERT_TRUE(db->createOrder(1, largeId, day("2025-06-01"), day("2025-06-02"), 4));
+    ASSERT_TRUE(ColumnarArchive::write(COLUMNAR_DB_PATH, firstDay, lastDay, COLUMNAR_PATH));
+
+    ColumnarArchive archive;
+    ASSERT_TRUE(archive.open(COLUMNAR_PATH));
+    std::map<int, long long> quantities = archive.getCompositionQuantities(firstDay, lastDay);
+    ASSERT_EQ(quantities[largeId], 4);
+    ASSERT_GT(quantities[1], 0);
+}
+
+// Test an archive of a single order, where every column of the block is constant
+TEST_F(ColumnarArchiveTest, SingleOrderTest) {
+    int date = day("2030-01-01");
+    ASSERT_TRUE(db->createOrder(2, 3, date, date + 1, 2));
+    ASSERT_TRUE(ColumnarArchive::write(COLUMNAR_DB_PATH, date, date, COLUMNAR_PATH));
+
+    ColumnarArchive archive;
+    ASSERT_TRUE(archive.open(COLUMNAR_PATH));
+    ASSERT_EQ(archive.getOrderCount(), 1u);
+    ASSERT_NEAR(archive.getTotalRevenue(date, date), db->getTotalRevenue(date, date), 1e-6);
+    std::vector<Database::Order> decoded;
+    archive.forEachOrder(date, date, [&](const Database::Order& order, double) { decoded.push_back(order); });
+    ASSERT_EQ(decoded.size(), 1u);
+    ASSERT_EQ(decoded[0].compositionId, 3);
+    ASSERT_EQ(decoded[0].quantity, 2);
+}
+
+// Test that every order decodes back to what the database holds
+TEST_F(ColumnarArchiveTest, RoundTripTest) {
+    ColumnarArchive archive;
+    ASSERT_TRUE(archive.open(COLUMNAR_PATH));
+
+    std::map<int, Database::Order> expected;
+    for (const auto& order : db->getOrdersByDateRange(firstDay, lastDay)) {
+        expected[order.id] = order;
+    }
+    size_t count = 0;
+    int lastDate = firstDay;
+    archive.forEachOrder(firstDay, lastDay, [&](const Database::Order& order, double totalPrice) {
+        const Database::Order& stored = expected.at(order.id);
+        ASSERT_EQ(order.customerId, stored.customerId);
+        ASSERT_EQ(order.compositionId, stored.compositionId);
+        ASSERT_EQ(order.orderDate, stored.orderDate);
+        ASSERT_EQ(order.fulfillmentDate, stored.fulfillmentDate);
+        ASSERT_EQ(order.quantity, stored.quantity);
+        ASSERT_DOUBLE_EQ(order.urgencyRate, stored.urgencyRate);
+        ASSERT_GE(order.orderDate, lastDate);
+        lastDate = order.orderDate;
+        count++;
+        if (order.id % 997 == 0) {
+            ASSERT_NEAR(totalPrice, db->getOrderSummary(order.id).totalPrice, 1e-9);
+        }
+    });
+    ASSERT_EQ(count, expected.size());
+}
+
+// Test that the file is a fraction of the database it came from
+TEST_F(ColumnarArchiveTest, SizeTest) {
+    ColumnarArchive archive;
+    ASSERT_TRUE(archive.open(COLUMNAR_PATH));
+    std::ifstream sqlite(COLUMNAR_DB_PATH, std::ios::binary | std::ios::ate);
+    ASSERT_LT(archive.getFileSize() * 4, static_cast<size_t>(sqlite.tellg()));
+    ASSERT_LT(archive.getFileSize() / archive.getOrderCount(), 16u);
+}
+
+// Test that missing, foreign and truncated files are refused
+TEST_F(ColumnarArchiveTest, InvalidFileTest) {
+    ColumnarArchive archive;
+    ASSERT_FALSE(archive.open("test_columnar_missing.col"));
+    ASSERT_FALSE(archive.open(COLUMNAR_DB_PATH));
+    ASSERT_FALSE(archive.isOpen());
+
+    std::ifstream src(COLUMNAR_PATH, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(src)), std::istreambuf_iterator<char>());
+    std::ofstream dst(COLUMNAR_PATH, std::ios::binary | std::ios::trunc);
+    dst.write(bytes.data(), bytes.size() / 2);
+    dst.close();
+    ASSERT_FALSE(archive.open(COLUMNAR_PATH));
+    ASSERT_EQ(archive.getTotalRevenue(firstDay, lastDay), 0.0);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include "../includes/database.h"
+#include "../includes/database_options.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+const std::string OPTIONS_CONFIG_PATH = "test_database_options.conf";
+const std::string OPTIONS_DB_PATH = "test_options_flower.db";
+
+static void writeConfig(const std::string& text) {
+    std::ofstream config(OPTIONS_CONFIG_PATH);
+    config << text;
+}
+
+// Test that a preset can be loaded and overridden from a config file
+TEST(DatabaseOptionsTest, LoadFromFileTest) {
+    writeConfig("# reporting box with a smaller mmap\n"
+                "preset = reporting_server\n"
+                "mmap_size = 1048576   # 1 MiB\n"
+                "synchronous = full\n"
+                "busy_timeout_ms = 2000\n");
+
+    DatabaseOptions options;
+    ASSERT_TRUE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    ASSERT_EQ(options.cacheSizeKiB, DatabaseOptions::reportingServer().cacheSizeKiB);
+    ASSERT_EQ(options.journalMode, "WAL");
+    ASSERT_EQ(options.mmapSize, 1048576);
+    ASSERT_EQ(options.synchronous, "FULL");
+    ASSERT_EQ(options.busyTimeoutMs, 2000);
+    std::remove(OPTIONS_CONFIG_PATH.c_str());
+}
+
+// Test rejection of unknown keys and invalid values
+TEST(DatabaseOptionsTest, InvalidConfigTest) {
+    DatabaseOptions options;
+    writeConfig("page_size = 3000\n");
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    writeConfig("journal_mode = fast\n");
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    writeConfig("cache_size = 10\n");
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    writeConfig("auto_checkpoint = sometimes\n");
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    writeConfig("preset = turbo\n");
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    std::remove(OPTIONS_CONFIG_PATH.c_str());
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+}
+
+// Test pragma generation, page_size first and defaults left alone
+TEST(DatabaseOptionsTest, PragmasTest) {
+    ASSERT_TRUE(DatabaseOptions().pragmas().empty());
+
+    DatabaseOptions options = DatabaseOptions::counterTerminal();
+    options.pageSize = 8192;
+    std::vector<std::string> pragmas = options.pragmas();
+    ASSERT_EQ(pragmas.front(), "PRAGMA page_size = 8192");
+    ASSERT_NE(std::find(pragmas.begin(), pragmas.end(), "PRAGMA cache_size = -8192"), pragmas.end());
+
+    options.busyTimeoutMs = 250;
+    options.autoCheckpoint = false;
+    pragmas = options.pragmas();
+    ASSERT_NE(std::find(pragmas.begin(), pragmas.end(), "PRAGMA busy_timeout = 250"), pragmas.end());
+    ASSERT_NE(std::find(pragmas.begin(), pragmas.end(), "PRAGMA wal_autocheckpoint = 0"), pragmas.end());
+}
+
+// Test that connect() applies the options to the connection
+TEST(DatabaseOptionsTest, ApplyOnConnectTest) {
+    {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(OPTIONS_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+    }
+
+    Database db(OPTIONS_DB_PATH, DatabaseOptions::reportingServer());
+    ASSERT_TRUE(db.connect());
+    ASSERT_GT(db.getAllFlowers().size(), 0);
+    db.disconnect();
+
+    // WAL is a persistent property of the file
+    sqlite3* handle = nullptr;
+    ASSERT_EQ(sqlite3_open(OPTIONS_DB_PATH.c_str(), &handle), SQLITE_OK);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(handle, "PRAGMA journal_mode", -1, &stmt, nullptr);
+    ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+    ASSERT_EQ(std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))), "wal");
+    sqlite3_finalize(stmt);
+    sqlite3_close(handle);
+
+    std::remove(OPTIONS_DB_PATH.c_str());
+    std::remove((OPTIONS_DB_PATH + "-wal").c_str());
+    std::remove((OPTIONS_DB_PATH + "-shm").c_str());
+}
+
+// Test read-only keys and that read-only connections leave file-level pragmas alone
+TEST(DatabaseOptionsTest, ReadOnlyConfigTest) {
+    writeConfig("preset = reporting_server\n"
+                "read_only = yes\n"
+                "immutable = off\n");
+
+    DatabaseOptions options;
+    ASSERT_TRUE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    ASSERT_TRUE(options.readOnly);
+    ASSERT_FALSE(options.immutable);
+    for (const auto& pragma : options.pragmas()) {
+        ASSERT_EQ(pragma.find("journal_mode"), std::string::npos);
+    }
+
+    writeConfig("read_only = maybe\n");
+    ASSERT_FALSE(DatabaseOptions::loadFromFile(OPTIONS_CONFIG_PATH, options));
+    std::remove(OPTIONS_CONFIG_PATH.c_str());
+}
+
+// Test that read-only and immutable connections serve reports but refuse writes
+TEST(DatabaseOptionsTest, ReadOnlyConnectTest) {
+    {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(OPTIONS_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+    }
+
+    // The file has the original schema and cannot be upgraded through a read-only handle
+    DatabaseOptions readOnly;
+    readOnly.readOnly = true;
+    Database stale(OPTIONS_DB_PATH, readOnly);
+    ASSERT_FALSE(stale.connect());
+
+    {
+        Database writer(OPTIONS_DB_PATH);
+        ASSERT_TRUE(writer.connect());
+    }
+
+    Database reader(OPTIONS_DB_PATH, readOnly);
+    ASSERT_TRUE(reader.connect());
+    ASSERT_GT(reader.getAllFlowers().size(), 0);
+    std::vector<Database::Order> orders = reader.getOrdersByDateRange(0, 1000000);
+    ASSERT_GT(orders.size(), 0);
+    ASSERT_GT(reader.getOrdersByDate(orders[0].orderDate).size(), 0);
+    ASSERT_EQ(reader.getOrderSummary(orders[0].id).orderId, orders[0].id);
+    ASSERT_FALSE(reader.createOrder(orders[0].customerId, orders[0].compositionId,
+                                    orders[0].orderDate, orders[0].fulfillmentDate, 1));
+    reader.disconnect();
+
+    DatabaseOptions frozen;
+    frozen.immutable = true;
+    Database archive(OPTIONS_DB_PATH, frozen);
+    ASSERT_TRUE(archive.connect());
+    ASSERT_EQ(archive.getOrdersByDateRange(0, 1000000).size(), orders.size());
+    ASSERT_GT(archive.getTotalRevenue(0, 1000000), 0.0);
+    archive.disconnect();
+
+    std::remove(OPTIONS_DB_PATH.c_str());
+}
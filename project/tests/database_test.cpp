@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -17,6 +19,13 @@ void createTestDatabase() {
     dst.close();
 }
 
+// Day number for a "YYYY-MM-DD" literal
+int day(const std::string& date) {
+    int days = 0;
+    parseDate(date, days);
+    return days;
+}
+
 class DatabaseTest : public ::testing::Test {
 protected:
     Database* db;
@@ -111,8 +120,8 @@ TEST_F(DatabaseTest, CreateOrderTest) {
     int customerId = customers[0].id;
     int compositionId = compositions[0].id;
     
-    std::string orderDate = "2025-04-21";
-    std::string fulfillmentDate = "2025-04-22";
+    int orderDate = day("2025-04-21");
+    int fulfillmentDate = day("2025-04-22");
     int quantity = 1;
     
     ASSERT_TRUE(db->createOrder(customerId, compositionId, orderDate, fulfillmentDate, quantity));
@@ -130,8 +139,8 @@ TEST_F(DatabaseTest, CreateOrderTest) {
 
 // Test getting orders by date range
 TEST_F(DatabaseTest, GetOrdersByDateRangeTest) {
-    std::string startDate = "2025-04-01";
-    std::string endDate = "2025-04-20";
+    int startDate = day("2025-04-01");
+    int endDate = day("2025-04-20");
     
     std::vector<Database::Order> orders = db->getOrdersByDateRange(startDate, endDate);
     ASSERT_GT(orders.size(), 0);
@@ -139,7 +148,7 @@ TEST_F(DatabaseTest, GetOrdersByDateRangeTest) {
 
 // Test getting order summary
 TEST_F(DatabaseTest, GetOrderSummaryTest) {
-    std::vector<Database::Order> orders = db->getOrdersByDateRange("2025-04-01", "2025-04-30");
+    std::vector<Database::Order> orders = db->getOrdersByDateRange(day("2025-04-01"), day("2025-04-30"));
     ASSERT_GT(orders.size(), 0);
     
     int orderId = orders[0].id;
@@ -148,3 +157,408 @@ TEST_F(DatabaseTest, GetOrderSummaryTest) {
     ASSERT_EQ(summary.orderId, orderId);
     ASSERT_GT(summary.totalPrice, 0.0);
 }
+
+// Test that text dates of an existing database are migrated to day numbers
+TEST_F(DatabaseTest, MigratedOrderDatesTest) {
+    std::vector<Database::Order> orders = db->getOrdersByDate(day("2025-04-02"));
+    ASSERT_EQ(orders.size(), 1);
+    ASSERT_EQ(orders[0].fulfillmentDate, day("2025-04-02"));
+
+    orders = db->getOrdersByDateRange(day("2025-04-01"), day("2025-04-05"));
+    ASSERT_EQ(orders.size(), 4);
+    for (const auto& order : orders) {
+        ASSERT_GE(order.fulfillmentDate, order.orderDate);
+    }
+}
+
+// Test that a migrated database reconnects without re-running migrations
+TEST_F(DatabaseTest, ReconnectAfterMigrationTest) {
+    db->disconnect();
+    ASSERT_TRUE(db->connect());
+    ASSERT_GT(db->getTotalRevenue(day("2025-04-01"), day("2025-04-30")), 0.0);
+}
+
+// Test that order pricing follows the maintained composition unit cost
+TEST_F(DatabaseTest, OrderPriceUsesUnitCostTest) {
+    std::vector<Database::Flower> flowers = db->getAllFlowers();
+    std::map<int, double> prices;
+    for (const auto& flower : flowers) {
+        prices[flower.id] = flower.price;
+    }
+
+    const int compositionId = 1;
+    std::map<int, int> recipe = db->getCompositionFlowers(compositionId);
+    ASSERT_GT(recipe.size(), 0);
+
+    // Raise the price of one component, then price a new order of 3 bouquets
+    int changedFlower = recipe.begin()->first;
+    prices[changedFlower] *= 1.05;
+    ASSERT_TRUE(db->updateFlowerPrice(changedFlower, prices[changedFlower]));
+
+    double unitCost = 0.0;
+    for (const auto& [flowerId, quantity] : recipe) {
+        unitCost += prices[flowerId] * quantity;
+    }
+
+    ASSERT_TRUE(db->createOrder(1, compositionId, day("2025-05-01"), day("2025-05-10"), 3));
+    std::vector<Database::Order> orders = db->getOrdersByDate(day("2025-05-01"));
+    ASSERT_EQ(orders.size(), 1);
+
+    Database::OrderSummary summary = db->getOrderSummary(orders[0].id);
+    ASSERT_NEAR(summary.basePrice, unitCost * 3, 0.01);
+}
+
+// Test that urgency is set by the insert itself and priced into the summary
+TEST_F(DatabaseTest, UrgencyRateOnInsertTest) {
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-06-01"), day("2025-06-01"), 1));
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-06-02"), day("2025-06-04"), 1));
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-06-03"), day("2025-06-10"), 1));
+
+    const double expectedRates[] = {0.25, 0.15, 0.0};
+    std::vector<Database::Order> orders = db->getOrdersByDateRange(day("2025-06-01"), day("2025-06-03"));
+    ASSERT_EQ(orders.size(), 3);
+    for (size_t i = 0; i < orders.size(); i++) {
+        ASSERT_NEAR(orders[i].urgencyRate, expectedRates[i], 1e-9);
+
+        Database::OrderSummary summary = db->getOrderSummary(orders[i].id);
+        ASSERT_NEAR(summary.urgencyFee, summary.basePrice * expectedRates[i], 0.01);
+        ASSERT_NEAR(summary.totalPrice, summary.basePrice + summary.urgencyFee, 0.01);
+    }
+}
+
+// Test that reports are served from cache until a write bumps the generation
+TEST_F(DatabaseTest, ReportCacheInvalidationTest) {
+    int start = day("2025-04-01");
+    int end = day("2025-07-31");
+
+    double revenue = db->getTotalRevenue(start, end);
+    ASSERT_EQ(db->getTotalRevenue(start, end), revenue);
+    ASSERT_EQ(db->getReportCacheStats().hits, 1);
+
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-07-01"), day("2025-07-10"), 1));
+    double updated = db->getTotalRevenue(start, end);
+    ASSERT_GT(updated, revenue);
+    ASSERT_EQ(db->getReportCacheStats().hits, 1);
+
+    // Writes through another connection are detected as well
+    Database other(TEST_DB_PATH);
+    ASSERT_TRUE(other.connect());
+    ASSERT_TRUE(other.createOrder(1, 1, day("2025-07-02"), day("2025-07-10"), 1));
+    other.disconnect();
+    ASSERT_GT(db->getTotalRevenue(start, end), updated);
+}
+
+// Test that a zero budget disables the report cache
+TEST_F(DatabaseTest, ReportCacheDisabledTest) {
+    db->setReportCacheBudget(0);
+    db->getCompositionSalesSummary();
+    db->getCompositionSalesSummary();
+    ASSERT_EQ(db->getReportCacheStats().hits, 0);
+    ASSERT_EQ(db->getReportCacheStats().entries, 0);
+}
+
+// Test that reports read the in-memory snapshot until it is refreshed after N writes
+TEST_F(DatabaseTest, ReportSnapshotTest) {
+    int start = day("2025-04-01");
+    int end = day("2025-10-31");
+    double revenue = db->getTotalRevenue(start, end);
+
+    ASSERT_TRUE(db->enableReportSnapshot(3600, 2));
+    ASSERT_TRUE(db->hasReportSnapshot());
+    ASSERT_NEAR(db->getTotalRevenue(start, end), revenue, 0.01);
+
+    // One write: still within the allowed staleness
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-10-01"), day("2025-10-10"), 1));
+    ASSERT_NEAR(db->getTotalRevenue(start, end), revenue, 0.01);
+    ASSERT_EQ(db->getOrdersByDate(day("2025-10-01")).size(), 1);
+
+    // Second write reaches the limit, the next report refreshes the snapshot
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-10-02"), day("2025-10-10"), 1));
+    double refreshed = db->getTotalRevenue(start, end);
+    ASSERT_GT(refreshed, revenue);
+
+    db->disableReportSnapshot();
+    ASSERT_FALSE(db->hasReportSnapshot());
+    ASSERT_NEAR(db->getTotalRevenue(start, end), refreshed, 0.01);
+}
+
+// Test that arena-backed listings match the string-based ones
+TEST_F(DatabaseTest, ArenaResultSetsTest) {
+    std::vector<Database::Flower> flowers = db->getAllFlowers();
+    Database::ResultSet<Database::FlowerView> flowerTable = db->getFlowerTable();
+    ASSERT_EQ(flowerTable.rows.size(), flowers.size());
+    for (size_t i = 0; i < flowers.size(); i++) {
+        ASSERT_EQ(flowerTable.rows[i].id, flowers[i].id);
+        ASSERT_EQ(flowerTable.rows[i].name, flowers[i].name);
+        ASSERT_EQ(flowerTable.rows[i].variety, flowers[i].variety);
+    }
+
+    // Duplicate customer names share one interned copy
+    Database::ResultSet<Database::CustomerView> customers = db->getCustomerTable();
+    ASSERT_EQ(customers.rows.size(), db->getAllCustomers().size());
+    ASSERT_EQ(customers.rows[0].name, customers.rows[5].name);
+    ASSERT_EQ(customers.rows[0].name.data(), customers.rows[5].name.data());
+
+    auto usage = db->getFlowerUsageByPeriod(day("2025-04-01"), day("2025-04-30"));
+    Database::ResultSet<Database::FlowerUsageView> usageTable = db->getFlowerUsageTable(day("2025-04-01"), day("2025-04-30"));
+    size_t pairs = 0;
+    for (const auto& row : usageTable.rows) {
+        ASSERT_EQ(usage[std::string(row.flowerName)][std::string(row.variety)], row.quantity);
+        pairs++;
+    }
+    size_t expectedPairs = 0;
+    for (const auto& entry : usage) {
+        expectedPairs += entry.second.size();
+    }
+    ASSERT_EQ(pairs, expectedPairs);
+}
+
+// Test that customer lookups are served from the cache and batched on misses
+TEST_F(DatabaseTest, CustomerCacheTest) {
+    Database::Customer first = db->getCustomerById(1);
+    ASSERT_EQ(first.id, 1);
+    ASSERT_EQ(db->getCustomerCacheStats().misses, 1);
+    ASSERT_EQ(db->getCustomerById(1).name, first.name);
+    ASSERT_EQ(db->getCustomerCacheStats().hits, 1);
+
+    // Unknown customers are reported as id 0 and not cached
+    ASSERT_EQ(db->getCustomerById(999).id, 0);
+    ASSERT_EQ(db->getCustomerCacheStats().entries, 1);
+
+    auto customers = db->getCustomersByIds({1, 2, 3, 3, 999});
+    ASSERT_EQ(customers.size(), 3);
+    ASSERT_EQ(customers[2].id, 2);
+    ASSERT_EQ(customers[3].name, db->getAllCustomers()[2].name);
+    ASSERT_EQ(db->getCustomerCacheStats().entries, 3);
+
+    // The cache keeps only the most recently used customers
+    db->setCustomerCacheSize(2);
+    ASSERT_EQ(db->getCustomerCacheStats().entries, 2);
+    ASSERT_EQ(db->getCustomerCacheStats().evictions, 1);
+}
+
+// Test that a customer changed through another connection is not served stale from the cache
+TEST_F(DatabaseTest, CustomerCacheExternalUpdateTest) {
+    std::string name = db->getCustomerById(1).name;
+    ASSERT_EQ(db->getCustomerById(1).name, name);
+    ASSERT_EQ(db->getCustomerCacheStats().hits, 1);
+
+    sqlite3* handle = nullptr;
+    ASSERT_EQ(sqlite3_open(TEST_DB_PATH.c_str(), &handle), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(handle, "UPDATE Customers SET CustomerName = 'Renamed Elsewhere' WHERE CustomerID = 1",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(handle);
+
+    ASSERT_EQ(db->getCustomerById(1).name, "Renamed Elsewhere");
+    ASSERT_EQ(db->getCustomersByIds({1})[1].name, "Renamed Elsewhere");
+}
+
+// Test that walking pages visits every row once, in key order
+TEST_F(DatabaseTest, KeysetPaginationTest) {
+    std::vector<int> customerIds;
+    Database::PageCursor cursor;
+    Database::Page<Database::Customer> customers;
+    do {
+        customers = db->getCustomersPage(cursor, 3);
+        ASSERT_LE(customers.rows.size(), 3);
+        for (const auto& customer : customers.rows) {
+            customerIds.push_back(customer.id);
+        }
+        cursor = customers.next;
+    } while (customers.hasMore);
+    ASSERT_EQ(customerIds.size(), db->getAllCustomers().size());
+    ASSERT_TRUE(std::is_sorted(customerIds.begin(), customerIds.end()));
+
+    auto compositions = db->getCompositionsPage(Database::PageCursor(), 100);
+    ASSERT_FALSE(compositions.hasMore);
+    ASSERT_EQ(compositions.rows.size(), db->getAllCompositions().size());
+
+    // Orders sharing a date are split across pages by id
+    ASSERT_TRUE(db->createOrder(1, 1, day("2025-04-01"), day("2025-04-10"), 1));
+    ASSERT_TRUE(db->createOrder(2, 1, day("2025-04-01"), day("2025-04-10"), 1));
+    std::vector<std::pair<int, int>> orderKeys;
+    cursor = Database::PageCursor();
+    Database::Page<Database::Order> orders;
+    do {
+        orders = db->getOrdersPage(cursor, 2);
+        for (const auto& order : orders.rows) {
+            orderKeys.push_back({order.orderDate, order.id});
+        }
+        cursor = orders.next;
+    } while (orders.hasMore);
+    ASSERT_EQ(orderKeys.size(), db->getOrdersByDateRange(day("2000-01-01"), day("2100-01-01")).size());
+    ASSERT_TRUE(std::is_sorted(orderKeys.begin(), orderKeys.end()));
+    ASSERT_EQ(std::adjacent_find(orderKeys.begin(), orderKeys.end()), orderKeys.end());
+}
+
+// Test prefix search over customer and composition fields, and index maintenance
+TEST_F(DatabaseTest, FullTextSearchTest) {
+    Database::Customer customer = db->getCustomerById(1);
+
+    std::string namePrefix = customer.name.substr(0, customer.name.find(' ') - 2);
+    auto byName = db->searchCustomers(namePrefix);
+    ASSERT_FALSE(byName.empty());
+    ASSERT_EQ(byName[0].name, customer.name);
+
+    auto byEmail = db->searchCustomers(customer.email);
+    ASSERT_FALSE(byEmail.empty());
+    ASSERT_EQ(byEmail[0].email, customer.email);
+
+    // Phone numbers match with or without punctuation
+    ASSERT_FALSE(db->searchCustomers("+7(900)123").empty());
+    ASSERT_FALSE(db->searchCustomers("7900123").empty());
+    ASSERT_TRUE(db->searchCustomers("no-such-customer").empty());
+    ASSERT_TRUE(db->searchCustomers("  ").empty());
+    ASSERT_TRUE(db->searchCustomers("it's \"quoted\"").empty());
+
+    auto compositions = db->searchCompositions(db->getAllCompositions()[0].name);
+    ASSERT_FALSE(compositions.empty());
+    ASSERT_EQ(compositions[0].id, db->getAllCompositions()[0].id);
+
+    // The index follows changes to the Customers table
+    sqlite3* handle = nullptr;
+    ASSERT_EQ(sqlite3_open(TEST_DB_PATH.c_str(), &handle), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(handle, "INSERT INTO Customers (CustomerName, PhoneNumber, Email) "
+                                   "VALUES ('Zoe Kowalski', '+48 555 010 203', 'zoe@example.com')",
+                           nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(handle);
+    ASSERT_EQ(db->searchCustomers("kowal zoe").size(), 1);
+    ASSERT_EQ(db->searchCustomers("48555").size(), 1);
+}
+
+// Test that series buckets cover the range and add up to the scalar total
+TEST_F(DatabaseTest, RevenueSeriesTest) {
+    int start = day("2025-03-15");
+    int end = day("2025-06-10");
+
+    auto months = db->getRevenueSeries(start, end, Database::Granularity::Month);
+    ASSERT_EQ(months.size(), 4);
+    ASSERT_EQ(months[0].startDate, day("2025-03-01"));
+    ASSERT_EQ(months[3].startDate, day("2025-06-01"));
+    ASSERT_EQ(months[0].orderCount, 0);
+    ASSERT_EQ(months[2].orderCount, 0);
+
+    double total = 0.0;
+    int orders = 0;
+    for (const auto& bucket : months) {
+        total += bucket.revenue;
+        orders += bucket.orderCount;
+        ASSERT_GE(bucket.urgencyFeeShare, 0.0);
+        ASSERT_LT(bucket.urgencyFeeShare, 1.0);
+    }
+    ASSERT_NEAR(total, db->getTotalRevenue(start, end), 0.01);
+    ASSERT_EQ(orders, db->getOrdersByDateRange(start, end).size());
+
+    // Weeks start on Monday; 2025-04-01 was a Tuesday
+    auto weeks = db->getRevenueSeries(day("2025-04-01"), day("2025-04-30"), Database::Granularity::Week);
+    ASSERT_EQ(weeks[0].startDate, day("2025-03-31"));
+    ASSERT_EQ(weeks.size(), 5);
+    ASSERT_EQ(db->getRevenueSeries(start, end, Database::Granularity::Day).size(), end - start + 1);
+    ASSERT_EQ(db->getRevenueSeries(start, end, Database::Granularity::Year).size(), 1);
+    ASSERT_TRUE(db->getRevenueSeries(end, start, Database::Granularity::Day).empty());
+
+    Database::Granularity granularity;
+    ASSERT_TRUE(Database::parseGranularity("week", granularity));
+    ASSERT_EQ(granularity, Database::Granularity::Week);
+    ASSERT_FALSE(Database::parseGranularity("quarter", granularity));
+}
+
+// Test that the composition sales aggregate folds in only orders past its watermark
+TEST_F(DatabaseTest, IncrementalCompositionSalesTest) {
+    db->setReportCacheBudget(0);
+    ASSERT_TRUE(db->refreshCompositionSales());
+    auto before = db->getCompositionSalesSummary();
+    int watermark = db->getCompositionSalesWatermark();
+    ASSERT_FALSE(before.empty());
+    ASSERT_GT(watermark, 0);
+
+    std::string name = db->getAllCompositions()[0].name;
+    int compositionId = db->getAllCompositions()[0].id;
+    double added = 0.0;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(db->createOrder(1, compositionId, day("2025-08-01"), day("2025-08-0" + std::to_string(2 + i)), 1));
+    }
+    auto orders = db->getOrdersByDate(day("2025-08-01"));
+    ASSERT_EQ(orders.size(), 3u);
+    for (const auto& order : orders) {
+        added += db->getOrderSummary(order.id).totalPrice;
+    }
+
+    // A read-only connection adds the orders past the watermark without moving it
+    DatabaseOptions readOnly;
+    readOnly.readOnly = true;
+    Database reader(TEST_DB_PATH, readOnly);
+    ASSERT_TRUE(reader.connect());
+    ASSERT_EQ(reader.getCompositionSalesSummary()[name].first, before[name].first + 3);
+    ASSERT_EQ(reader.getCompositionSalesWatermark(), watermark);
+    reader.disconnect();
+
+    // So does the writing connection, even while another one holds the write lock
+    sqlite3* writer = nullptr;
+    ASSERT_EQ(sqlite3_open(TEST_DB_PATH.c_str(), &writer), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(writer, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr), SQLITE_OK);
+    auto after = db->getCompositionSalesSummary();
+    sqlite3_exec(writer, "ROLLBACK", nullptr, nullptr, nullptr);
+    sqlite3_close(writer);
+    ASSERT_EQ(after[name].first, before[name].first + 3);
+    ASSERT_NEAR(after[name].second, before[name].second + added, 1e-6);
+    ASSERT_EQ(db->getCompositionSalesSummary(), after);
+    ASSERT_EQ(db->getCompositionSalesWatermark(), watermark);
+
+    ASSERT_TRUE(db->refreshCompositionSales());
+    ASSERT_EQ(db->getCompositionSalesSummary(), after);
+    ASSERT_EQ(db->getCompositionSalesWatermark(), orders.back().id);
+
+    // Nothing new: the refresh changes nothing
+    ASSERT_TRUE(db->refreshCompositionSales());
+    ASSERT_EQ(db->getCompositionSalesSummary(), after);
+    ASSERT_EQ(db->getCompositionSalesWatermark(), orders.back().id);
+}
+
+// Test that order entry refreshes the aggregate once enough orders have gone through it
+TEST_F(DatabaseTest, CompositionSalesFoldOnWriteTest) {
+    ASSERT_TRUE(db->refreshCompositionSales());
+    int compositionId = db->getAllCompositions()[0].id;
+    std::vector<Database::NewOrder> orders(Database::COMPOSITION_SALES_FOLD_ORDERS - 2,
+                                           {1, compositionId, day("2025-08-01"), day("2025-08-02"), 1});
+    ASSERT_TRUE(db->applyJournaledOrders(orders, 1));
+    int watermark = db->getCompositionSalesWatermark();
+
+    ASSERT_TRUE(db->createOrder(1, compositionId, day("2025-08-01"), day("2025-08-02"), 1));
+    ASSERT_EQ(db->getCompositionSalesWatermark(), watermark);
+    ASSERT_TRUE(db->createOrder(1, compositionId, day("2025-08-01"), day("2025-08-02"), 1));
+    ASSERT_EQ(db->getCompositionSalesWatermark(), db->getOrdersByDate(day("2025-08-01")).back().id);
+}
+
+// Test that orders written around this class are folded in by the next summary or connect
+TEST_F(DatabaseTest, CompositionSalesFoldBehindTest) {
+    ASSERT_TRUE(db->refreshCompositionSales());
+    int watermark = db->getCompositionSalesWatermark();
+    auto insertOrders = [](int count) {
+        sqlite3* handle = nullptr;
+        ASSERT_EQ(sqlite3_open(TEST_DB_PATH.c_str(), &handle), SQLITE_OK);
+        std::string sql = "BEGIN;";
+        for (int i = 0; i < count; i++) {
+            sql += "INSERT INTO Orders (CustomerID, CompositionID, OrderDate, FulfillmentDate, Quantity, UrgencyRate) "
+                   "VALUES (1, 1, 20300, 20301, 1, 1.25);";
+        }
+        ASSERT_EQ(sqlite3_exec(handle, (sql + "COMMIT;").c_str(), nullptr, nullptr, nullptr), SQLITE_OK);
+        sqlite3_close(handle);
+    };
+
+    // A few orders stay in the part the summary adds up itself
+    insertOrders(10);
+    db->getCompositionSalesSummary();
+    ASSERT_EQ(db->getCompositionSalesWatermark(), watermark);
+
+    insertOrders(Database::COMPOSITION_SALES_FOLD_ORDERS);
+    db->getCompositionSalesSummary();
+    int folded = db->getCompositionSalesWatermark();
+    ASSERT_EQ(folded, watermark + 10 + Database::COMPOSITION_SALES_FOLD_ORDERS);
+
+    insertOrders(Database::COMPOSITION_SALES_FOLD_ORDERS);
+    Database other(TEST_DB_PATH);
+    ASSERT_TRUE(other.connect());
+    ASSERT_EQ(other.getCompositionSalesWatermark(), folded + Database::COMPOSITION_SALES_FOLD_ORDERS);
+}
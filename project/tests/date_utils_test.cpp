@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+#include "../includes/date_utils.h"
+#include <string>
+
+// Test known day numbers
+TEST(DateUtilsTest, ParseKnownDatesTest) {
+    int days = -1;
+    ASSERT_TRUE(parseDate("1970-01-01", days));
+    ASSERT_EQ(days, 0);
+    ASSERT_TRUE(parseDate("2000-03-01", days));
+    ASSERT_EQ(days, 11017);
+    ASSERT_TRUE(parseDate("2025-04-21", days));
+    ASSERT_EQ(days, 20199);
+}
+
+// Test that formatting reverses parsing
+TEST(DateUtilsTest, RoundTripTest) {
+    for (int days = -1000; days < 30000; days += 7) {
+        int parsed = 0;
+        ASSERT_TRUE(parseDate(formatDate(days), parsed));
+        ASSERT_EQ(parsed, days);
+    }
+}
+
+// Test rejection of malformed and impossible dates
+TEST(DateUtilsTest, InvalidDatesTest) {
+    int days = 0;
+    ASSERT_FALSE(parseDate("", days));
+    ASSERT_FALSE(parseDate("2025-4-21", days));
+    ASSERT_FALSE(parseDate("2025/04/21", days));
+    ASSERT_FALSE(parseDate("2025-13-01", days));
+    ASSERT_FALSE(parseDate("2025-02-29", days));
+    ASSERT_TRUE(parseDate("2024-02-29", days));
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "../includes/demand_planner.h"
+#include "../includes/date_utils.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::string PLANNER_DB_PATH = "planner_test_flower.db";
+
+class DemandPlannerTest : public ::testing::Test {
+protected:
+    Database* db;
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(PLANNER_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(PLANNER_DB_PATH);
+        ASSERT_TRUE(db->connect());
+    }
+
+    void TearDown() override {
+        delete db;
+        std::remove(PLANNER_DB_PATH.c_str());
+    }
+
+    // Demand computed the slow way, one recipe query per order
+    std::map<int, long long> expectedDemand(int fromDate, int startDate, int endDate) {
+        std::map<int, long long> demand;
+        for (const auto& order : db->getPendingOrders(fromDate)) {
+            if (order.fulfillmentDate < startDate || order.fulfillmentDate > endDate) {
+                continue;
+            }
+            for (const auto& [flowerId, stems] : db->getCompositionFlowers(order.compositionId)) {
+                demand[flowerId] += static_cast<long long>(stems) * order.quantity;
+            }
+        }
+        return demand;
+    }
+};
+
+// Test that the matrix expansion matches per-order recipe lookups
+TEST_F(DemandPlannerTest, RebuildTest) {
+    int fromDate = 0;
+    ASSERT_TRUE(parseDate("2025-04-01", fromDate));
+    for (size_t workers : {1, 3, 8}) {
+        DemandPlanner planner(*db, workers);
+        ASSERT_TRUE(planner.rebuild(fromDate));
+        ASSERT_EQ(planner.getFromDate(), fromDate);
+
+        auto demand = planner.getDemand(fromDate, fromDate + 365);
+        ASSERT_FALSE(demand.empty());
+        ASSERT_EQ(demand, expectedDemand(fromDate, fromDate, fromDate + 365));
+    }
+}
+
+// Test that new orders are added as they are created
+TEST_F(DemandPlannerTest, IncrementalUpdateTest) {
+    int fromDate = 0;
+    ASSERT_TRUE(parseDate("2025-06-01", fromDate));
+    DemandPlanner planner(*db, 2);
+    ASSERT_TRUE(planner.rebuild(fromDate));
+    ASSERT_TRUE(planner.getDemand(fromDate + 10).empty());
+
+    ASSERT_TRUE(db->createOrder(1, 2, fromDate, fromDate + 10, 3));
+    ASSERT_TRUE(db->createOrder(2, 1, fromDate, fromDate + 10, 1));
+    // Fulfilled before the planned range, so not counted
+    ASSERT_TRUE(db->createOrder(2, 1, fromDate - 5, fromDate - 1, 1));
+
+    ASSERT_EQ(planner.getDemand(fromDate + 10), expectedDemand(fromDate, fromDate + 10, fromDate + 10));
+    ASSERT_EQ(planner.getDemand(fromDate - 1).size(), 0);
+
+    // A fresh rebuild agrees with the incrementally maintained totals
+    DemandPlanner rebuilt(*db, 2);
+    ASSERT_TRUE(rebuilt.rebuild(fromDate));
+    ASSERT_EQ(rebuilt.getDemand(fromDate, fromDate + 30), planner.getDemand(fromDate, fromDate + 30));
+}
+
+// Test that orders created while rebuild() loads its data are neither lost nor counted twice
+TEST_F(DemandPlannerTest, OrdersDuringRebuildTest) {
+    // Cheap commits, so that orders land right between the planner's load and its update
+    delete db;
+    DatabaseOptions options;
+    options.synchronous = "OFF";
+    db = new Database(PLANNER_DB_PATH, options);
+    ASSERT_TRUE(db->connect());
+
+    int fromDate = 0;
+    ASSERT_TRUE(parseDate("2025-06-01", fromDate));
+    DemandPlanner planner(*db, 2);
+    ASSERT_TRUE(planner.rebuild(fromDate));
+
+    // Writers keep going until the rebuilds are over, so no later rebuild repairs what they lost
+    std::atomic<bool> rebuilt(false);
+    std::atomic<int> created(0);
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 3; w++) {
+        writers.emplace_back([&, w] {
+            for (int i = 0; !rebuilt || i < 10; i++) {
+                ASSERT_TRUE(db->createOrder(1 + i % 5, 1 + (i + w) % 3, fromDate, fromDate + i % 20, 1 + i % 4));
+                created++;
+            }
+        });
+    }
+    for (int i = 0; i < 30; i++) {
+        ASSERT_TRUE(planner.rebuild(fromDate));
+    }
+    rebuilt = true;
+    for (auto& writer : writers) {
+        writer.join();
+    }
+
+    ASSERT_EQ(db->getPendingOrders(fromDate).size(), static_cast<size_t>(created));
+    ASSERT_EQ(planner.getDemand(fromDate, fromDate + 30), expectedDemand(fromDate, fromDate, fromDate + 30));
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include "../includes/lru_cache.h"
+#include <string>
+
+// Test hits, misses and recency order
+TEST(LruCacheTest, EvictsLeastRecentlyUsedTest) {
+    LruCache<int, std::string> cache(2);
+    cache.put(1, "one");
+    cache.put(2, "two");
+
+    std::string value;
+    ASSERT_TRUE(cache.get(1, value));
+    ASSERT_EQ(value, "one");
+
+    // 2 is now the least recently used entry
+    cache.put(3, "three");
+    ASSERT_FALSE(cache.get(2, value));
+    ASSERT_TRUE(cache.get(1, value));
+    ASSERT_TRUE(cache.get(3, value));
+
+    LruCacheStats stats = cache.stats();
+    ASSERT_EQ(stats.hits, 3);
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.evictions, 1);
+    ASSERT_EQ(stats.entries, 2);
+}
+
+// Test that the cost budget bounds the cache
+TEST(LruCacheTest, CostBudgetTest) {
+    LruCache<std::string, int> cache(100);
+    cache.put("a", 1, 60);
+    cache.put("b", 2, 30);
+    ASSERT_EQ(cache.stats().cost, 90);
+
+    cache.put("c", 3, 50);
+    int value = 0;
+    ASSERT_FALSE(cache.get("a", value));
+    ASSERT_EQ(cache.stats().cost, 80);
+
+    // Entries larger than the whole budget are not cached
+    cache.put("huge", 4, 101);
+    ASSERT_FALSE(cache.get("huge", value));
+
+    cache.setCapacity(0);
+    ASSERT_EQ(cache.stats().entries, 0);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include "../includes/multi_shop_database.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+const std::vector<std::string> SHOP_DB_PATHS = {"test_shop_north.db", "test_shop_south.db", "test_shop_east.db"};
+
+class MultiShopDatabaseTest : public ::testing::Test {
+protected:
+    std::vector<MultiShopDatabase::Shop> shops;
+    int startDate;
+    int endDate;
+
+    void SetUp() override {
+        for (const auto& path : SHOP_DB_PATHS) {
+            std::ifstream src("flower.db", std::ios::binary);
+            std::ofstream dst(path, std::ios::binary);
+            dst << src.rdbuf();
+            shops.push_back({path.substr(10, path.size() - 13), path});
+        }
+        parseDate("2025-01-01", startDate);
+        parseDate("2025-12-31", endDate);
+
+        // Give the branches different trade so that their figures differ
+        int orderDate;
+        parseDate("2025-12-20", orderDate);
+        Database north(SHOP_DB_PATHS[0]);
+        ASSERT_TRUE(north.connect());
+        ASSERT_TRUE(north.createOrder(1, 1, orderDate, orderDate + 1, 3));
+        ASSERT_TRUE(north.createOrder(2, 2, orderDate, orderDate + 10, 2));
+        Database south(SHOP_DB_PATHS[1]);
+        ASSERT_TRUE(south.connect());
+        ASSERT_TRUE(south.createOrder(1, 2, orderDate, orderDate, 5));
+        Database east(SHOP_DB_PATHS[2]);
+        ASSERT_TRUE(east.connect());
+    }
+
+    void TearDown() override {
+        for (const auto& path : SHOP_DB_PATHS) {
+            std::remove(path.c_str());
+        }
+    }
+
+    // Each shop's report straight from its own connection
+    std::vector<std::unique_ptr<Database>> openShops() {
+        std::vector<std::unique_ptr<Database>> dbs;
+        for (const auto& shop : shops) {
+            dbs.push_back(std::make_unique<Database>(shop.path));
+            dbs.back()->connect();
+        }
+        return dbs;
+    }
+};
+
+// Test that the chain totals are the sums of the branches' own reports
+TEST_F(MultiShopDatabaseTest, MergedTotalsTest) {
+    MultiShopDatabase chain(shops);
+    ASSERT_TRUE(chain.connect());
+    ASSERT_EQ(chain.getShopCount(), 3u);
+    auto dbs = openShops();
+
+    auto revenue = chain.getTotalRevenue(startDate, endDate);
+    ASSERT_EQ(revenue.byShop.size(), 3u);
+    double sum = 0.0;
+    for (size_t i = 0; i < dbs.size(); i++) {
+        double shopRevenue = dbs[i]->getTotalRevenue(startDate, endDate);
+        ASSERT_DOUBLE_EQ(revenue.byShop[shops[i].name], shopRevenue);
+        sum += shopRevenue;
+    }
+    ASSERT_NEAR(revenue.total, sum, 1e-6);
+    ASSERT_GT(revenue.byShop["north"], revenue.byShop["east"]);
+
+    auto sales = chain.getCompositionSalesSummary();
+    for (const auto& [composition, total] : sales.total) {
+        int count = 0;
+        double amount = 0.0;
+        for (const auto& db : dbs) {
+            auto shopSales = db->getCompositionSalesSummary();
+            count += shopSales[composition].first;
+            amount += shopSales[composition].second;
+        }
+        ASSERT_EQ(total.first, count) << composition;
+        ASSERT_NEAR(total.second, amount, 1e-6) << composition;
+    }
+    ASSERT_EQ(sales.byShop["south"], dbs[1]->getCompositionSalesSummary());
+
+    auto usage = chain.getFlowerUsageByPeriod(startDate, endDate);
+    for (const auto& [flower, varieties] : usage.total) {
+        for (const auto& [variety, stems] : varieties) {
+            int expected = 0;
+            for (const auto& db : dbs) {
+                auto shopUsage = db->getFlowerUsageByPeriod(startDate, endDate);
+                expected += shopUsage[flower][variety];
+            }
+            ASSERT_EQ(stems, expected) << flower << " " << variety;
+        }
+    }
+}
+
+// Test that urgency counts are merged by rate and stay in rate order
+TEST_F(MultiShopDatabaseTest, UrgencyTest) {
+    MultiShopDatabase chain(shops);
+    ASSERT_TRUE(chain.connect());
+    auto dbs = openShops();
+
+    auto urgency = chain.getOrdersByUrgency();
+    std::map<int, int> expected;
+    for (const auto& db : dbs) {
+        for (const auto& [rate, count] : db->getOrdersByUrgency()) {
+            expected[rate] += count;
+        }
+    }
+    std::vector<std::pair<int, int>> expectedCounts(expected.begin(), expected.end());
+    ASSERT_EQ(urgency.total, expectedCounts);
+}
+
+// Test that the chain series adds up bucket by bucket and weights the surcharge by revenue
+TEST_F(MultiShopDatabaseTest, RevenueSeriesTest) {
+    MultiShopDatabase chain(shops);
+    ASSERT_TRUE(chain.connect());
+    auto dbs = openShops();
+
+    auto series = chain.getRevenueSeries(startDate, endDate, Database::Granularity::Month);
+    ASSERT_EQ(series.total.size(), 12u);
+    for (size_t b = 0; b < series.total.size(); b++) {
+        double revenue = 0.0;
+        double fees = 0.0;
+        int orders = 0;
+        for (const auto& db : dbs) {
+            auto bucket = db->getRevenueSeries(startDate, endDate, Database::Granularity::Month)[b];
+            revenue += bucket.revenue;
+            fees += bucket.urgencyFeeShare * bucket.revenue;
+            orders += bucket.orderCount;
+        }
+        ASSERT_NEAR(series.total[b].revenue, revenue, 1e-6);
+        ASSERT_EQ(series.total[b].orderCount, orders);
+        ASSERT_NEAR(series.total[b].urgencyFeeShare, revenue > 0.0 ? fees / revenue : 0.0, 1e-9);
+    }
+    ASSERT_GT(series.total.back().urgencyFeeShare, 0.0);
+}
+
+// Test that a branch that cannot be opened fails the chain's connect
+TEST_F(MultiShopDatabaseTest, MissingShopTest) {
+    DatabaseOptions options;
+    options.readOnly = true;
+    std::vector<MultiShopDatabase::Shop> withMissing = shops;
+    withMissing.push_back({"west", "test_shop_missing.db"});
+    MultiShopDatabase chain(withMissing, options);
+    ASSERT_FALSE(chain.connect());
+}
+
+// Test that two shops with the same name are refused rather than merged into one report entry
+TEST_F(MultiShopDatabaseTest, DuplicateShopNameTest) {
+    std::vector<MultiShopDatabase::Shop> withDuplicate = shops;
+    withDuplicate.push_back({shops[0].name, shops[1].path});
+    MultiShopDatabase chain(withDuplicate);
+    ASSERT_FALSE(chain.connect());
+}
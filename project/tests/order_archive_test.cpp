@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sqlite3.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+const std::string ARCHIVE_DB_PATH = "test_archive_flower.db";
+const std::vector<std::string> ARCHIVE_FILES = {"test_archive_flower.orders-2023.db",
+                                                "test_archive_flower.orders-2024.db"};
+
+// Everything the order reports return, to compare before and after archiving
+struct ReportState {
+    double revenue;
+    std::vector<Database::RevenueBucket> series;
+    std::vector<std::pair<int, int>> urgency;
+    std::map<std::string, std::map<std::string, int>> usage;
+    std::vector<std::tuple<std::string, std::string, int>> usageTable;
+    std::map<std::string, std::pair<int, double>> sales;
+    int mostPopular;
+    std::vector<int> pagedIds;
+    size_t ordersInRange;
+    size_t pending;
+};
+
+class OrderArchiveTest : public ::testing::Test {
+protected:
+    Database* db;
+    int firstDay;
+    int lastDay;
+    int archivedOrderId;
+
+    static int day(const std::string& text) {
+        int days = 0;
+        parseDate(text, days);
+        return days;
+    }
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(ARCHIVE_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(ARCHIVE_DB_PATH);
+        ASSERT_TRUE(db->connect());
+        db->setReportCacheBudget(0);
+        firstDay = day("2023-01-01");
+        lastDay = day("2025-12-31");
+
+        // Two closed years of trade next to the 2025 orders of the seed database
+        for (int i = 0; i < 12; i++) {
+            int date = day("2023-02-01") + i * 29;
+            ASSERT_TRUE(db->createOrder(1 + i % 5, 1 + i % 3, date, date + i % 4, 1 + i % 2));
+            ASSERT_TRUE(db->createOrder(1 + i % 4, 1 + i % 5, date + 365, date + 366, 2));
+        }
+        archivedOrderId = db->getOrdersByDate(day("2023-02-01"))[0].id;
+    }
+
+    void TearDown() override {
+        delete db;
+        std::remove(ARCHIVE_DB_PATH.c_str());
+        for (const auto& file : ARCHIVE_FILES) {
+            std::remove(file.c_str());
+        }
+    }
+
+    ReportState reports(Database& source) {
+        ReportState state;
+        state.revenue = source.getTotalRevenue(firstDay, lastDay);
+        state.series = source.getRevenueSeries(firstDay, lastDay, Database::Granularity::Month);
+        state.urgency = source.getOrdersByUrgency();
+        state.usage = source.getFlowerUsageByPeriod(firstDay, lastDay);
+        for (const auto& row : source.getFlowerUsageTable(firstDay, lastDay).rows) {
+            state.usageTable.emplace_back(std::string(row.flowerName), std::string(row.variety), row.quantity);
+        }
+        state.sales = source.getCompositionSalesSummary();
+        state.mostPopular = source.getMostPopularComposition().id;
+        Database::PageCursor cursor;
+        for (;;) {
+            auto page = source.getOrdersPage(cursor, 7);
+            for (const auto& order : page.rows) {
+                state.pagedIds.push_back(order.id);
+            }
+            if (!page.hasMore) {
+                break;
+            }
+            cursor = page.next;
+        }
+        state.ordersInRange = source.getOrdersByDateRange(day("2023-06-01"), day("2024-06-30")).size();
+        state.pending = source.getPendingOrders(firstDay).size();
+        return state;
+    }
+
+    void expectSameReports(const ReportState& expected, const ReportState& actual) {
+        EXPECT_NEAR(actual.revenue, expected.revenue, 1e-6);
+        ASSERT_EQ(actual.series.size(), expected.series.size());
+        for (size_t i = 0; i < expected.series.size(); i++) {
+            EXPECT_NEAR(actual.series[i].revenue, expected.series[i].revenue, 1e-6);
+            EXPECT_EQ(actual.series[i].orderCount, expected.series[i].orderCount);
+            EXPECT_NEAR(actual.series[i].urgencyFeeShare, expected.series[i].urgencyFeeShare, 1e-9);
+        }
+        EXPECT_EQ(actual.urgency, expected.urgency);
+        EXPECT_EQ(actual.usage, expected.usage);
+        EXPECT_EQ(actual.usageTable, expected.usageTable);
+        EXPECT_EQ(actual.sales.size(), expected.sales.size());
+        for (const auto& [composition, sales] : expected.sales) {
+            EXPECT_EQ(actual.sales.at(composition).first, sales.first);
+            EXPECT_NEAR(actual.sales.at(composition).second, sales.second, 1e-6);
+        }
+        EXPECT_EQ(actual.mostPopular, expected.mostPopular);
+        EXPECT_EQ(actual.pagedIds, expected.pagedIds);
+        EXPECT_EQ(actual.ordersInRange, expected.ordersInRange);
+        EXPECT_EQ(actual.pending, expected.pending);
+    }
+
+    static long long countHotOrders() {
+        long long count = -1;
+        sqlite3* handle = nullptr;
+        sqlite3_open_v2(ARCHIVE_DB_PATH.c_str(), &handle, SQLITE_OPEN_READONLY, nullptr);
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(handle, "SELECT COUNT(*) FROM Orders", -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW) {
+            count = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(handle);
+        return count;
+    }
+};
+
+// Test that every order report gives the same answer once closed years are archived
+TEST_F(OrderArchiveTest, SameReportsTest) {
+    ReportState before = reports(*db);
+    Database::OrderSummary summary = db->getOrderSummary(archivedOrderId);
+    long long hotOrders = countHotOrders();
+
+    ASSERT_TRUE(db->archiveYear(2023));
+    ASSERT_TRUE(db->archiveYear(2024));
+    ASSERT_EQ(countHotOrders(), hotOrders - 24);
+
+    auto archives = db->getOrderArchives();
+    ASSERT_EQ(archives.size(), 2u);
+    ASSERT_EQ(archives[0].year, 2023);
+    ASSERT_EQ(archives[0].fileName, ARCHIVE_FILES[0]);
+    ASSERT_EQ(archives[0].orderCount, 12);
+    ASSERT_EQ(archives[0].firstOrderDate, day("2023-02-01"));
+    ASSERT_LE(archives[0].firstOrderId, archivedOrderId);
+
+    expectSameReports(before, reports(*db));
+    ASSERT_DOUBLE_EQ(db->getOrderSummary(archivedOrderId).totalPrice, summary.totalPrice);
+    ASSERT_EQ(db->getOrdersByDate(day("2023-02-01"))[0].id, archivedOrderId);
+
+    // A reader, and reports served from a snapshot, see the same
+    DatabaseOptions readOnly;
+    readOnly.readOnly = true;
+    Database reader(ARCHIVE_DB_PATH, readOnly);
+    ASSERT_TRUE(reader.connect());
+    reader.setReportCacheBudget(0);
+    expectSameReports(before, reports(reader));
+
+    ASSERT_TRUE(db->enableReportSnapshot(3600, 0));
+    expectSameReports(before, reports(*db));
+}
+
+// Test that a snapshot taken before archiving still holds the orders and does not count them twice
+TEST_F(OrderArchiveTest, SnapshotBeforeArchiveTest) {
+    double revenue = db->getTotalRevenue(firstDay, lastDay);
+    ASSERT_TRUE(db->enableReportSnapshot(3600, 0));
+    ASSERT_TRUE(db->archiveYear(2023));
+    ASSERT_NEAR(db->getTotalRevenue(firstDay, lastDay), revenue, 1e-6);
+    ASSERT_TRUE(db->refreshReportSnapshot());
+    ASSERT_NEAR(db->getTotalRevenue(firstDay, lastDay), revenue, 1e-6);
+}
+
+// Test that queries only open the archives overlapping their range
+TEST_F(OrderArchiveTest, RoutingTest) {
+    double revenue2025 = db->getTotalRevenue(day("2025-01-01"), lastDay);
+    double revenue2024 = db->getTotalRevenue(day("2024-01-01"), day("2024-12-31"));
+    ASSERT_GT(revenue2024, 0.0);
+    ASSERT_TRUE(db->archiveYear(2023));
+    ASSERT_TRUE(db->archiveYear(2024));
+    db->disconnect();
+
+    // With the 2023 archive gone, anything not reaching back to 2023 still works
+    std::rename(ARCHIVE_FILES[0].c_str(), "test_archive_moved.db");
+    ASSERT_TRUE(db->connect());
+    ASSERT_NEAR(db->getTotalRevenue(day("2025-01-01"), lastDay), revenue2025, 1e-6);
+    ASSERT_NEAR(db->getTotalRevenue(day("2024-01-01"), day("2024-12-31")), revenue2024, 1e-6);
+    ASSERT_EQ(db->getOrdersByDate(day("2024-02-01")).size(), 1u);
+    ASSERT_TRUE(db->getOrdersByDate(day("2023-02-01")).empty());
+    std::rename("test_archive_moved.db", ARCHIVE_FILES[0].c_str());
+}
+
+// Test that only closed, fully fulfilled years that are not archived yet can be archived
+TEST_F(OrderArchiveTest, ArchiveRulesTest) {
+    int year, month, dayOfMonth;
+    civilFromDays(currentDay(), year, month, dayOfMonth);
+    ASSERT_FALSE(db->archiveYear(year));
+    ASSERT_FALSE(db->archiveYear(2019));
+
+    // An order for 2022 due today keeps the year open
+    ASSERT_TRUE(db->createOrder(1, 1, day("2022-12-30"), currentDay(), 1));
+    ASSERT_FALSE(db->archiveYear(2022));
+
+    ASSERT_TRUE(db->archiveYear(2023));
+    ASSERT_FALSE(db->archiveYear(2023));
+    ASSERT_EQ(db->getOrderArchives().size(), 1u);
+
+    DatabaseOptions readOnly;
+    readOnly.readOnly = true;
+    Database reader(ARCHIVE_DB_PATH, readOnly);
+    ASSERT_TRUE(reader.connect());
+    ASSERT_FALSE(reader.archiveYear(2024));
+}
+
+// Test that orders entered for an archived year stay in the hot file and are counted once
+TEST_F(OrderArchiveTest, LateOrderTest) {
+    ASSERT_TRUE(db->archiveYear(2023));
+    double revenue = db->getTotalRevenue(firstDay, day("2023-12-31"));
+    size_t orders = db->getOrdersByDate(day("2023-02-01")).size();
+
+    ASSERT_TRUE(db->createOrder(2, 2, day("2023-02-01"), day("2023-02-05"), 1));
+    ASSERT_EQ(db->getOrdersByDate(day("2023-02-01")).size(), orders + 1);
+    double late = db->getOrderSummary(db->getOrdersByDate(day("2023-02-01")).back().id).totalPrice;
+    ASSERT_GT(late, 0.0);
+    ASSERT_NEAR(db->getTotalRevenue(firstDay, day("2023-12-31")), revenue + late, 1e-6);
+    ASSERT_EQ(db->getOrderArchives()[0].orderCount, 12);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "../includes/order_journal.h"
+#include "../includes/date_utils.h"
+#include <cstdio>
+#include <fstream>
+#include <sqlite3.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::string JOURNAL_DB_PATH = "journal_test_flower.db";
+const std::string JOURNAL_REPLAY_DB_PATH = "journal_test_replay.db";
+const std::string JOURNAL_PATH = "journal_test.journal";
+
+static void copyFile(const std::string& from, const std::string& to) {
+    std::ifstream src(from, std::ios::binary);
+    std::ofstream dst(to, std::ios::binary);
+    dst << src.rdbuf();
+}
+
+class OrderJournalTest : public ::testing::Test {
+protected:
+    int day = 0;
+
+    void SetUp() override {
+        copyFile("flower.db", JOURNAL_DB_PATH);
+        copyFile("flower.db", JOURNAL_REPLAY_DB_PATH);
+        std::remove(JOURNAL_PATH.c_str());
+        parseDate("2025-09-01", day);
+    }
+
+    void TearDown() override {
+        std::remove(JOURNAL_DB_PATH.c_str());
+        std::remove(JOURNAL_REPLAY_DB_PATH.c_str());
+        std::remove(JOURNAL_PATH.c_str());
+    }
+
+    static size_t orderCount(const std::string& dbPath, int date) {
+        Database db(dbPath);
+        db.connect();
+        return db.getOrdersByDate(date).size();
+    }
+};
+
+// Test that orders submitted from several threads all reach the database
+TEST_F(OrderJournalTest, ConcurrentSubmitTest) {
+    OrderJournal journal(JOURNAL_PATH, JOURNAL_DB_PATH);
+    ASSERT_TRUE(journal.open());
+
+    std::vector<std::thread> clerks;
+    for (int t = 0; t < 8; t++) {
+        clerks.emplace_back([&, t] {
+            for (int i = 0; i < 25; i++) {
+                ASSERT_TRUE(journal.submit({1 + t % 5, 1 + i % 5, day, day + 3, 1}));
+            }
+        });
+    }
+    for (auto& clerk : clerks) {
+        clerk.join();
+    }
+
+    ASSERT_EQ(journal.getDurableSequence(), 200);
+    journal.waitUntilApplied();
+    ASSERT_EQ(journal.getAppliedSequence(), 200);
+    ASSERT_EQ(orderCount(JOURNAL_DB_PATH, day), 200);
+
+    // Invalid orders are refused up front
+    ASSERT_FALSE(journal.submit({1, 1, day, day - 1, 1}));
+    ASSERT_FALSE(journal.submit({1, 1, day, day, 0}));
+    ASSERT_FALSE(journal.submit({999999, 1, day, day, 1}));
+    ASSERT_FALSE(journal.submit({1, 999999, day, day, 1}));
+    journal.close();
+    ASSERT_FALSE(journal.submit({1, 1, day, day, 1}));
+}
+
+// Test that a constraint failure skips one order, while any other failure applies nothing
+// and leaves the sequence for a retry
+TEST_F(OrderJournalTest, ApplyFailureTest) {
+    Database db(JOURNAL_DB_PATH);
+    ASSERT_TRUE(db.connect());
+    uint64_t applied = db.getAppliedJournalSequence();
+    sqlite3* handle = nullptr;
+    ASSERT_EQ(sqlite3_open(JOURNAL_DB_PATH.c_str(), &handle), SQLITE_OK);
+    // Quantity 66 breaks a constraint; 77 asks for a blob over SQLite's length limit
+    ASSERT_EQ(sqlite3_exec(handle,
+                           "CREATE TRIGGER RejectOrder BEFORE INSERT ON Orders WHEN NEW.Quantity = 66 "
+                           "BEGIN SELECT RAISE(ABORT, 'rejected'); END;"
+                           "CREATE TRIGGER FailOrder BEFORE INSERT ON Orders WHEN NEW.Quantity = 77 "
+                           "BEGIN SELECT randomblob(2000000000); END;",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+
+    ASSERT_TRUE(db.applyJournaledOrders({{1, 1, day, day + 1, 1}, {1, 1, day, day + 1, 66}}, applied + 2));
+    ASSERT_EQ(db.getAppliedJournalSequence(), applied + 2);
+    ASSERT_EQ(db.getOrdersByDate(day).size(), 1u);
+
+    std::vector<Database::NewOrder> batch = {{1, 1, day, day + 1, 1}, {1, 1, day, day + 1, 77}, {1, 1, day, day + 1, 1}};
+    ASSERT_FALSE(db.applyJournaledOrders(batch, applied + 5));
+    ASSERT_EQ(db.getAppliedJournalSequence(), applied + 2);
+    ASSERT_EQ(db.getOrdersByDate(day).size(), 1u);
+
+    // Once the cause is gone the same batch goes through
+    ASSERT_EQ(sqlite3_exec(handle, "DROP TRIGGER FailOrder", nullptr, nullptr, nullptr), SQLITE_OK);
+    sqlite3_close(handle);
+    ASSERT_TRUE(db.applyJournaledOrders(batch, applied + 5));
+    ASSERT_EQ(db.getAppliedJournalSequence(), applied + 5);
+    ASSERT_EQ(db.getOrdersByDate(day).size(), 4u);
+}
+
+// Test that reopening does not apply entries twice, and that a database that never saw
+// the entries gets them from the journal
+TEST_F(OrderJournalTest, ReplayTest) {
+    {
+        OrderJournal journal(JOURNAL_PATH, JOURNAL_DB_PATH);
+        ASSERT_TRUE(journal.open());
+        for (int i = 0; i < 5; i++) {
+            ASSERT_TRUE(journal.submit({1, 1, day, day + 1, 2}));
+        }
+    }
+    ASSERT_EQ(orderCount(JOURNAL_DB_PATH, day), 5);
+
+    {
+        OrderJournal journal(JOURNAL_PATH, JOURNAL_DB_PATH);
+        ASSERT_TRUE(journal.open());
+        ASSERT_EQ(journal.getAppliedSequence(), 5);
+    }
+    ASSERT_EQ(orderCount(JOURNAL_DB_PATH, day), 5);
+
+    // As if the process had died right after acknowledging the orders
+    {
+        OrderJournal journal(JOURNAL_PATH, JOURNAL_REPLAY_DB_PATH);
+        ASSERT_TRUE(journal.open());
+        ASSERT_EQ(journal.getAppliedSequence(), 5);
+    }
+    ASSERT_EQ(orderCount(JOURNAL_REPLAY_DB_PATH, day), 5);
+}
+
+// Test that a partially written record at the end is discarded
+TEST_F(OrderJournalTest, TornTailTest) {
+    {
+        OrderJournal journal(JOURNAL_PATH, JOURNAL_DB_PATH);
+        ASSERT_TRUE(journal.open());
+        ASSERT_TRUE(journal.submit({2, 2, day, day + 2, 1}));
+    }
+    {
+        std::ofstream journalFile(JOURNAL_PATH, std::ios::binary | std::ios::app);
+        journalFile << "partial record";
+    }
+
+    OrderJournal journal(JOURNAL_PATH, JOURNAL_REPLAY_DB_PATH);
+    ASSERT_TRUE(journal.open());
+    ASSERT_TRUE(journal.submit({2, 2, day, day + 2, 1}));
+    journal.waitUntilApplied();
+    ASSERT_EQ(journal.getAppliedSequence(), 2);
+    ASSERT_EQ(orderCount(JOURNAL_REPLAY_DB_PATH, day), 2);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "../includes/password_hash.h"
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cheap parameters so the tests stay fast
+static PasswordHashParams testParams(int logN = 8) {
+    PasswordHashParams params;
+    params.logN = logN;
+    params.r = 8;
+    params.p = 1;
+    return params;
+}
+
+static std::string hex(const std::vector<uint8_t>& bytes) {
+    std::string text;
+    char buffer[3];
+    for (uint8_t byte : bytes) {
+        std::snprintf(buffer, sizeof(buffer), "%02x", byte);
+        text += buffer;
+    }
+    return text;
+}
+
+// Test the scrypt test vectors of RFC 7914, section 12
+TEST(PasswordHashTest, Rfc7914VectorsTest) {
+    std::vector<uint8_t> key;
+    PasswordHashParams params;
+    params.logN = 4;
+    params.r = 1;
+    params.p = 1;
+    ASSERT_TRUE(PasswordHasher::scrypt("", "", params, 64, key));
+    ASSERT_EQ(hex(key), "77d6576238657b203b19ca42c18a0497f16b4844e3074ae8dfdffa3fede21442"
+                        "fcd0069ded0948f8326a753a0fc81f17e8d3e0fb2e0d3628cf35e20c38d18906");
+
+    params.logN = 10;
+    params.r = 8;
+    params.p = 16;
+    ASSERT_TRUE(PasswordHasher::scrypt("password", "NaCl", params, 64, key));
+    ASSERT_EQ(hex(key), "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b373162"
+                        "2eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640");
+
+    params.logN = 30;
+    ASSERT_FALSE(PasswordHasher::scrypt("password", "NaCl", params, 64, key));
+}
+
+// Test the hash format, salting and verification
+TEST(PasswordHashTest, HashAndVerifyTest) {
+    PasswordHasher hasher(testParams());
+    std::string first = hasher.hash("rose123");
+    std::string second = hasher.hash("rose123");
+
+    ASSERT_EQ(first.rfind("$scrypt$v=1$ln=8,r=8,p=1$", 0), 0u);
+    ASSERT_NE(first, second);
+    ASSERT_TRUE(hasher.verify("rose123", first));
+    ASSERT_TRUE(hasher.verify("rose123", second));
+    ASSERT_FALSE(hasher.verify("rose124", first));
+    ASSERT_FALSE(hasher.verify("", first));
+    ASSERT_FALSE(hasher.needsRehash(first));
+
+    // Malformed or foreign hashes never verify
+    ASSERT_FALSE(hasher.verify("rose123", ""));
+    ASSERT_FALSE(hasher.verify("rose123", "1234567890"));
+    ASSERT_FALSE(hasher.verify("rose123", "$scrypt$v=2" + first.substr(11)));
+    ASSERT_FALSE(hasher.verify("rose123", first.substr(0, first.rfind('$'))));
+    ASSERT_TRUE(hasher.needsRehash("1234567890"));
+}
+
+// Test that hashes keep their own cost and report when they are out of date
+TEST(PasswordHashTest, RehashTest) {
+    PasswordHasher oldHasher(testParams(6));
+    PasswordHasher newHasher(testParams(8));
+    std::string stored = oldHasher.hash("tulip");
+
+    ASSERT_TRUE(newHasher.verify("tulip", stored));
+    ASSERT_TRUE(newHasher.needsRehash(stored));
+    ASSERT_FALSE(newHasher.needsRehash(newHasher.hash("tulip")));
+}
+
+// Test that concurrent evaluations stay within the limit
+TEST(PasswordHashTest, ConcurrencyLimitTest) {
+    PasswordHasher hasher(testParams(10), 2);
+    std::string stored = hasher.hash("lily");
+
+    std::vector<std::thread> threads;
+    std::vector<int> results(8, 0);
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&, i] { results[i] = hasher.verify("lily", stored) ? 1 : 0; });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int result : results) {
+        ASSERT_EQ(result, 1);
+    }
+    ASSERT_GE(hasher.peakConcurrent(), 1u);
+    ASSERT_LE(hasher.peakConcurrent(), 2u);
+}
+
+// Test that calibration picks a cost within range that grows with the target
+TEST(PasswordHashTest, CalibrateTest) {
+    PasswordHashParams low = PasswordHasher::calibrate(0.0, 8, 12);
+    ASSERT_EQ(low.logN, 10);
+
+    PasswordHashParams high = PasswordHasher::calibrate(1e9, 8, 12);
+    ASSERT_EQ(high.logN, 12);
+    ASSERT_EQ(high.r, 8);
+    ASSERT_EQ(high.p, 1);
+}
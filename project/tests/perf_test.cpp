@@ -0,0 +1,325 @@
+#include <gtest/gtest.h>
+#include "../includes/backup_manager.h"
+#include "../includes/columnar_archive.h"
+#include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include "../bench/order_generator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sqlite3.h>
+#include <vector>
+
+// Latency budgets for key operations on a large generated database, plus checks that
+// their queries are answered through indexes. Budgets are read from perf_budgets.conf.
+// The generated database is kept between runs and rebuilt when the order count changes.
+
+const std::string PERF_BUDGETS_PATH = "perf_budgets.conf";
+const std::string PERF_DB_PATH = "perf_orders.db";
+const std::string PERF_SCRATCH_DB_PATH = "perf_scratch.db";
+const std::string PERF_COLUMNAR_PATH = "perf_orders.col";
+
+// Tables that are too large to be scanned by any of the measured operations, with the
+// aliases the queries use for them
+const std::vector<std::string> LARGE_TABLES = {"Orders", "o", "OrderSummary", "os"};
+
+static std::map<std::string, double> loadBudgets() {
+    std::map<std::string, double> budgets;
+    std::ifstream file(PERF_BUDGETS_PATH);
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        size_t separator = line.find('=');
+        if (separator == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, separator);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        budgets[key] = std::stod(line.substr(separator + 1));
+    }
+    return budgets;
+}
+
+static double medianMs(int runs, const std::function<void()>& operation) {
+    std::vector<double> times;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        operation();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+class PerfTest : public ::testing::Test {
+protected:
+    static std::map<std::string, double> budgets;
+    static int firstDay;
+    static int lastDay;
+    Database* db;
+
+    static void SetUpTestSuite() {
+        budgets = loadBudgets();
+        GeneratorConfig config;
+        config.orderCount = static_cast<int>(budgets["order_count"]);
+        config.customerCount = static_cast<int>(budgets["customer_count"]);
+        firstDay = config.firstDay;
+        lastDay = config.firstDay + config.dayCount - 1;
+
+        // Seed orders come along with the catalog
+        if (countOrders(PERF_DB_PATH) != config.orderCount + countOrders("flower.db")) {
+            std::cout << "Generating " << PERF_DB_PATH << " with " << config.orderCount << " orders" << std::endl;
+            ASSERT_TRUE(generateShopDatabase("flower.db", PERF_DB_PATH, config));
+        }
+    }
+
+    static long long countOrders(const std::string& path) {
+        long long count = -1;
+        sqlite3* handle = nullptr;
+        if (sqlite3_open_v2(path.c_str(), &handle, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+            sqlite3_stmt* stmt = nullptr;
+            if (sqlite3_prepare_v2(handle, "SELECT COUNT(*) FROM Orders", -1, &stmt, nullptr) == SQLITE_OK &&
+                sqlite3_step(stmt) == SQLITE_ROW) {
+                count = sqlite3_column_int64(stmt, 0);
+            }
+            sqlite3_finalize(stmt);
+        }
+        sqlite3_close(handle);
+        return count;
+    }
+
+    void SetUp() override {
+        ASSERT_FALSE(budgets.empty()) << "can't read " << PERF_BUDGETS_PATH;
+        db = new Database(PERF_DB_PATH);
+        ASSERT_TRUE(db->connect());
+        db->setReportCacheBudget(0);
+    }
+
+    void TearDown() override {
+        delete db;
+    }
+
+    // Runs the operation with statement tracing on and checks every query plan
+    void expectIndexedPlans(const std::string& name, const std::function<void()>& operation,
+                            const std::string& requiredIndex) {
+        db->setStatementTracing(true);
+        operation();
+        db->setStatementTracing(false);
+
+        bool indexUsed = false;
+        for (const auto& statement : db->takeTracedStatements()) {
+            for (const auto& detail : db->explainQueryPlan(statement)) {
+                indexUsed = indexUsed || detail.find(requiredIndex) != std::string::npos;
+                if (detail.compare(0, 5, "SCAN ") != 0) {
+                    continue;
+                }
+                std::string table = detail.substr(5, detail.find(' ', 5) - 5);
+                bool large = std::find(LARGE_TABLES.begin(), LARGE_TABLES.end(), table) != LARGE_TABLES.end();
+                EXPECT_FALSE(large && detail.find("INDEX") == std::string::npos)
+                    << name << " scans " << table << ": " << detail << "\n  in: " << statement;
+            }
+        }
+        EXPECT_TRUE(indexUsed) << name << " does not use " << requiredIndex;
+    }
+
+    void expectWithinBudget(const std::string& name, const std::string& budgetKey, double measuredMs) {
+        double budget = budgets[budgetKey];
+        std::cout << name << ": " << measuredMs << " ms (budget " << budget << " ms)" << std::endl;
+        EXPECT_LE(measuredMs, budget) << name << " took " << measuredMs << " ms, budget is " << budget << " ms";
+    }
+};
+
+std::map<std::string, double> PerfTest::budgets;
+int PerfTest::firstDay = 0;
+int PerfTest::lastDay = 0;
+
+// Test looking up one day's orders
+TEST_F(PerfTest, OrdersByDateTest) {
+    int date = firstDay + (lastDay - firstDay) / 2;
+    ASSERT_FALSE(db->getOrdersByDate(date).empty());
+    expectWithinBudget("getOrdersByDate", "orders_by_date_ms", medianMs(20, [&] { db->getOrdersByDate(date); }));
+    expectIndexedPlans("getOrdersByDate", [&] { db->getOrdersByDate(date); }, "idx_orders_orderdate");
+}
+
+// Test revenue over one month
+TEST_F(PerfTest, TotalRevenueTest) {
+    int start = firstDay + 400;
+    ASSERT_GT(db->getTotalRevenue(start, start + 30), 0.0);
+    expectWithinBudget("getTotalRevenue", "total_revenue_month_ms",
+                       medianMs(10, [&] { db->getTotalRevenue(start, start + 30); }));
+    expectIndexedPlans("getTotalRevenue", [&] { db->getTotalRevenue(start, start + 30); }, "idx_orders_orderdate");
+}
+
+// Test flower usage over one month
+TEST_F(PerfTest, FlowerUsageTest) {
+    int start = firstDay + 400;
+    ASSERT_FALSE(db->getFlowerUsageByPeriod(start, start + 30).empty());
+    expectWithinBudget("getFlowerUsageByPeriod", "flower_usage_month_ms",
+                       medianMs(10, [&] { db->getFlowerUsageByPeriod(start, start + 30); }));
+    expectIndexedPlans("getFlowerUsageByPeriod", [&] { db->getFlowerUsageByPeriod(start, start + 30); },
+                       "idx_orders_orderdate");
+}
+
+// Test order entry throughput, each order in its own durable transaction
+TEST_F(PerfTest, CreateOrderThroughputTest) {
+    delete db;
+    db = nullptr;
+    ASSERT_TRUE(copyFile(PERF_DB_PATH, PERF_SCRATCH_DB_PATH));
+    {
+        Database scratch(PERF_SCRATCH_DB_PATH);
+        ASSERT_TRUE(scratch.connect());
+
+        const int ORDERS = 200;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ORDERS; i++) {
+            ASSERT_TRUE(scratch.createOrder(1 + i % 5, 1 + i % 5, lastDay, lastDay + 2, 1));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double perSecond = ORDERS / seconds;
+        double budget = budgets["create_order_min_per_sec"];
+        std::cout << "createOrder: " << perSecond << " orders/s (budget >= " << budget << ")" << std::endl;
+        EXPECT_GE(perSecond, budget) << "createOrder managed " << perSecond << " orders/s, budget is " << budget;
+    }
+    std::remove(PERF_SCRATCH_DB_PATH.c_str());
+    db = new Database(PERF_DB_PATH);
+}
+
+// Test that the composition sales summary costs what the new orders cost, not all history
+TEST_F(PerfTest, CompositionSalesRefreshTest) {
+    delete db;
+    ASSERT_TRUE(copyFile(PERF_DB_PATH, PERF_SCRATCH_DB_PATH));
+    db = new Database(PERF_SCRATCH_DB_PATH);
+    ASSERT_TRUE(db->connect());
+    db->setReportCacheBudget(0);
+    ASSERT_FALSE(db->getCompositionSalesSummary().empty());
+
+    auto addOrders = [&](int round) {
+        for (int i = 0; i < 100; i++) {
+            db->createOrder(1 + i % 5, 1 + i % 5, lastDay, lastDay + 2 + round, 1);
+        }
+    };
+    std::vector<double> times;
+    for (int round = 0; round < 5; round++) {
+        addOrders(round);
+        times.push_back(medianMs(1, [&] { db->getCompositionSalesSummary(); }));
+    }
+    std::sort(times.begin(), times.end());
+    expectWithinBudget("getCompositionSalesSummary after 100 orders", "composition_sales_refresh_ms", times[2]);
+
+    addOrders(5);
+    expectIndexedPlans("getCompositionSalesSummary", [&] { db->getCompositionSalesSummary(); },
+                       "INTEGER PRIMARY KEY");
+
+    delete db;
+    std::remove(PERF_SCRATCH_DB_PATH.c_str());
+    db = new Database(PERF_DB_PATH);
+}
+
+// Test that once older years are archived, month reports on the hot file and on an archive
+// both stay within the month budget and match the unarchived database
+TEST_F(PerfTest, ArchivedRangeTest) {
+    int year, month, dayOfMonth;
+    civilFromDays(lastDay, year, month, dayOfMonth);
+    int recentStart = lastDay - 60;
+    int archivedStart = firstDay + 400;
+    double recentRevenue = db->getTotalRevenue(recentStart, recentStart + 30);
+    double archivedRevenue = db->getTotalRevenue(archivedStart, archivedStart + 30);
+    delete db;
+
+    ASSERT_TRUE(copyFile(PERF_DB_PATH, PERF_SCRATCH_DB_PATH));
+    db = new Database(PERF_SCRATCH_DB_PATH);
+    ASSERT_TRUE(db->connect());
+    db->setReportCacheBudget(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int archived = year - 3; archived < year; archived++) {
+        ASSERT_TRUE(db->archiveYear(archived));
+    }
+    std::cout << "archiveYear x3: "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+              << " ms" << std::endl;
+
+    ASSERT_NEAR(db->getTotalRevenue(recentStart, recentStart + 30), recentRevenue, 1e-6 * recentRevenue);
+    ASSERT_NEAR(db->getTotalRevenue(archivedStart, archivedStart + 30), archivedRevenue, 1e-6 * archivedRevenue);
+    expectWithinBudget("getTotalRevenue (hot file)", "total_revenue_month_ms",
+                       medianMs(10, [&] { db->getTotalRevenue(recentStart, recentStart + 30); }));
+    expectWithinBudget("getTotalRevenue (archive)", "total_revenue_month_ms",
+                       medianMs(10, [&] { db->getTotalRevenue(archivedStart, archivedStart + 30); }));
+    expectIndexedPlans("getTotalRevenue", [&] { db->getTotalRevenue(recentStart, recentStart + 30); },
+                       "idx_orders_orderdate");
+
+    auto archives = db->getOrderArchives();
+    delete db;
+    std::remove(PERF_SCRATCH_DB_PATH.c_str());
+    for (const auto& archive : archives) {
+        std::remove(archive.fileName.c_str());
+    }
+    db = new Database(PERF_DB_PATH);
+}
+
+// Test that order entry stays fast while the database is being backed up
+TEST_F(PerfTest, BackupOrderLatencyTest) {
+    delete db;
+    db = nullptr;
+    const std::string backupPath = "perf_backup.db";
+    ASSERT_TRUE(copyFile(PERF_DB_PATH, PERF_SCRATCH_DB_PATH));
+    {
+        DatabaseOptions options = DatabaseOptions::counterTerminal();
+        options.autoCheckpoint = false;
+        Database scratch(PERF_SCRATCH_DB_PATH, options);
+        ASSERT_TRUE(scratch.connect());
+
+        BackupManager backups(PERF_SCRATCH_DB_PATH);
+        ASSERT_TRUE(backups.start());
+        ASSERT_TRUE(backups.startBackup(backupPath));
+        std::vector<double> times;
+        while (backups.getStatus().state == BackupManager::State::Running) {
+            auto start = std::chrono::steady_clock::now();
+            ASSERT_TRUE(scratch.createOrder(1 + times.size() % 5, 1 + times.size() % 5, lastDay, lastDay + 2, 1));
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        ASSERT_TRUE(backups.waitForBackup());
+        BackupManager::Status status = backups.getStatus();
+        std::cout << "backup of " << status.pageCount << " pages: " << status.elapsedMs << " ms, "
+                  << times.size() << " orders meanwhile" << std::endl;
+
+        std::sort(times.begin(), times.end());
+        ASSERT_GE(times.size(), 20u);
+        expectWithinBudget("createOrder p99 during backup", "create_order_during_backup_p99_ms",
+                           times[times.size() * 99 / 100]);
+    }
+    for (const std::string& path : {PERF_SCRATCH_DB_PATH, backupPath}) {
+        for (const char* suffix : {"", "-wal", "-shm"}) {
+            std::remove((path + suffix).c_str());
+        }
+    }
+    db = new Database(PERF_DB_PATH);
+}
+
+// Test how fast a columnar archive of all the orders decodes in full, in MB of file per second
+TEST_F(PerfTest, ColumnarScanThroughputTest) {
+    ASSERT_TRUE(ColumnarArchive::write(PERF_DB_PATH, firstDay, lastDay, PERF_COLUMNAR_PATH));
+    {
+        ColumnarArchive archive;
+        ASSERT_TRUE(archive.open(PERF_COLUMNAR_PATH));
+        double revenue = 0.0;
+        auto scan = [&] {
+            revenue = 0.0;
+            archive.forEachOrder(firstDay, lastDay, [&](const Database::Order&, double price) { revenue += price; });
+        };
+        double scanMs = medianMs(3, scan);
+        double expected = db->getTotalRevenue(firstDay, lastDay);
+        ASSERT_NEAR(revenue, expected, 1e-6 * expected);
+
+        double mbPerSecond = archive.getFileSize() / 1e6 / (scanMs / 1000.0);
+        double budget = budgets["columnar_scan_min_mb_per_sec"];
+        std::cout << "ColumnarArchive full decode of " << archive.getOrderCount() << " orders: " << scanMs << " ms, "
+                  << mbPerSecond << " MB/s (budget >= " << budget << ")" << std::endl;
+        EXPECT_GE(mbPerSecond, budget) << "the columnar scan managed " << mbPerSecond << " MB/s, budget is " << budget;
+    }
+    std::remove(PERF_COLUMNAR_PATH.c_str());
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "../includes/database.h"
+#include "../includes/date_utils.h"
+#include "../includes/repricing_simulator.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+
+const std::string REPRICING_DB_PATH = "test_repricing_flower.db";
+
+class RepricingSimulatorTest : public ::testing::Test {
+protected:
+    Database* db;
+    int startDate;
+    int endDate;
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(REPRICING_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(REPRICING_DB_PATH);
+        db->connect();
+        parseDate("2025-01-01", startDate);
+        parseDate("2025-12-31", endDate);
+    }
+
+    void TearDown() override {
+        delete db;
+        std::remove(REPRICING_DB_PATH.c_str());
+    }
+
+    // Prices every order of the period through its recipe, as the pricing trigger does
+    double replayOrders(const RepricingSimulator& simulator, const std::vector<double>& prices) {
+        std::map<int, double> price;
+        for (size_t i = 0; i < prices.size(); i++) {
+            price[simulator.flowerIds()[i]] = prices[i];
+        }
+        std::map<int, double> unitCost;
+        for (const auto& line : db->getRecipeLines()) {
+            unitCost[line.compositionId] += line.quantity * price[line.flowerId];
+        }
+        double total = 0.0;
+        for (const auto& order : db->getOrdersByDateRange(startDate, endDate)) {
+            total += unitCost[order.compositionId] * order.quantity * (1.0 + order.urgencyRate);
+        }
+        return total;
+    }
+};
+
+// Test that current prices reproduce the recorded revenue of orders priced at them
+TEST_F(RepricingSimulatorTest, BaselineTest) {
+    // Orders entered now are priced at the current prices
+    int orderDate;
+    parseDate("2025-12-20", orderDate);
+    ASSERT_TRUE(db->createOrder(1, 1, orderDate, orderDate + 1, 3));
+    ASSERT_TRUE(db->createOrder(2, 2, orderDate, orderDate + 10, 2));
+
+    RepricingSimulator simulator(*db);
+    ASSERT_TRUE(simulator.load(orderDate, orderDate));
+    ASSERT_EQ(simulator.flowerIds().size(), db->getAllFlowers().size());
+
+    RepricingSimulator::Outcome baseline = simulator.baseline();
+    ASSERT_NEAR(baseline.totalRevenue, db->getTotalRevenue(orderDate, orderDate), 1e-6);
+    ASSERT_NEAR(baseline.baseRevenue + baseline.urgencyFees, baseline.totalRevenue, 1e-9);
+    ASSERT_GT(baseline.urgencyFees, 0.0);
+    ASSERT_TRUE(baseline.withinPriceRule);
+}
+
+// Test many scenarios against pricing every order one by one
+TEST_F(RepricingSimulatorTest, ScenariosTest) {
+    RepricingSimulator simulator(*db, 3);
+    ASSERT_TRUE(simulator.load(startDate, endDate));
+    ASSERT_GT(simulator.baseline().totalRevenue, 0.0);
+
+    std::vector<std::vector<double>> scenarios;
+    for (int s = 0; s < 50; s++) {
+        std::vector<double> prices = simulator.currentPrices();
+        for (size_t i = 0; i < prices.size(); i++) {
+            prices[i] *= 0.8 + 0.01 * ((s * 7 + i * 3) % 35);
+        }
+        scenarios.push_back(prices);
+    }
+
+    std::vector<RepricingSimulator::Outcome> outcomes;
+    ASSERT_TRUE(simulator.evaluate(scenarios, outcomes));
+    ASSERT_EQ(outcomes.size(), scenarios.size());
+    for (size_t s = 0; s < scenarios.size(); s++) {
+        ASSERT_NEAR(outcomes[s].totalRevenue, replayOrders(simulator, scenarios[s]), 1e-6);
+    }
+
+    // Doubling every price doubles revenue and breaks the 10% rule
+    std::vector<double> doubled = simulator.currentPrices();
+    for (double& price : doubled) {
+        price *= 2;
+    }
+    ASSERT_TRUE(simulator.evaluate({doubled}, outcomes));
+    ASSERT_NEAR(outcomes[0].totalRevenue, 2 * simulator.baseline().totalRevenue, 1e-6);
+    ASSERT_FALSE(outcomes[0].withinPriceRule);
+
+    ASSERT_FALSE(simulator.evaluate({std::vector<double>(1, 1.0)}, outcomes));
+}
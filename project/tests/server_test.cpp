@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include "../includes/server.h"
+#include "../includes/client.h"
+#include "../includes/date_utils.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+const std::string SERVER_DB_PATH = "server_test_flower.db";
+const std::string SERVER_SOCKET_PATH = "server_test.sock";
+
+class ServerTest : public ::testing::Test {
+protected:
+    Database* db;
+    Authentication* auth;
+    Server* server;
+    std::thread loop;
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(SERVER_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(SERVER_DB_PATH);
+        ASSERT_TRUE(db->connect());
+        PasswordHashParams params;
+        params.logN = 8;
+        auth = new Authentication(params);
+        server = new Server(*db, *auth, SERVER_SOCKET_PATH, 4);
+        ASSERT_TRUE(server->listen());
+        loop = std::thread([this] { server->run(); });
+    }
+
+    void TearDown() override {
+        server->stop();
+        loop.join();
+        delete server;
+        delete auth;
+        delete db;
+        std::remove(SERVER_DB_PATH.c_str());
+    }
+
+    static std::string status(const Message& response) {
+        return response[0][0];
+    }
+};
+
+// Test protocol encoding round trip, including empty and binary fields
+TEST(ProtocolTest, RoundTripTest) {
+    Message message = {{"CMD", "", std::string("a\0b", 3)}, {}, {std::string(300, 'x')}};
+    std::string buffer = encodeFrame(encodeMessage(message));
+
+    // Frames arrive in arbitrary pieces
+    std::string received = buffer.substr(0, 3);
+    std::string payload;
+    bool error = false;
+    ASSERT_FALSE(extractFrame(received, payload, error));
+    received += buffer.substr(3);
+    ASSERT_TRUE(extractFrame(received, payload, error));
+    ASSERT_TRUE(received.empty());
+
+    Message decoded;
+    ASSERT_TRUE(decodeMessage(payload, decoded));
+    ASSERT_EQ(decoded, message);
+    ASSERT_FALSE(decodeMessage(payload.substr(0, payload.size() - 1), decoded));
+}
+
+// Test that operations require a login with the matching permission
+TEST_F(ServerTest, LoginAndPermissionsTest) {
+    Client client(SERVER_SOCKET_PATH);
+    ASSERT_TRUE(client.connect());
+
+    Message response;
+    ASSERT_TRUE(client.call({"FLOWERS"}, response));
+    ASSERT_EQ(status(response), "ERR");
+
+    ASSERT_TRUE(client.call({"LOGIN", "user", "wrong"}, response));
+    ASSERT_EQ(status(response), "ERR");
+
+    ASSERT_TRUE(client.call({"LOGIN", "user", "user123"}, response));
+    ASSERT_EQ(status(response), "OK");
+    ASSERT_EQ(response[1][0], "user");
+
+    ASSERT_TRUE(client.call({"FLOWERS"}, response));
+    ASSERT_EQ(status(response), "OK");
+    ASSERT_GT(response.size(), 1);
+    ASSERT_EQ(response[1].size(), 4);
+
+    ASSERT_TRUE(client.call({"UPDATE_PRICE", "1", "151"}, response));
+    ASSERT_EQ(status(response), "ERR");
+
+    ASSERT_TRUE(client.call({"NO_SUCH_COMMAND"}, response));
+    ASSERT_EQ(status(response), "ERR");
+}
+
+// Test order entry and reports through the server
+TEST_F(ServerTest, CreateOrderAndReportTest) {
+    Client client(SERVER_SOCKET_PATH);
+    ASSERT_TRUE(client.connect());
+
+    Message response;
+    ASSERT_TRUE(client.call({"LOGIN", "admin", "admin123"}, response));
+    ASSERT_EQ(status(response), "OK");
+
+    int orderDate = 0, fulfillmentDate = 0;
+    parseDate("2025-08-01", orderDate);
+    parseDate("2025-08-05", fulfillmentDate);
+    std::string from = std::to_string(orderDate);
+    std::string to = std::to_string(fulfillmentDate);
+
+    ASSERT_TRUE(client.call({"REVENUE", from, to}, response));
+    ASSERT_EQ(response[1][0], "0");
+
+    ASSERT_TRUE(client.call({"CREATE_ORDER", "1", "1", from, to, "2"}, response));
+    ASSERT_EQ(status(response), "OK");
+
+    ASSERT_TRUE(client.call({"ORDERS_BY_DATE", from}, response));
+    ASSERT_EQ(response.size(), 2);
+    ASSERT_EQ(response[1][5], "2");
+
+    ASSERT_TRUE(client.call({"REVENUE", from, to}, response));
+    ASSERT_GT(std::stod(response[1][0]), 0.0);
+
+    ASSERT_TRUE(client.call({"REVENUE", from, "not-a-date"}, response));
+    ASSERT_EQ(status(response), "ERR");
+
+    // One row per day, including days without orders
+    ASSERT_TRUE(client.call({"REVENUE_SERIES", from, to, "day"}, response));
+    ASSERT_EQ(response.size(), 6);
+    ASSERT_EQ(response[1][0], from);
+    ASSERT_EQ(response[1][2], "1");
+    ASSERT_EQ(response[2][2], "0");
+    ASSERT_TRUE(client.call({"REVENUE_SERIES", from, to, "fortnight"}, response));
+    ASSERT_EQ(status(response), "ERR");
+}
+
+// Test many clients sharing the server concurrently
+TEST_F(ServerTest, ConcurrentClientsTest) {
+    const int clientCount = 8;
+    const int ordersPerClient = 20;
+    int orderDate = 0;
+    parseDate("2025-09-01", orderDate);
+
+    std::vector<std::thread> clients;
+    std::vector<int> failures(clientCount, 0);
+    for (int c = 0; c < clientCount; c++) {
+        clients.emplace_back([&, c] {
+            Client client(SERVER_SOCKET_PATH);
+            Message response;
+            if (!client.connect() || !client.call({"LOGIN", "admin", "admin123"}, response)) {
+                failures[c]++;
+                return;
+            }
+            for (int i = 0; i < ordersPerClient; i++) {
+                std::string day = std::to_string(orderDate);
+                if (!client.call({"CREATE_ORDER", "1", "2", day, std::to_string(orderDate + 3), "1"}, response) ||
+                    response[0][0] != "OK" ||
+                    !client.call({"REVENUE", day, day}, response) || response[0][0] != "OK") {
+                    failures[c]++;
+                }
+            }
+        });
+    }
+    for (auto& thread : clients) {
+        thread.join();
+    }
+
+    for (int c = 0; c < clientCount; c++) {
+        ASSERT_EQ(failures[c], 0);
+    }
+    ASSERT_EQ(db->getOrdersByDate(orderDate).size(), clientCount * ordersPerClient);
+}
+
+// Test that a client pipelining far more requests than the socket buffers hold gets every
+// response, in order, while the server only reads its input between requests
+TEST_F(ServerTest, PipelinedRequestsTest) {
+    const int requestCount = 50000;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, SERVER_SOCKET_PATH.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+    std::string frame = encodeFrame(encodeMessage({{"PING"}}));
+    std::thread sender([&] {
+        std::string requests;
+        for (int i = 0; i < requestCount; i++) {
+            requests += frame;
+        }
+        size_t sent = 0;
+        while (sent < requests.size()) {
+            ssize_t written = send(fd, requests.data() + sent, requests.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(written);
+        }
+    });
+
+    std::string input;
+    std::string payload;
+    bool error = false;
+    int responses = 0;
+    char buffer[16384];
+    while (responses < requestCount && !error) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        input.append(buffer, static_cast<size_t>(received));
+        Message response;
+        while (extractFrame(input, payload, error) && decodeMessage(payload, response) &&
+               status(response) == "OK") {
+            responses++;
+        }
+    }
+    sender.join();
+    close(fd);
+    ASSERT_FALSE(error);
+    ASSERT_EQ(responses, requestCount);
+}
+
+// Test that CREATE_ORDER goes through the journal when one is configured
+TEST_F(ServerTest, JournaledCreateOrderTest) {
+    const std::string journalPath = "server_test.journal";
+    std::remove(journalPath.c_str());
+    OrderJournal journal(journalPath, SERVER_DB_PATH);
+    ASSERT_TRUE(journal.open());
+    server->setOrderJournal(&journal);
+
+    Client client(SERVER_SOCKET_PATH);
+    ASSERT_TRUE(client.connect());
+    Message response;
+    ASSERT_TRUE(client.call({"LOGIN", "admin", "admin123"}, response));
+
+    int date = 0;
+    parseDate("2025-08-20", date);
+    std::string from = std::to_string(date);
+    std::string to = std::to_string(date + 2);
+    ASSERT_TRUE(client.call({"CREATE_ORDER", "1", "1", from, to, "2"}, response));
+    ASSERT_EQ(status(response), "OK");
+    ASSERT_TRUE(client.call({"CREATE_ORDER", "1", "1", to, from, "2"}, response));
+    ASSERT_EQ(status(response), "ERR");
+
+    journal.waitUntilApplied();
+    ASSERT_TRUE(client.call({"ORDERS_BY_DATE", from}, response));
+    ASSERT_EQ(response.size(), 2);
+
+    server->setOrderJournal(nullptr);
+    journal.close();
+    std::remove(journalPath.c_str());
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "../includes/authentication.h"
+#include "../includes/date_utils.h"
+#include "../includes/session_replay.h"
+#include "../includes/ui.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+const std::string REPLAY_DB_PATH = "test_replay_flower.db";
+const std::string REPLAY_SCRIPT_PATH = "test_replay_script.txt";
+
+// Admin logs in, lists the orders of a day, enters an order and lists the day again
+static const char* ORDER_ENTRY_INPUT =
+    "admin\nadmin123\n"
+    "6\n2025-04-02\n\n"
+    "1\n1\n1\n2025-04-02\n2025-04-05\n1\n\n"
+    "2\n2025-04-02\n\n"
+    "8\n0\n";
+
+class SessionReplayTest : public ::testing::Test {
+protected:
+    Database* db;
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(REPLAY_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+
+        db = new Database(REPLAY_DB_PATH);
+        db->connect();
+    }
+
+    void TearDown() override {
+        delete db;
+        std::remove(REPLAY_DB_PATH.c_str());
+        std::remove(REPLAY_SCRIPT_PATH.c_str());
+    }
+
+    static int day(const std::string& text) {
+        int days = 0;
+        parseDate(text, days);
+        return days;
+    }
+};
+
+// Test that a recorded session holds every input line with the password masked
+TEST_F(SessionReplayTest, RecordTest) {
+    PasswordHashParams params;
+    params.logN = 8;
+    Authentication auth(params);
+    std::istringstream in(ORDER_ENTRY_INPUT);
+    std::ostringstream out;
+    std::ofstream script(REPLAY_SCRIPT_PATH);
+
+    UI ui(*db, auth, in, out);
+    ui.recordTo(&script);
+    ui.start();
+    script.close();
+
+    ASSERT_NE(out.str().find("Order created successfully!"), std::string::npos);
+    ASSERT_NE(out.str().find("Goodbye!"), std::string::npos);
+    ASSERT_TRUE(db->isConnected());
+
+    ReplayScript recorded;
+    ASSERT_TRUE(loadReplayScript(REPLAY_SCRIPT_PATH, recorded));
+    ASSERT_EQ(recorded.lines.size(), 17u);
+    ASSERT_EQ(recorded.lines[0], "admin");
+    ASSERT_EQ(recorded.lines[1], UI::SECRET_LINE);
+    ASSERT_EQ(std::count(recorded.lines.begin(), recorded.lines.end(), "admin123"), 0);
+    ASSERT_EQ(recorded.lines.back(), "0");
+}
+
+// Test that a session ends cleanly when its input runs out mid-screen
+TEST_F(SessionReplayTest, InputRunsOutTest) {
+    PasswordHashParams params;
+    params.logN = 8;
+    Authentication auth(params);
+    std::istringstream in("admin\nadmin123\n6\n");
+    std::ostringstream out;
+
+    UI ui(*db, auth, in, out);
+    ui.start();
+    ASSERT_NE(out.str().find("ORDERS BY DATE"), std::string::npos);
+}
+
+// Test concurrent replay of a recorded script against one database
+TEST_F(SessionReplayTest, ReplayTest) {
+    {
+        std::ofstream script(REPLAY_SCRIPT_PATH);
+        std::string input = ORDER_ENTRY_INPUT;
+        script << input.replace(input.find("admin123"), 8, UI::SECRET_LINE);
+    }
+    ReplayScript script;
+    ASSERT_TRUE(loadReplayScript(REPLAY_SCRIPT_PATH, script));
+
+    size_t before = db->getOrdersByDate(day("2025-04-02")).size();
+
+    SessionReplay::Options options;
+    options.sessions = 6;
+    options.concurrency = 3;
+    options.hashParams.logN = 8;
+    SessionReplay replay(*db, {script}, options);
+    SessionReplay::Report report = replay.run();
+
+    ASSERT_EQ(report.sessions, 6u);
+    ASSERT_EQ(report.inputs, 6 * script.lines.size());
+    ASSERT_GT(report.sessionsPerSecond(), 0.0);
+    ASSERT_EQ(db->getOrdersByDate(day("2025-04-02")).size(), before + 6);
+
+    auto screen = [&](const std::string& name) {
+        return std::find_if(report.screens.begin(), report.screens.end(),
+                            [&](const SessionReplay::ScreenStats& stats) { return stats.screen == name; });
+    };
+    ASSERT_NE(screen("createNewOrder"), report.screens.end());
+    ASSERT_NE(screen("displayOrdersByDate"), report.screens.end());
+    ASSERT_NE(screen("showLoginScreen"), report.screens.end());
+    // Two date lookups per session, each answered once with the list and once after "Press Enter"
+    ASSERT_EQ(screen("displayOrdersByDate")->count, 6u * 4);
+    ASSERT_LE(screen("createNewOrder")->p50Ms, screen("createNewOrder")->maxMs);
+
+    std::ostringstream printed;
+    SessionReplay::printReport(report, printed);
+    ASSERT_NE(printed.str().find("createNewOrder"), std::string::npos);
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "../includes/database.h"
+#include "../includes/demand_planner.h"
+#include "../includes/date_utils.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-threaded tests of the Database thread-safety contract. They are meant to be run
+// under ThreadSanitizer as well (configure with -DFLOWER_SHOP_TSAN=ON). Worker threads
+// only count failures; assertions run on the main thread.
+
+const std::string STRESS_DB_PATH = "stress_test_flower.db";
+const int STRESS_THREADS = 8;
+const int STRESS_ITERATIONS = 60;
+
+class StressTest : public ::testing::Test {
+protected:
+    int firstDay = 0;
+
+    void SetUp() override {
+        std::ifstream src("flower.db", std::ios::binary);
+        std::ofstream dst(STRESS_DB_PATH, std::ios::binary);
+        dst << src.rdbuf();
+        dst.close();
+        parseDate("2026-01-01", firstDay);
+    }
+
+    void TearDown() override {
+        std::remove(STRESS_DB_PATH.c_str());
+        std::remove((STRESS_DB_PATH + "-wal").c_str());
+        std::remove((STRESS_DB_PATH + "-shm").c_str());
+    }
+
+    // Commits are not what is being tested here
+    static DatabaseOptions fastOptions() {
+        DatabaseOptions options;
+        options.journalMode = "WAL";
+        options.synchronous = "OFF";
+        options.busyTimeoutMs = 10000;
+        return options;
+    }
+
+    // Runs one worker per thread and waits for all of them
+    static void runWorkers(const std::function<void(int)>& worker) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < STRESS_THREADS; t++) {
+            threads.emplace_back(worker, t);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+};
+
+// Test one Database shared by threads mixing writes and cached/snapshot reports
+TEST_F(StressTest, SharedDatabaseTest) {
+    Database db(STRESS_DB_PATH, fastOptions());
+    ASSERT_TRUE(db.connect());
+    ASSERT_TRUE(db.enableReportSnapshot(3600, 25));
+    DemandPlanner planner(db, 2);
+    ASSERT_TRUE(planner.rebuild(firstDay));
+    int lastDay = firstDay + STRESS_ITERATIONS;
+    std::vector<Database::Flower> flowers = db.getAllFlowers();
+
+    std::atomic<int> failures(0);
+    std::atomic<int> created(0);
+    runWorkers([&](int thread) {
+        for (int i = 0; i < STRESS_ITERATIONS; i++) {
+            switch ((thread + i) % 4) {
+                case 0:
+                    if (db.createOrder(1 + thread % 5, 1 + i % 5, firstDay + i, firstDay + i + 1, 1)) {
+                        created++;
+                    } else {
+                        failures++;
+                    }
+                    break;
+                case 1:
+                    // Stays within the 10% increase limit whatever the order of updates
+                    if (!db.updateFlowerPrice(flowers[i % flowers.size()].id,
+                                              flowers[i % flowers.size()].price * (1.0 + 0.01 * (thread % 5)))) {
+                        failures++;
+                    }
+                    break;
+                case 2:
+                    if (db.getTotalRevenue(firstDay, lastDay) < 0.0 ||
+                        db.getRevenueSeries(firstDay, lastDay, Database::Granularity::Week).empty()) {
+                        failures++;
+                    }
+                    break;
+                case 3:
+                    if (db.getCustomerById(1 + i % 5).id == 0 || db.getFlowerTable().rows.empty()) {
+                        failures++;
+                    }
+                    db.getFlowerUsageTable(firstDay, lastDay);
+                    planner.getDemand(firstDay, lastDay);
+                    break;
+            }
+        }
+    });
+
+    ASSERT_EQ(failures, 0);
+    db.disableReportSnapshot();
+    ASSERT_EQ(db.getOrdersByDateRange(firstDay, lastDay).size(), created);
+
+    long long stems = 0;
+    for (const auto& entry : planner.getDemand(firstDay, lastDay + 1)) {
+        stems += entry.second;
+    }
+    DemandPlanner rebuilt(db, 2);
+    ASSERT_TRUE(rebuilt.rebuild(firstDay));
+    ASSERT_EQ(rebuilt.getDemand(firstDay, lastDay + 1), planner.getDemand(firstDay, lastDay + 1));
+    ASSERT_GT(stems, 0);
+}
+
+// Test one Database per thread, each with its own connection to the same file
+TEST_F(StressTest, ConnectionPerThreadTest) {
+    std::atomic<int> failures(0);
+    std::atomic<int> created(0);
+    int lastDay = firstDay + STRESS_ITERATIONS;
+
+    runWorkers([&](int thread) {
+        Database db(STRESS_DB_PATH, fastOptions());
+        if (!db.connect()) {
+            failures++;
+            return;
+        }
+        for (int i = 0; i < STRESS_ITERATIONS; i++) {
+            if (i % 3 == 0) {
+                if (db.createOrder(1 + thread % 5, 1 + i % 5, firstDay + i, firstDay + i + 2, 2)) {
+                    created++;
+                } else {
+                    failures++;
+                }
+            } else if (db.getCompositionSalesSummary().empty() || db.getOrdersByUrgency().empty()) {
+                failures++;
+            }
+        }
+    });
+
+    ASSERT_EQ(failures, 0);
+    Database db(STRESS_DB_PATH, fastOptions());
+    ASSERT_TRUE(db.connect());
+    ASSERT_EQ(db.getOrdersByDateRange(firstDay, lastDay).size(), created);
+}
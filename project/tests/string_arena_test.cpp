@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include "../includes/string_arena.h"
+#include <string>
+
+// Test that stored strings keep their contents as the arena grows
+TEST(StringArenaTest, StoreTest) {
+    StringArena arena(64);
+    std::vector<std::string_view> views;
+    for (int i = 0; i < 100; i++) {
+        views.push_back(arena.store("value " + std::to_string(i)));
+    }
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(views[i], "value " + std::to_string(i));
+    }
+    ASSERT_GT(arena.blockCount(), 1);
+    ASSERT_TRUE(arena.store("").empty());
+
+    // Oversized strings get their own block without disturbing the current one
+    std::string_view big = arena.store(std::string(1000, 'x'));
+    std::string_view small = arena.store("after");
+    ASSERT_EQ(big, std::string(1000, 'x'));
+    ASSERT_EQ(small, "after");
+}
+
+// Test that interning returns one copy per distinct string
+TEST(StringArenaTest, InternTest) {
+    StringArena arena;
+    std::string_view first = arena.intern("Роза");
+    std::string_view second = arena.intern(std::string("Роза"));
+    std::string_view other = arena.intern("Лилия");
+
+    ASSERT_EQ(first.data(), second.data());
+    ASSERT_NE(first.data(), other.data());
+    ASSERT_EQ(arena.bytesUsed(), first.size() + other.size());
+}